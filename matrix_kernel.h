@@ -0,0 +1,161 @@
+// 寄存器面板行内核：C的一行在一个64列面板上的部分结果
+//   c_row[0..ncols) (+)= Σ_{k < kc} a_row[k * a_cs] x b[k * ldb + 0..ncols)
+// 64个累加值全程保存在8个AVX2寄存器中，C在每次调用中只读写一次；ncols < 64 时用掩码只读写有效的列，
+// 也不会读取B中有效列之外的内存。b可以是打包好的连续面板（ldb = MM_KERNEL_NR），也可以直接指向行主序的B。
+//
+//   mm_row_kernel_i32 - int32（乘加按2^32回绕）
+//   mm_row_kernel_i16 - B为int16面板，加载时符号扩展为int32；b必须有完整的64列（打包面板末尾用0填充）
+//   mm_row_kernel_f32 - float32，FMA累加（需要 -mfma）
+//   mm_gemm_i32       - 单线程驱动：按k分块、按面板调用行内核，B不打包
+//
+// first非0时覆盖C，否则累加到C上；stream非0且面板满64列时用非临时存储写回C（c_row需要32字节对齐）。
+#ifndef MATRIX_KERNEL_H
+#define MATRIX_KERNEL_H
+
+#include <stddef.h>
+#include <immintrin.h>
+
+#define MM_KERNEL_NR 64    // 面板宽度（列数），对应8个AVX2寄存器
+#define MM_KERNEL_KC 256   // mm_gemm_i32在k方向的分块大小，使B的面板块驻留在L2 cache中
+
+static inline void mm_kernel_masks(int ncols, __m256i mask[8]) {
+    __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    #pragma GCC unroll 8
+    for (int v = 0; v < 8; v++) {
+        mask[v] = _mm256_cmpgt_epi32(_mm256_set1_epi32(ncols - v * 8), lane);
+    }
+}
+
+static inline void mm_kernel_load_c_i32(const int *c_row, int ncols, int first, const __m256i mask[8], __m256i acc[8]) {
+    #pragma GCC unroll 8
+    for (int v = 0; v < 8; v++) {
+        if (first) {
+            acc[v] = _mm256_setzero_si256();
+        } else if (ncols == MM_KERNEL_NR) {
+            acc[v] = _mm256_loadu_si256((const __m256i*)&c_row[v * 8]);
+        } else {
+            acc[v] = _mm256_maskload_epi32(&c_row[v * 8], mask[v]);
+        }
+    }
+}
+
+static inline void mm_kernel_store_c_i32(int *c_row, int ncols, int stream, const __m256i mask[8], const __m256i acc[8]) {
+    #pragma GCC unroll 8
+    for (int v = 0; v < 8; v++) {
+        if (ncols < MM_KERNEL_NR) {
+            _mm256_maskstore_epi32(&c_row[v * 8], mask[v], acc[v]);
+        } else if (stream) {
+            _mm256_stream_si256((__m256i*)&c_row[v * 8], acc[v]);
+        } else {
+            _mm256_storeu_si256((__m256i*)&c_row[v * 8], acc[v]);
+        }
+    }
+}
+
+static inline void mm_row_kernel_i32(const int *a_row, long long a_cs, const int *b, long long ldb, int kc,
+                                     int *c_row, int ncols, int first, int stream) {
+    __m256i acc[8];
+    __m256i mask[8];
+    mm_kernel_masks(ncols, mask);
+    mm_kernel_load_c_i32(c_row, ncols, first, mask, acc);
+
+    if (ncols == MM_KERNEL_NR) {
+        for (int k = 0; k < kc; k++) {
+            __m256i a = _mm256_set1_epi32(a_row[k * a_cs]);
+            const int *row = b + k * ldb;
+            #pragma GCC unroll 8
+            for (int v = 0; v < 8; v++) {
+                acc[v] = _mm256_add_epi32(acc[v], _mm256_mullo_epi32(a, _mm256_loadu_si256((const __m256i*)(row + v * 8))));
+            }
+        }
+    } else {
+        for (int k = 0; k < kc; k++) {
+            __m256i a = _mm256_set1_epi32(a_row[k * a_cs]);
+            const int *row = b + k * ldb;
+            #pragma GCC unroll 8
+            for (int v = 0; v < 8; v++) {
+                acc[v] = _mm256_add_epi32(acc[v], _mm256_mullo_epi32(a, _mm256_maskload_epi32(row + v * 8, mask[v])));
+            }
+        }
+    }
+
+    mm_kernel_store_c_i32(c_row, ncols, stream, mask, acc);
+}
+
+static inline void mm_row_kernel_i16(const int *a_row, long long a_cs, const short *b, long long ldb, int kc,
+                                     int *c_row, int ncols, int first, int stream) {
+    __m256i acc[8];
+    __m256i mask[8];
+    mm_kernel_masks(ncols, mask);
+    mm_kernel_load_c_i32(c_row, ncols, first, mask, acc);
+
+    for (int k = 0; k < kc; k++) {
+        __m256i a = _mm256_set1_epi32(a_row[k * a_cs]);
+        const __m128i *row = (const __m128i*)(b + k * ldb);
+        #pragma GCC unroll 8
+        for (int v = 0; v < 8; v++) {
+            acc[v] = _mm256_add_epi32(acc[v], _mm256_mullo_epi32(a, _mm256_cvtepi16_epi32(_mm_loadu_si128(row + v))));
+        }
+    }
+
+    mm_kernel_store_c_i32(c_row, ncols, stream, mask, acc);
+}
+
+#ifdef __FMA__
+static inline void mm_row_kernel_f32(const float *a_row, long long a_cs, const float *b, long long ldb, int kc,
+                                     float *c_row, int ncols, int first) {
+    __m256 acc[8];
+    __m256i mask[8];
+    mm_kernel_masks(ncols, mask);
+
+    #pragma GCC unroll 8
+    for (int v = 0; v < 8; v++) {
+        acc[v] = first ? _mm256_setzero_ps() : _mm256_maskload_ps(&c_row[v * 8], mask[v]);
+    }
+
+    if (ncols == MM_KERNEL_NR) {
+        for (int k = 0; k < kc; k++) {
+            __m256 a = _mm256_set1_ps(a_row[k * a_cs]);
+            const float *row = b + k * ldb;
+            #pragma GCC unroll 8
+            for (int v = 0; v < 8; v++) {
+                acc[v] = _mm256_fmadd_ps(a, _mm256_loadu_ps(row + v * 8), acc[v]);
+            }
+        }
+    } else {
+        for (int k = 0; k < kc; k++) {
+            __m256 a = _mm256_set1_ps(a_row[k * a_cs]);
+            const float *row = b + k * ldb;
+            #pragma GCC unroll 8
+            for (int v = 0; v < 8; v++) {
+                acc[v] = _mm256_fmadd_ps(a, _mm256_maskload_ps(row + v * 8, mask[v]), acc[v]);
+            }
+        }
+    }
+
+    #pragma GCC unroll 8
+    for (int v = 0; v < 8; v++) {
+        _mm256_maskstore_ps(&c_row[v * 8], mask[v], acc[v]);
+    }
+}
+#endif
+
+// C[m x n] (+)= A[m x k] x B[k x n]（int32，单线程，B不打包）。K == 0 且覆盖模式时把C清零
+static inline void mm_gemm_i32(int m, int n, int k, const int *A, long long lda, const int *B, long long ldb,
+                               int *C, long long ldc, int accumulate) {
+    int kk = 0;
+    do {
+        int kc = (k - kk < MM_KERNEL_KC) ? k - kk : MM_KERNEL_KC;
+        int first = (kk == 0) && !accumulate;
+        for (int jj = 0; jj < n; jj += MM_KERNEL_NR) {
+            int ncols = (n - jj < MM_KERNEL_NR) ? n - jj : MM_KERNEL_NR;
+            for (int i = 0; i < m; i++) {
+                mm_row_kernel_i32(A + i * lda + kk, 1, B + kk * ldb + jj, ldb, kc,
+                                  C + i * ldc + jj, ncols, first, 0);
+            }
+        }
+        kk += MM_KERNEL_KC;
+    } while (kk < k);
+}
+
+#endif // MATRIX_KERNEL_H
@@ -0,0 +1,86 @@
+// 矩阵内存布局：整个矩阵在一块连续的对齐内存中分配，行指针数组指向其中各行，
+// 相邻两行的间距（leading dimension，以元素为单位）由分配器自动选择。
+//
+// 当行的字节数是较大的2的幂（如N = 1024、2048、4096）时，同一列的元素在每一行中
+// 都映射到相同的cache组，沿列访问（基础版本读取B的一列、转置版本写入B_T的一列、
+// 分块版本在块内逐行访问）只能使用cache的一小部分，性能会急剧下降。
+// 分配器在这种情况下给每行多留一个cache行的填充，使相邻行落在不同的cache组中。
+//
+// 关闭填充：设置环境变量 MATRIX_NO_PADDING=1，或调用各版本导出的 matrix_set_padding(0)。
+#ifndef MATRIX_LAYOUT_H
+#define MATRIX_LAYOUT_H
+
+#include <stdlib.h>
+#include "matrix_platform.h"
+
+// 输出写入模式（各版本的 *_ex 接口共用）：
+//   MM_OVERWRITE  - 默认，覆盖C（在第一次写入时初始化，无需单独的清零遍历）
+//   MM_ACCUMULATE - 在已有的C上累加（C += A*B）
+//   MM_STREAM     - 最后一次写回C时使用非临时(streaming)存储，绕过cache，避免大矩阵的输出把A/B的工作集
+//                   挤出cache。只有写回整个向量的SIMD路径使用，其他版本忽略这一位
+#define MM_OVERWRITE  0
+#define MM_ACCUMULATE 1
+#define MM_STREAM     2
+
+#define MM_CACHE_LINE     64    // cache行大小（字节）
+#define MM_ALIAS_STRIDE   512   // 行间距是它的整数倍时认为会发生cache组冲突（字节）
+
+// 填充开关：-1表示尚未读取环境变量
+static int mm_padding_enabled = -1;
+
+static inline int mm_padding_on(void) {
+    if (mm_padding_enabled < 0) {
+        const char *env = getenv("MATRIX_NO_PADDING");
+        mm_padding_enabled = !(env != NULL && env[0] != '\0' && env[0] != '0');
+    }
+    return mm_padding_enabled;
+}
+
+// 开启/关闭行间距填充（只影响之后创建的矩阵）。各版本导出的matrix_set_padding都调用它
+static inline void mm_set_padding(int enabled) {
+    mm_padding_enabled = enabled ? 1 : 0;
+}
+
+// 为N列、每个元素elem_size字节的矩阵选择行间距（元素个数）：
+// 先按cache行对齐，若行的字节数是MM_ALIAS_STRIDE的整数倍，再多加一个cache行
+static inline int mm_leading_dim(int N, int elem_size) {
+    if (!mm_padding_on()) {
+        return N;
+    }
+    int per_line = MM_CACHE_LINE / elem_size;
+    int ld = (N + per_line - 1) / per_line * per_line;
+    if (((long long)ld * elem_size) % MM_ALIAS_STRIDE == 0) {
+        ld += per_line;
+    }
+    return ld;
+}
+
+// 分配rows x cols的int矩阵，返回行指针数组（各行首地址都按cache行对齐，填充部分清零）
+static inline int** mm_alloc_matrix(int rows, int cols) {
+    int ld = mm_leading_dim(cols, sizeof(int));
+    int **matrix = (int**)malloc((rows > 0 ? rows : 1) * sizeof(int*));
+    int *data = (int*)mm_aligned_malloc((size_t)rows * ld * sizeof(int), MM_CACHE_LINE);
+
+    // matrix[0]始终指向整块内存（rows == 0 时也一样），释放时使用
+    matrix[0] = data;
+    for (int i = 0; i < rows; i++) {
+        matrix[i] = data + (size_t)i * ld;
+        for (int j = cols; j < ld; j++) {
+            matrix[i][j] = 0;
+        }
+    }
+    return matrix;
+}
+
+// 释放mm_alloc_matrix分配的矩阵
+static inline void mm_free_matrix(int **matrix) {
+    mm_aligned_free(matrix[0]);
+    free(matrix);
+}
+
+// mm_alloc_matrix分配的N x N矩阵的行间距（元素个数），用于检查填充是否生效
+static inline int mm_matrix_leading_dim(int **matrix, int N) {
+    return N > 1 ? (int)(matrix[1] - matrix[0]) : N;
+}
+
+#endif // MATRIX_LAYOUT_H
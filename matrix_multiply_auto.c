@@ -0,0 +1,657 @@
+#define _POSIX_C_SOURCE 200809L  // clock_gettime
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <string.h>
+#include <immintrin.h>
+#include "matrix_platform.h"
+#include "matrix_layout.h"
+#include "matrix_kernel.h"
+
+// 自动选择的矩阵乘法入口：C[M x N] (+)= A[M x K] x B[K x N]，根据形状、元素类型和本机能力
+// 选择算法、线程数和k方向的分块大小。最优选择随问题规模变化很大：32x32的乘法创建线程比计算本身还慢，
+// 4096x4096则需要打包B、多线程和分块。
+//
+// 候选算法：
+//   MM_AUTO_SCALAR - 标量i-k-j三重循环，没有任何准备开销，适合极小的矩阵（也是不支持AVX2时的退路）
+//   MM_AUTO_SIMD   - 寄存器面板内核直接读取B的行（64列x8个ymm累加器），不需要打包
+//   MM_AUTO_PACKED - 先把B打包为连续的列面板再使用同一内核，打包开销换来连续、对齐的访存
+// 代价模型：时间 = 运算量 / (单线程速率 x 并行加速) + 线程创建开销 + 打包开销。
+// 单线程速率、打包速率、每个线程的创建开销和并行效率由一次性的校准基准测得，
+// 默认只保存在进程内；设置环境变量 MATRIX_AUTO_CALIBRATION 为文件路径时保存到该文件，之后的进程直接读取。
+// 文件按CPU型号（CPUID的处理器签名和品牌字符串）和核心数匹配，换了机器会重新校准；
+// 同一台机器上不同编译方式（普通 / LTO / PGO）的库速率不同，应各自使用不同的文件。
+//
+// 调试用的环境变量（覆盖代价模型的选择）：
+//   MATRIX_AUTO_ALGO=scalar|simd|packed   MATRIX_AUTO_THREADS=n   MATRIX_AUTO_KC=n
+//   MATRIX_AUTO_VERBOSE=1  打印每次调用的选择和预测时间
+
+// 元素类型
+#define MM_INT32   0
+#define MM_FLOAT32 1
+
+// 算法
+#define MM_AUTO_SCALAR 0
+#define MM_AUTO_SIMD   1
+#define MM_AUTO_PACKED 2
+#define MM_AUTO_ALGOS  3
+
+#define AUTO_NR          MM_KERNEL_NR   // 面板宽度（列数），与共享行内核一致
+#define AUTO_KC          MM_KERNEL_KC   // 默认的k方向分块大小，使面板块(AUTO_KC x AUTO_NR)驻留在L2 cache中
+#define AUTO_MAX_THREADS 8              // 与其他多线程版本相同的线程数上限
+#define AUTO_CACHE_BYTES (512 * 1024)   // B超过这个大小时，不打包的版本按从内存流式读取的速率估计
+
+// 执行计划
+typedef struct {
+    int algo;
+    int threads;
+    int kc;
+    double predicted_seconds;   // 代价模型预测的时间
+} MMAutoPlan;
+
+// 校准结果
+typedef struct {
+    int calibrated;
+    int cpus;
+    unsigned cpu_signature;          // auto_cpu_signature()，保存的结果只在同一型号的CPU上使用
+    double rate[MM_AUTO_ALGOS][2];   // 单线程速率（次运算/秒），[算法][元素类型]
+    double simd_streamed[2];         // B不在cache中时不打包版本的单线程速率
+    double pack_rate;                // 打包速率（元素/秒）
+    double thread_cost;              // 每个线程的创建和等待开销（秒）
+    double parallel_eff;             // 每增加一个线程带来的加速（1表示线性加速）
+} AutoCalibration;
+
+// 进程内共享的校准结果，由auto_cal_lock保护：第一次使用时校准（多个线程同时第一次调用时只有一个运行基准，
+// 其余等待结果），读取时复制一份，避免与matrix_auto_calibrate(1)重新校准同时发生时读到不完整的结果
+static AutoCalibration auto_cal;
+static mm_mutex_t auto_cal_lock = MM_MUTEX_INIT;
+
+static const char *auto_algo_names[MM_AUTO_ALGOS] = {"scalar", "simd", "packed"};
+
+// 墙上时间（秒）
+static double auto_wall_time() {
+#ifdef _WIN32
+    LARGE_INTEGER freq, counter;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+}
+
+// ==================== 计算内核 ====================
+
+// 把B打包为连续的列面板：第p个面板的第k行位于 (p * K + k) * AUTO_NR 处，不足AUTO_NR的列用0填充
+static int* auto_pack_B(int K, int N, const int *B, long long ldb) {
+    int num_panels = (N + AUTO_NR - 1) / AUTO_NR;
+    int *packed = (int*)mm_aligned_malloc((size_t)num_panels * K * AUTO_NR * sizeof(int), 32);
+
+    for (int p = 0; p < num_panels; p++) {
+        int jj = p * AUTO_NR;
+        int width = (N - jj < AUTO_NR) ? N - jj : AUTO_NR;
+        for (int k = 0; k < K; k++) {
+            int *dst = packed + ((size_t)p * K + k) * AUTO_NR;
+            memcpy(dst, B + k * ldb + jj, width * sizeof(int));
+            for (int j = width; j < AUTO_NR; j++) {
+                dst[j] = 0;
+            }
+        }
+    }
+    return packed;
+}
+
+// 线程参数结构体
+typedef struct {
+    int N, K;
+    int dtype;
+    int algo;
+    int kc;
+    const int *A;
+    long long lda;
+    const int *B;
+    long long ldb;
+    const int *packedB;
+    int *C;
+    long long ldc;
+    int start_row;
+    int end_row;
+    int flags;
+} AutoThreadParams;
+
+// 标量i-k-j三重循环
+static void auto_scalar_rows(AutoThreadParams *params) {
+    int N = params->N, K = params->K;
+    int accumulate = params->flags & MM_ACCUMULATE;
+
+    for (int i = params->start_row; i < params->end_row; i++) {
+        if (params->dtype == MM_FLOAT32) {
+            float *c_row = (float*)params->C + i * params->ldc;
+            const float *a_row = (const float*)params->A + i * params->lda;
+            if (!accumulate) memset(c_row, 0, N * sizeof(float));
+            for (int k = 0; k < K; k++) {
+                float a = a_row[k];
+                const float *b_row = (const float*)params->B + k * params->ldb;
+                for (int j = 0; j < N; j++) {
+                    c_row[j] += a * b_row[j];
+                }
+            }
+        } else {
+            int *c_row = params->C + i * params->ldc;
+            const int *a_row = params->A + i * params->lda;
+            if (!accumulate) memset(c_row, 0, N * sizeof(int));
+            for (int k = 0; k < K; k++) {
+                int a = a_row[k];
+                const int *b_row = params->B + k * params->ldb;
+                for (int j = 0; j < N; j++) {
+                    c_row[j] += a * b_row[j];
+                }
+            }
+        }
+    }
+}
+
+MM_THREAD_FUNC auto_thread_function(void* arg) {
+    AutoThreadParams* params = (AutoThreadParams*)arg;
+    int N = params->N, K = params->K;
+    int accumulate = params->flags & MM_ACCUMULATE;
+
+    if (params->algo == MM_AUTO_SCALAR) {
+        auto_scalar_rows(params);
+        return MM_THREAD_RETURN;
+    }
+
+    // K == 0 时也要执行一轮，以便在覆盖模式下把C清零
+    int kk = 0;
+    do {
+        int kc = (K - kk < params->kc) ? K - kk : params->kc;
+        int first = (kk == 0) && !accumulate;
+
+        for (int jj = 0; jj < N; jj += AUTO_NR) {
+            int ncols = (N - jj < AUTO_NR) ? N - jj : AUTO_NR;
+            const int *b;
+            long long ldb;
+            if (params->packedB != NULL) {
+                b = params->packedB + ((size_t)(jj / AUTO_NR) * K + kk) * AUTO_NR;
+                ldb = AUTO_NR;
+            } else {
+                b = params->B + kk * params->ldb + jj;
+                ldb = params->ldb;
+            }
+
+            for (int i = params->start_row; i < params->end_row; i++) {
+                const int *a_row = params->A + i * params->lda + kk;
+                int *c_row = params->C + i * params->ldc + jj;
+                if (params->dtype == MM_FLOAT32) {
+                    mm_row_kernel_f32((const float*)a_row, 1, (const float*)b, ldb, kc, (float*)c_row, ncols, first);
+                } else {
+                    mm_row_kernel_i32(a_row, 1, b, ldb, kc, c_row, ncols, first, 0);
+                }
+            }
+        }
+
+        kk += params->kc;
+    } while (kk < K);
+
+    return MM_THREAD_RETURN;
+}
+
+// 按给定的计划执行（不经过代价模型），计划中的线程数会被限制在[1, M]之内
+void matrixmultiply_auto_run(const MMAutoPlan *plan, int M, int N, int K, int dtype,
+                             const void *A, long long lda, const void *B, long long ldb,
+                             void *C, long long ldc, int flags) {
+    if (M <= 0 || N <= 0) {
+        return;
+    }
+
+    int num_threads = plan->threads;
+    if (num_threads > M) num_threads = M;
+    if (num_threads < 1) num_threads = 1;
+
+    int *packedB = NULL;
+    if (plan->algo == MM_AUTO_PACKED && K > 0) {
+        packedB = auto_pack_B(K, N, (const int*)B, ldb);
+    }
+
+    mm_thread_t* threads = (mm_thread_t*)malloc(num_threads * sizeof(mm_thread_t));
+    AutoThreadParams* params = (AutoThreadParams*)malloc(num_threads * sizeof(AutoThreadParams));
+
+    for (int t = 0; t < num_threads; t++) {
+        params[t].N = N;
+        params[t].K = K;
+        params[t].dtype = dtype;
+        params[t].algo = plan->algo;
+        params[t].kc = plan->kc > 0 ? plan->kc : AUTO_KC;
+        params[t].A = (const int*)A;
+        params[t].lda = lda;
+        params[t].B = (const int*)B;
+        params[t].ldb = ldb;
+        params[t].packedB = packedB;
+        params[t].C = (int*)C;
+        params[t].ldc = ldc;
+        // 行均匀分给各线程（相差不超过一行），与代价模型中最慢线程的行数一致
+        params[t].start_row = (int)((long long)M * t / num_threads);
+        params[t].end_row = (int)((long long)M * (t + 1) / num_threads);
+        params[t].flags = flags;
+    }
+
+    if (num_threads == 1) {
+        // 单线程时直接在调用线程中计算，避免创建线程的开销
+        auto_thread_function(&params[0]);
+    } else {
+        for (int t = 0; t < num_threads; t++) {
+            mm_thread_create(&threads[t], auto_thread_function, &params[t]);
+        }
+        mm_thread_join_all(threads, num_threads);
+    }
+
+    free(threads);
+    free(params);
+    if (packedB != NULL) {
+        mm_aligned_free(packedB);
+    }
+}
+
+// ==================== 校准 ====================
+
+// 保存校准结果的文件：只有设置了MATRIX_AUTO_CALIBRATION时才读写文件，不在调用者的当前目录中留下文件
+static const char* auto_calibration_path() {
+    const char *env = getenv("MATRIX_AUTO_CALIBRATION");
+    return (env != NULL && env[0] != '\0') ? env : NULL;
+}
+
+// CPU型号的签名：CPUID.1:EAX（family/model/stepping）与品牌字符串的FNV-1a散列
+static unsigned auto_cpu_signature() {
+    unsigned int regs[4];
+    unsigned hash = 2166136261u;
+    mm_cpuid(1, 0, regs);
+    hash = (hash ^ regs[0]) * 16777619u;
+    mm_cpuid(0x80000000, 0, regs);
+    if (regs[0] >= 0x80000004) {
+        for (unsigned leaf = 0x80000002; leaf <= 0x80000004; leaf++) {
+            mm_cpuid(leaf, 0, regs);
+            for (int r = 0; r < 4; r++) {
+                hash = (hash ^ regs[r]) * 16777619u;
+            }
+        }
+    }
+    return hash;
+}
+
+static MM_THREAD_FUNC auto_empty_thread(void* arg) {
+    (void)arg;
+    return MM_THREAD_RETURN;
+}
+
+// 读取保存的校准结果；文件不存在、格式不对、CPU型号或核心数不同时返回-1
+static int auto_load_calibration(const char *path, AutoCalibration *out) {
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        return -1;
+    }
+
+    AutoCalibration cal;
+    memset(&cal, 0, sizeof(cal));
+    char key[64];
+    double value;
+    int fields = 0;
+    while (fscanf(f, "%63s %lf", key, &value) == 2) {
+        for (int a = 0; a < MM_AUTO_ALGOS; a++) {
+            char name[64];
+            snprintf(name, sizeof(name), "%s_int32", auto_algo_names[a]);
+            if (strcmp(key, name) == 0) { cal.rate[a][MM_INT32] = value; fields++; }
+            snprintf(name, sizeof(name), "%s_float32", auto_algo_names[a]);
+            if (strcmp(key, name) == 0) { cal.rate[a][MM_FLOAT32] = value; fields++; }
+        }
+        if (strcmp(key, "simd_streamed_int32") == 0) { cal.simd_streamed[MM_INT32] = value; fields++; }
+        if (strcmp(key, "simd_streamed_float32") == 0) { cal.simd_streamed[MM_FLOAT32] = value; fields++; }
+        if (strcmp(key, "cpus") == 0) { cal.cpus = (int)value; fields++; }
+        if (strcmp(key, "cpu_signature") == 0) { cal.cpu_signature = (unsigned)value; fields++; }
+        if (strcmp(key, "pack_rate") == 0) { cal.pack_rate = value; fields++; }
+        if (strcmp(key, "thread_cost") == 0) { cal.thread_cost = value; fields++; }
+        if (strcmp(key, "parallel_eff") == 0) { cal.parallel_eff = value; fields++; }
+    }
+    fclose(f);
+
+    if (fields != MM_AUTO_ALGOS * 2 + 7 || cal.cpus != mm_cpu_count() || cal.cpu_signature != auto_cpu_signature()) {
+        return -1;
+    }
+    cal.calibrated = 1;
+    *out = cal;
+    return 0;
+}
+
+static void auto_save_calibration(const char *path, const AutoCalibration *cal) {
+    FILE *f = fopen(path, "w");
+    if (f == NULL) {
+        return;
+    }
+    fprintf(f, "cpus %d\n", cal->cpus);
+    fprintf(f, "cpu_signature %u\n", cal->cpu_signature);
+    for (int a = 0; a < MM_AUTO_ALGOS; a++) {
+        fprintf(f, "%s_int32 %.6g\n", auto_algo_names[a], cal->rate[a][MM_INT32]);
+        fprintf(f, "%s_float32 %.6g\n", auto_algo_names[a], cal->rate[a][MM_FLOAT32]);
+    }
+    fprintf(f, "simd_streamed_int32 %.6g\n", cal->simd_streamed[MM_INT32]);
+    fprintf(f, "simd_streamed_float32 %.6g\n", cal->simd_streamed[MM_FLOAT32]);
+    fprintf(f, "pack_rate %.6g\n", cal->pack_rate);
+    fprintf(f, "thread_cost %.6g\n", cal->thread_cost);
+    fprintf(f, "parallel_eff %.6g\n", cal->parallel_eff);
+    fclose(f);
+}
+
+// 用给定计划计算M x N x K的乘法，返回多次中最短的时间（秒）
+static double auto_time_plan(const MMAutoPlan *plan, int M, int N, int K, int dtype, int *A, int *B, int *C) {
+    double best = 1e30;
+    for (int r = 0; r < 3; r++) {
+        double start = auto_wall_time();
+        matrixmultiply_auto_run(plan, M, N, K, dtype, A, K, B, N, C, N, MM_OVERWRITE);
+        double elapsed = auto_wall_time() - start;
+        if (elapsed < best) best = elapsed;
+    }
+    return best;
+}
+
+// 运行校准基准并写入auto_cal（调用时持有auto_cal_lock）。force为0时优先读取保存的结果
+static void auto_calibrate_locked(int force) {
+    const char *path = auto_calibration_path();
+    if (!force && path != NULL && auto_load_calibration(path, &auto_cal) == 0) {
+        return;
+    }
+
+    AutoCalibration cal;
+    memset(&cal, 0, sizeof(cal));
+    cal.cpus = mm_cpu_count();
+    cal.cpu_signature = auto_cpu_signature();
+
+    const int n_big = 192;    // 向量化算法的校准大小：B的面板块不超出L2
+    const int n_small = 64;   // 标量算法的校准大小
+    int *A = (int*)mm_aligned_malloc((size_t)256 * 1024 * sizeof(int), 32);
+    int *B = (int*)mm_aligned_malloc((size_t)256 * 1024 * sizeof(int), 32);
+    int *C = (int*)mm_aligned_malloc((size_t)256 * 1024 * sizeof(int), 32);
+    for (int i = 0; i < 256 * 1024; i++) {
+        A[i] = i % 7 - 3;
+        B[i] = i % 5 - 2;
+    }
+
+    // 单线程速率：float32的输入用同样的位模式（小整数的位模式是正常的浮点数或0）
+    for (int dtype = MM_INT32; dtype <= MM_FLOAT32; dtype++) {
+        if (dtype == MM_FLOAT32) {
+            for (int i = 0; i < 256 * 1024; i++) {
+                ((float*)A)[i] = (float)(i % 7 - 3);
+                ((float*)B)[i] = (float)(i % 5 - 2);
+            }
+        }
+        for (int a = 0; a < MM_AUTO_ALGOS; a++) {
+            MMAutoPlan plan = {a, 1, AUTO_KC, 0.0};
+            int n = (a == MM_AUTO_SCALAR) ? n_small : n_big;
+            double elapsed = auto_time_plan(&plan, n, n, n, dtype, A, B, C);
+            // 打包版本的时间中扣除打包开销（在下面单独测量）
+            cal.rate[a][dtype] = 2.0 * n * n * n / elapsed;
+        }
+        // B为256 x 1024（1MB，行间距为2的幂）时不打包版本的速率
+        MMAutoPlan streamed = {MM_AUTO_SIMD, 1, AUTO_KC, 0.0};
+        double elapsed = auto_time_plan(&streamed, 128, 1024, 256, dtype, A, B, C);
+        cal.simd_streamed[dtype] = 2.0 * 128 * 1024 * 256 / elapsed;
+    }
+
+    // 打包速率：256 x 1024
+    double best = 1e30;
+    for (int r = 0; r < 3; r++) {
+        double start = auto_wall_time();
+        int *packed = auto_pack_B(256, 1024, B, 1024);
+        double elapsed = auto_wall_time() - start;
+        mm_aligned_free(packed);
+        if (elapsed < best) best = elapsed;
+    }
+    cal.pack_rate = 256.0 * 1024 / best;
+    for (int dtype = MM_INT32; dtype <= MM_FLOAT32; dtype++) {
+        double t = 2.0 * n_big * n_big * n_big / cal.rate[MM_AUTO_PACKED][dtype] - (double)n_big * n_big / cal.pack_rate;
+        if (t > 0) cal.rate[MM_AUTO_PACKED][dtype] = 2.0 * n_big * n_big * n_big / t;
+    }
+
+    // 线程开销：创建并等待空线程
+    int max_threads = cal.cpus < AUTO_MAX_THREADS ? cal.cpus : AUTO_MAX_THREADS;
+    int probe_threads = max_threads > 1 ? max_threads : 2;
+    mm_thread_t threads[AUTO_MAX_THREADS];
+    best = 1e30;
+    for (int r = 0; r < 5; r++) {
+        double start = auto_wall_time();
+        for (int t = 0; t < probe_threads; t++) {
+            mm_thread_create(&threads[t], auto_empty_thread, NULL);
+        }
+        mm_thread_join_all(threads, probe_threads);
+        double elapsed = auto_wall_time() - start;
+        if (elapsed < best) best = elapsed;
+    }
+    cal.thread_cost = best / probe_threads;
+
+    // 并行效率：256 x 256 x 256 的int32打包乘法，单线程与max_threads个线程对比
+    cal.parallel_eff = 1.0;
+    if (max_threads > 1) {
+        MMAutoPlan serial = {MM_AUTO_PACKED, 1, AUTO_KC, 0.0};
+        MMAutoPlan parallel = {MM_AUTO_PACKED, max_threads, AUTO_KC, 0.0};
+        double t1 = auto_time_plan(&serial, 256, 256, 256, MM_INT32, A, B, C);
+        double tp = auto_time_plan(&parallel, 256, 256, 256, MM_INT32, A, B, C) - cal.thread_cost * max_threads;
+        double eff = (tp > 0) ? (t1 / tp - 1.0) / (max_threads - 1) : 1.0;
+        cal.parallel_eff = eff < 0.05 ? 0.05 : (eff > 1.0 ? 1.0 : eff);
+    }
+
+    mm_aligned_free(A);
+    mm_aligned_free(B);
+    mm_aligned_free(C);
+
+    cal.calibrated = 1;
+    auto_cal = cal;
+    if (path != NULL) {
+        auto_save_calibration(path, &auto_cal);
+    }
+}
+
+// 运行校准基准（约几十毫秒）。force为0时优先读取保存的结果，已经校准过则直接返回；返回0
+int matrix_auto_calibrate(int force) {
+    mm_mutex_lock(&auto_cal_lock);
+    if (force || !auto_cal.calibrated) {
+        auto_calibrate_locked(force);
+    }
+    mm_mutex_unlock(&auto_cal_lock);
+    return 0;
+}
+
+// 读取校准结果（需要时先校准）
+static void auto_get_calibration(AutoCalibration *cal) {
+    mm_mutex_lock(&auto_cal_lock);
+    if (!auto_cal.calibrated) {
+        auto_calibrate_locked(0);
+    }
+    *cal = auto_cal;
+    mm_mutex_unlock(&auto_cal_lock);
+}
+
+// ==================== 代价模型 ====================
+
+// 预测给定算法和线程数的执行时间（秒）
+double matrix_auto_predict(int algo, int threads, int M, int N, int K, int dtype) {
+    AutoCalibration cal;
+    auto_get_calibration(&cal);
+    if (threads > M) threads = M;
+    if (threads < 1) threads = 1;
+    dtype = (dtype == MM_FLOAT32) ? MM_FLOAT32 : MM_INT32;
+
+    // 向量化算法总是计算完整的64列面板（尾部面板的无效列也占用计算时间）
+    double cols = (algo == MM_AUTO_SCALAR) ? N : (double)((N + AUTO_NR - 1) / AUTO_NR) * AUTO_NR;
+    // 行按 M*t/threads 划分，行数不能被线程数整除时最慢的线程有ceil(M/threads)行，它决定总时间
+    double rows = (double)((M + threads - 1) / threads) * threads;
+    double speedup = 1.0 + (threads - 1) * cal.parallel_eff;
+
+    double rate = cal.rate[algo][dtype];
+    if (algo == MM_AUTO_SIMD && (double)K * N * sizeof(int) > AUTO_CACHE_BYTES) {
+        rate = cal.simd_streamed[dtype];
+    }
+    double t = 2.0 * rows * K * cols / (rate * speedup);
+    if (threads > 1) {
+        t += cal.thread_cost * threads;
+    }
+    if (algo == MM_AUTO_PACKED) {
+        t += (double)K * cols / cal.pack_rate;
+    }
+    return t;
+}
+
+static int auto_env_int(const char *name) {
+    const char *env = getenv(name);
+    return (env != NULL && env[0] != '\0') ? atoi(env) : 0;
+}
+
+// 为给定的形状和元素类型选择执行计划（环境变量可以覆盖其中任意一项），返回0
+int matrix_auto_plan(int M, int N, int K, int dtype, MMAutoPlan *plan) {
+    AutoCalibration cal;
+    auto_get_calibration(&cal);
+
+    int max_threads = cal.cpus < AUTO_MAX_THREADS ? cal.cpus : AUTO_MAX_THREADS;
+    if (max_threads > M) max_threads = M;
+    if (max_threads < 1) max_threads = 1;
+
+    // 本机不支持AVX2时只能使用标量算法
+    int first_algo = MM_AUTO_SCALAR;
+    int last_algo = mm_cpu_has_avx2() ? MM_AUTO_PACKED : MM_AUTO_SCALAR;
+
+    const char *env_algo = getenv("MATRIX_AUTO_ALGO");
+    if (env_algo != NULL) {
+        for (int a = 0; a < MM_AUTO_ALGOS; a++) {
+            if (strcmp(env_algo, auto_algo_names[a]) == 0) {
+                first_algo = last_algo = a;
+            }
+        }
+    }
+    int env_threads = auto_env_int("MATRIX_AUTO_THREADS");
+
+    plan->algo = MM_AUTO_SCALAR;
+    plan->threads = 1;
+    plan->predicted_seconds = 1e30;
+    for (int a = first_algo; a <= last_algo; a++) {
+        // 标量算法只用于小矩阵，不值得多线程
+        int t_max = (a == MM_AUTO_SCALAR) ? 1 : max_threads;
+        for (int t = 1; t <= t_max; t++) {
+            int threads = env_threads > 0 ? env_threads : t;
+            if (threads > M) threads = M > 0 ? M : 1;
+            double predicted = matrix_auto_predict(a, threads, M, N, K, dtype);
+            if (predicted < plan->predicted_seconds) {
+                plan->algo = a;
+                plan->threads = threads;
+                plan->predicted_seconds = predicted;
+            }
+        }
+    }
+
+    // k方向分块：K不大时一次完成（C只读写一遍），否则按AUTO_KC分块使面板块留在L2中
+    int env_kc = auto_env_int("MATRIX_AUTO_KC");
+    plan->kc = env_kc > 0 ? env_kc : (K <= AUTO_KC * 3 / 2 ? (K > 0 ? K : 1) : AUTO_KC);
+    return 0;
+}
+
+// 通用入口：A、B、C按行主序存放，lda / ldb / ldc为行间距（元素个数）。dtype为MM_INT32或MM_FLOAT32
+void matrixmultiply_auto_ex(int M, int N, int K, int dtype,
+                            const void *A, long long lda, const void *B, long long ldb,
+                            void *C, long long ldc, int flags) {
+    MMAutoPlan plan;
+    matrix_auto_plan(M, N, K, dtype, &plan);
+
+    if (auto_env_int("MATRIX_AUTO_VERBOSE")) {
+        printf("matrixmultiply_auto %dx%dx%d %s: %s, %d threads, kc=%d, predicted %.6f s\n",
+               M, N, K, dtype == MM_FLOAT32 ? "float32" : "int32",
+               auto_algo_names[plan.algo], plan.threads, plan.kc, plan.predicted_seconds);
+    }
+
+    matrixmultiply_auto_run(&plan, M, N, K, dtype, A, lda, B, ldb, C, ldc, flags);
+}
+
+// 与其他版本相同的接口：N x N的int矩阵（由create_matrix分配，行间距统一）
+void matrixmultiply_auto(int N, int **matrixA, int **matrixB, int **matrixC) {
+    if (N <= 0) {
+        return;
+    }
+    long long lda = N > 1 ? matrixA[1] - matrixA[0] : N;
+    long long ldb = N > 1 ? matrixB[1] - matrixB[0] : N;
+    long long ldc = N > 1 ? matrixC[1] - matrixC[0] : N;
+    matrixmultiply_auto_ex(N, N, N, MM_INT32, matrixA[0], lda, matrixB[0], ldb, matrixC[0], ldc, MM_OVERWRITE);
+}
+
+// 辅助函数
+int** create_matrix(int N) {
+    return mm_alloc_matrix(N, N);
+}
+
+void free_matrix(int **matrix, int N) {
+    mm_free_matrix(matrix);
+}
+
+void init_test_matrices(int N, int **matrixA, int **matrixB) {
+    for (int i = 0; i < N; i++) {
+        for (int j = 0; j < N; j++) {
+            matrixA[i][j] = i + j;
+            matrixB[i][j] = i * j + 1;
+        }
+    }
+}
+
+#ifdef STANDALONE_TEST
+int main() {
+    double start = auto_wall_time();
+    matrix_auto_calibrate(1);
+    AutoCalibration cal;
+    auto_get_calibration(&cal);
+    printf("校准耗时: %.3f 秒（%d个CPU核心）\n", auto_wall_time() - start, cal.cpus);
+    for (int a = 0; a < MM_AUTO_ALGOS; a++) {
+        printf("  %-7s int32 %6.2f GOPS, float32 %6.2f GFLOPS\n", auto_algo_names[a],
+               cal.rate[a][MM_INT32] / 1e9, cal.rate[a][MM_FLOAT32] / 1e9);
+    }
+    printf("  simd(B不在cache中) int32 %6.2f GOPS, float32 %6.2f GFLOPS\n",
+           cal.simd_streamed[MM_INT32] / 1e9, cal.simd_streamed[MM_FLOAT32] / 1e9);
+    printf("  打包 %.2f G元素/秒, 每个线程开销 %.1f 微秒, 并行效率 %.2f\n",
+           cal.pack_rate / 1e9, cal.thread_cost * 1e6, cal.parallel_eff);
+
+    // 各种形状的选择，并与标量版本对比验证结果
+    int shapes[][3] = {{8, 8, 8}, {32, 32, 32}, {100, 100, 100}, {256, 256, 256},
+                       {1024, 1024, 1024}, {2048, 16, 2048}, {3, 4096, 77}, {1, 1, 1}};
+    printf("\n%-18s %-8s %-7s %-5s %-12s %-12s %s\n", "M x N x K", "类型", "算法", "线程", "预测(秒)", "实际(秒)", "验证");
+    for (int s = 0; s < 8; s++) {
+        int M = shapes[s][0], N = shapes[s][1], K = shapes[s][2];
+        for (int dtype = MM_INT32; dtype <= MM_FLOAT32; dtype++) {
+            int *A = (int*)malloc((size_t)M * K * sizeof(int));
+            int *B = (int*)malloc((size_t)K * N * sizeof(int));
+            int *C = (int*)malloc((size_t)M * N * sizeof(int));
+            int *R = (int*)malloc((size_t)M * N * sizeof(int));
+            for (size_t i = 0; i < (size_t)M * K; i++) {
+                if (dtype == MM_FLOAT32) ((float*)A)[i] = (float)((int)(i % 13) - 6); else A[i] = (int)(i % 13) - 6;
+            }
+            for (size_t i = 0; i < (size_t)K * N; i++) {
+                if (dtype == MM_FLOAT32) ((float*)B)[i] = (float)((int)(i % 11) - 5); else B[i] = (int)(i % 11) - 5;
+            }
+
+            MMAutoPlan plan;
+            matrix_auto_plan(M, N, K, dtype, &plan);
+            start = auto_wall_time();
+            matrixmultiply_auto_ex(M, N, K, dtype, A, K, B, N, C, N, MM_OVERWRITE);
+            double elapsed = auto_wall_time() - start;
+
+            MMAutoPlan scalar = {MM_AUTO_SCALAR, 1, K, 0.0};
+            matrixmultiply_auto_run(&scalar, M, N, K, dtype, A, K, B, N, R, N, MM_OVERWRITE);
+            int ok = memcmp(C, R, (size_t)M * N * sizeof(int)) == 0;
+
+            char shape[32];
+            snprintf(shape, sizeof(shape), "%dx%dx%d", M, N, K);
+            printf("%-18s %-8s %-7s %-5d %-12.6f %-12.6f %s\n", shape, dtype == MM_FLOAT32 ? "float32" : "int32",
+                   auto_algo_names[plan.algo], plan.threads, plan.predicted_seconds, elapsed, ok ? "正确" : "错误");
+            free(A);
+            free(B);
+            free(C);
+            free(R);
+        }
+    }
+
+    return 0;
+}
+#endif
@@ -2,42 +2,42 @@
 #include <stdlib.h>
 #include <time.h>
 #include <string.h>
+#include "matrix_layout.h"
 
-void matrixmultiply_basic(int N, int **matrixA, int **matrixB, int **matrixC) {
+void matrixmultiply_basic_ex(int N, int **matrixA, int **matrixB, int **matrixC, int flags) {
     int i, j, k;
     
-    // 初始化结果矩阵
-    for (i = 0; i < N; i++) {
-        for (j = 0; j < N; j++) {
-            matrixC[i][j] = 0;
-        }
-    }
-    
-    // 基本的三重循环矩阵乘法
+    // 基本的三重循环矩阵乘法，在寄存器中累加后一次性写回C
     for (i = 0; i < N; i++) {
         for (j = 0; j < N; j++) {
+            int sum = (flags & MM_ACCUMULATE) ? matrixC[i][j] : 0;
             for (k = 0; k < N; k++) {
-                matrixC[i][j] += matrixA[i][k] * matrixB[k][j];
+                sum += matrixA[i][k] * matrixB[k][j];
             }
+            matrixC[i][j] = sum;
         }
     }
 }
 
+void matrixmultiply_basic(int N, int **matrixA, int **matrixB, int **matrixC) {
+    matrixmultiply_basic_ex(N, matrixA, matrixB, matrixC, MM_OVERWRITE);
+}
+
 // 创建矩阵的辅助函数
 int** create_matrix(int N) {
-    int **matrix = (int**)malloc(N * sizeof(int*));
-    for (int i = 0; i < N; i++) {
-        matrix[i] = (int*)malloc(N * sizeof(int));
-    }
-    return matrix;
+    return mm_alloc_matrix(N, N);
 }
 
-// 释放矩阵的辅助函数
 void free_matrix(int **matrix, int N) {
-    for (int i = 0; i < N; i++) {
-        free(matrix[i]);
-    }
-    free(matrix);
+    mm_free_matrix(matrix);
+}
+
+void matrix_set_padding(int enabled) {
+    mm_set_padding(enabled);
+}
+
+int matrix_leading_dim(int **matrix, int N) {
+    return mm_matrix_leading_dim(matrix, N);
 }
 
 // 初始化测试矩阵
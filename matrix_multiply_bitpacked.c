@@ -0,0 +1,372 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <string.h>
+#include <stdint.h>
+#include <immintrin.h>
+#include "matrix_platform.h"
+#include "matrix_layout.h"
+
+// 位压缩的0/1矩阵乘法：每个元素占1位，一个64位字存放64个元素，内存和带宽只有int版本的1/32。
+//   MM_BOOLEAN - 布尔半环：C[i][j] = OR_k (A[i][k] AND B[k][j])，用于可达性（传递闭包）计算
+//   MM_GF2     - GF(2)：   C[i][j] = XOR_k (A[i][k] AND B[k][j])，用于编码理论
+// 三种计算方法：
+//   MM_BITS_ROWS          - 行组合：A[i][k] = 1 时把B的第k行（AVX2按位OR/XOR）合并到C的第i行
+//   MM_BITS_DOT           - 点积：把B转置后，C[i][j]由 popcount(A的第i行 AND B^T的第j行) 得到
+//   MM_BITS_FOUR_RUSSIANS - 四俄罗斯人方法(M4RM)：每8行B预先算出256种组合，
+//                           A的每个字节只需查一次表、合并一行，计算量降低约8倍
+
+// 半环
+#define MM_BOOLEAN 0
+#define MM_GF2     1
+
+// 计算方法
+#define MM_BITS_ROWS          0
+#define MM_BITS_DOT           1
+#define MM_BITS_FOUR_RUSSIANS 2
+
+#define M4R_BITS 8                    // 四俄罗斯人方法每张表覆盖的行数
+#define M4R_TABLE (1 << M4R_BITS)     // 每张表的组合数
+
+// 位压缩矩阵：第i行第j列位于 data[i * words + j / 64] 的第 j % 64 位。
+// 每行的字数补齐到4的倍数（一个AVX2寄存器），补齐部分始终为0
+typedef struct {
+    int rows;
+    int cols;
+    int words;
+    uint64_t *data;
+} BitMatrix;
+
+static inline uint64_t* bit_row(const BitMatrix *m, int i) {
+    return m->data + (size_t)i * m->words;
+}
+
+BitMatrix* bitmatrix_create(int rows, int cols) {
+    BitMatrix *m = (BitMatrix*)malloc(sizeof(BitMatrix));
+    m->rows = rows;
+    m->cols = cols;
+    m->words = ((cols + 63) / 64 + 3) / 4 * 4;
+    m->data = (uint64_t*)mm_aligned_malloc((size_t)rows * m->words * sizeof(uint64_t), 32);
+    memset(m->data, 0, (size_t)rows * m->words * sizeof(uint64_t));
+    return m;
+}
+
+void bitmatrix_free(BitMatrix *m) {
+    if (m == NULL) {
+        return;
+    }
+    mm_aligned_free(m->data);
+    free(m);
+}
+
+// 从int矩阵转换（非0元素为1）
+BitMatrix* bitmatrix_from_int(int rows, int cols, int **matrix) {
+    BitMatrix *m = bitmatrix_create(rows, cols);
+    for (int i = 0; i < rows; i++) {
+        uint64_t *row = bit_row(m, i);
+        for (int j = 0; j < cols; j++) {
+            if (matrix[i][j] != 0) {
+                row[j >> 6] |= 1ULL << (j & 63);
+            }
+        }
+    }
+    return m;
+}
+
+// 转换回int矩阵（元素为0或1）
+void bitmatrix_to_int(const BitMatrix *m, int **matrix) {
+    for (int i = 0; i < m->rows; i++) {
+        const uint64_t *row = bit_row(m, i);
+        for (int j = 0; j < m->cols; j++) {
+            matrix[i][j] = (int)((row[j >> 6] >> (j & 63)) & 1);
+        }
+    }
+}
+
+// 转置（点积方法使用）
+static BitMatrix* bitmatrix_transpose(const BitMatrix *m) {
+    BitMatrix *t = bitmatrix_create(m->cols, m->rows);
+    for (int i = 0; i < m->rows; i++) {
+        const uint64_t *row = bit_row(m, i);
+        for (int w = 0; w < (m->cols + 63) / 64; w++) {
+            uint64_t bits = row[w];
+            while (bits) {
+                int j = w * 64 + __builtin_ctzll(bits);
+                bit_row(t, j)[i >> 6] |= 1ULL << (i & 63);
+                bits &= bits - 1;
+            }
+        }
+    }
+    return t;
+}
+
+// dst (op)= src，words为4的倍数
+static inline void row_combine(uint64_t *dst, const uint64_t *src, int words, int semiring) {
+    if (semiring == MM_GF2) {
+        for (int w = 0; w < words; w += 4) {
+            __m256i d = _mm256_load_si256((__m256i*)&dst[w]);
+            _mm256_store_si256((__m256i*)&dst[w], _mm256_xor_si256(d, _mm256_load_si256((const __m256i*)&src[w])));
+        }
+    } else {
+        for (int w = 0; w < words; w += 4) {
+            __m256i d = _mm256_load_si256((__m256i*)&dst[w]);
+            _mm256_store_si256((__m256i*)&dst[w], _mm256_or_si256(d, _mm256_load_si256((const __m256i*)&src[w])));
+        }
+    }
+}
+
+// 线程参数结构体
+typedef struct {
+    const BitMatrix *A;
+    const BitMatrix *B;    // 点积方法中为B^T
+    BitMatrix *C;
+    int semiring;
+    int method;
+    int start_row;
+    int end_row;
+} BitThreadParams;
+
+// 行组合：逐个取出A行中为1的位
+static void bits_rows_kernel(BitThreadParams *params) {
+    const BitMatrix *A = params->A, *B = params->B;
+    BitMatrix *C = params->C;
+    int a_words = (A->cols + 63) / 64;
+
+    for (int i = params->start_row; i < params->end_row; i++) {
+        const uint64_t *a_row = bit_row(A, i);
+        uint64_t *c_row = bit_row(C, i);
+
+        for (int w = 0; w < a_words; w++) {
+            uint64_t bits = a_row[w];
+            while (bits) {
+                int k = w * 64 + __builtin_ctzll(bits);
+                row_combine(c_row, bit_row(B, k), C->words, params->semiring);
+                bits &= bits - 1;
+            }
+        }
+    }
+}
+
+// 点积：A的行与B^T的行按位与，GF(2)取popcount的奇偶，布尔半环只需判断是否非0
+static void bits_dot_kernel(BitThreadParams *params) {
+    const BitMatrix *A = params->A, *Bt = params->B;
+    BitMatrix *C = params->C;
+    int k_words = A->words;
+
+    for (int i = params->start_row; i < params->end_row; i++) {
+        const uint64_t *a_row = bit_row(A, i);
+        uint64_t *c_row = bit_row(C, i);
+
+        for (int j = 0; j < C->cols; j++) {
+            const uint64_t *b_row = bit_row(Bt, j);
+            int bit;
+
+            if (params->semiring == MM_GF2) {
+                __m256i parity = _mm256_setzero_si256();
+                for (int w = 0; w < k_words; w += 4) {
+                    __m256i a = _mm256_load_si256((const __m256i*)&a_row[w]);
+                    __m256i b = _mm256_load_si256((const __m256i*)&b_row[w]);
+                    parity = _mm256_xor_si256(parity, _mm256_and_si256(a, b));
+                }
+                // 奇偶性可以先XOR再统计：popcount(x ^ y)与popcount(x) + popcount(y)的奇偶相同
+                uint64_t lanes[4];
+                _mm256_storeu_si256((__m256i*)lanes, parity);
+                bit = __builtin_popcountll(lanes[0] ^ lanes[1] ^ lanes[2] ^ lanes[3]) & 1;
+            } else {
+                bit = 0;
+                for (int w = 0; w < k_words && !bit; w += 4) {
+                    __m256i a = _mm256_load_si256((const __m256i*)&a_row[w]);
+                    __m256i b = _mm256_load_si256((const __m256i*)&b_row[w]);
+                    bit = !_mm256_testz_si256(a, b);
+                }
+            }
+
+            if (bit) {
+                c_row[j >> 6] |= 1ULL << (j & 63);
+            }
+        }
+    }
+}
+
+// 四俄罗斯人方法：对B的每组8行建一张256项的表，table[s] = 组合s中各行的OR/XOR
+static void bits_four_russians_kernel(BitThreadParams *params) {
+    const BitMatrix *A = params->A, *B = params->B;
+    BitMatrix *C = params->C;
+    int words = C->words;
+    uint64_t *table = (uint64_t*)mm_aligned_malloc((size_t)M4R_TABLE * words * sizeof(uint64_t), 32);
+
+    for (int kk = 0; kk < A->cols; kk += M4R_BITS) {
+        int group = (A->cols - kk < M4R_BITS) ? A->cols - kk : M4R_BITS;
+
+        // table[s] = table[s去掉最低位] (op) B[kk + 最低位]，每项只需一次行合并
+        memset(table, 0, (size_t)words * sizeof(uint64_t));
+        for (int s = 1; s < (1 << group); s++) {
+            uint64_t *entry = table + (size_t)s * words;
+            memcpy(entry, table + (size_t)(s & (s - 1)) * words, words * sizeof(uint64_t));
+            row_combine(entry, bit_row(B, kk + __builtin_ctz(s)), words, params->semiring);
+        }
+
+        // kk是8的倍数，A中这8位正好是某个字中的一个字节
+        for (int i = params->start_row; i < params->end_row; i++) {
+            int index = (int)((bit_row(A, i)[kk >> 6] >> (kk & 63)) & (M4R_TABLE - 1));
+            if (index) {
+                row_combine(bit_row(C, i), table + (size_t)index * words, words, params->semiring);
+            }
+        }
+    }
+
+    mm_aligned_free(table);
+}
+
+MM_THREAD_FUNC bits_thread_function(void* arg) {
+    BitThreadParams* params = (BitThreadParams*)arg;
+
+    if (params->method == MM_BITS_DOT) {
+        bits_dot_kernel(params);
+    } else if (params->method == MM_BITS_FOUR_RUSSIANS) {
+        bits_four_russians_kernel(params);
+    } else {
+        bits_rows_kernel(params);
+    }
+
+    return MM_THREAD_RETURN;
+}
+
+// C = A x B（布尔半环或GF(2)）。C必须是A->rows x B->cols的矩阵，形状不匹配时返回-1
+int bitmatrix_multiply(const BitMatrix *A, const BitMatrix *B, BitMatrix *C, int semiring, int method) {
+    if (A->cols != B->rows || C->rows != A->rows || C->cols != B->cols) {
+        return -1;
+    }
+
+    memset(C->data, 0, (size_t)C->rows * C->words * sizeof(uint64_t));
+    if (A->rows == 0) {
+        return 0;
+    }
+
+    BitMatrix *Bt = (method == MM_BITS_DOT) ? bitmatrix_transpose(B) : NULL;
+
+    // 获取系统CPU核心数
+    int num_threads = mm_cpu_count();
+    if (num_threads > 8) num_threads = 8; // 限制线程数
+    if (num_threads > A->rows) num_threads = A->rows;
+
+    mm_thread_t* threads = (mm_thread_t*)malloc(num_threads * sizeof(mm_thread_t));
+    BitThreadParams* params = (BitThreadParams*)malloc(num_threads * sizeof(BitThreadParams));
+
+    int rows_per_thread = A->rows / num_threads;
+    int remaining_rows = A->rows % num_threads;
+
+    for (int t = 0; t < num_threads; t++) {
+        params[t].A = A;
+        params[t].B = Bt ? Bt : B;
+        params[t].C = C;
+        params[t].semiring = semiring;
+        params[t].method = method;
+        params[t].start_row = t * rows_per_thread;
+        params[t].end_row = (t + 1) * rows_per_thread;
+
+        // 最后一个线程处理剩余的行
+        if (t == num_threads - 1) {
+            params[t].end_row += remaining_rows;
+        }
+
+        mm_thread_create(&threads[t], bits_thread_function, &params[t]);
+    }
+
+    mm_thread_join_all(threads, num_threads);
+
+    free(threads);
+    free(params);
+    bitmatrix_free(Bt);
+    return 0;
+}
+
+// 与int矩阵乘法的结果比较：布尔半环中int结果非0对应1，GF(2)中int结果的奇偶对应1。
+// 返回不一致的元素个数
+int bitmatrix_compare_int(const BitMatrix *m, int **matrix, int semiring) {
+    int mismatches = 0;
+    for (int i = 0; i < m->rows; i++) {
+        const uint64_t *row = bit_row(m, i);
+        for (int j = 0; j < m->cols; j++) {
+            int expected = (semiring == MM_GF2) ? (matrix[i][j] & 1) : (matrix[i][j] != 0);
+            if ((int)((row[j >> 6] >> (j & 63)) & 1) != expected) {
+                mismatches++;
+            }
+        }
+    }
+    return mismatches;
+}
+
+// 辅助函数
+int** create_matrix(int N) {
+    return mm_alloc_matrix(N, N);
+}
+
+void free_matrix(int **matrix, int N) {
+    mm_free_matrix(matrix);
+}
+
+// 用伪随机的0/1初始化矩阵，density_percent为1的比例（百分比）
+void init_binary_matrix(int N, int **matrix, int density_percent, unsigned int seed) {
+    uint64_t state = 0x9E3779B97F4A7C15ULL ^ seed;
+    for (int i = 0; i < N; i++) {
+        for (int j = 0; j < N; j++) {
+            state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+            matrix[i][j] = (int)(state % 100) < density_percent;
+        }
+    }
+}
+
+#ifdef STANDALONE_TEST
+int main() {
+    int N = 1024; // 测试矩阵大小
+    printf("测试位压缩0/1矩阵乘法，矩阵大小: %dx%d\n", N, N);
+
+    int **matrixA = create_matrix(N);
+    int **matrixB = create_matrix(N);
+    int **reference = create_matrix(N);
+    init_binary_matrix(N, matrixA, 50, 1);
+    init_binary_matrix(N, matrixB, 50, 2);
+
+    // int参考结果（与matrixmultiply_basic相同的三重循环）
+    clock_t start = clock();
+    for (int i = 0; i < N; i++) {
+        for (int j = 0; j < N; j++) {
+            int sum = 0;
+            for (int k = 0; k < N; k++) {
+                sum += matrixA[i][k] * matrixB[k][j];
+            }
+            reference[i][j] = sum;
+        }
+    }
+    printf("int参考版本执行时间: %.4f 秒\n", ((double)(clock() - start)) / CLOCKS_PER_SEC);
+
+    BitMatrix *A = bitmatrix_from_int(N, N, matrixA);
+    BitMatrix *B = bitmatrix_from_int(N, N, matrixB);
+    BitMatrix *C = bitmatrix_create(N, N);
+    printf("内存占用: int %.2f MB, 位压缩 %.3f MB\n",
+           (double)N * N * sizeof(int) / 1048576.0, (double)N * A->words * sizeof(uint64_t) / 1048576.0);
+
+    const char *semiring_names[] = {"布尔半环", "GF(2)"};
+    const char *method_names[] = {"行组合", "点积(popcount)", "四俄罗斯人"};
+    for (int semiring = MM_BOOLEAN; semiring <= MM_GF2; semiring++) {
+        printf("\n%s:\n", semiring_names[semiring]);
+        for (int method = MM_BITS_ROWS; method <= MM_BITS_FOUR_RUSSIANS; method++) {
+            start = clock();
+            bitmatrix_multiply(A, B, C, semiring, method);
+            double elapsed = ((double)(clock() - start)) / CLOCKS_PER_SEC;
+            int mismatches = bitmatrix_compare_int(C, reference, semiring);
+            printf("  %s: %.4f 秒, %s\n", method_names[method], elapsed, mismatches == 0 ? "正确" : "错误");
+        }
+    }
+
+    bitmatrix_free(A);
+    bitmatrix_free(B);
+    bitmatrix_free(C);
+    free_matrix(matrixA, N);
+    free_matrix(matrixB, N);
+    free_matrix(reference, N);
+
+    return 0;
+}
+#endif
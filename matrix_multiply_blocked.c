@@ -2,20 +2,14 @@
 #include <stdlib.h>
 #include <time.h>
 #include <string.h>
+#include "matrix_layout.h"
 
 // 块大小定义，通常设置为L1 cache的大小，这里使用64
 #define BLOCK_SIZE 64
 
-void matrixmultiply_blocked(int N, int **matrixA, int **matrixB, int **matrixC) {
+void matrixmultiply_blocked_ex(int N, int **matrixA, int **matrixB, int **matrixC, int flags) {
     int i, j, k, ii, jj, kk;
     
-    // 初始化结果矩阵
-    for (i = 0; i < N; i++) {
-        for (j = 0; j < N; j++) {
-            matrixC[i][j] = 0;
-        }
-    }
-    
     // 分块矩阵乘法
     for (ii = 0; ii < N; ii += BLOCK_SIZE) {
         for (jj = 0; jj < N; jj += BLOCK_SIZE) {
@@ -23,9 +17,12 @@ void matrixmultiply_blocked(int N, int **matrixA, int **matrixB, int **matrixC)
                 // 在每个块内进行矩阵乘法
                 for (i = ii; i < ii + BLOCK_SIZE && i < N; i++) {
                     for (j = jj; j < jj + BLOCK_SIZE && j < N; j++) {
+                        // kk为第一块时C尚未写入过，直接从0开始累加
+                        int sum = (kk == 0 && !(flags & MM_ACCUMULATE)) ? 0 : matrixC[i][j];
                         for (k = kk; k < kk + BLOCK_SIZE && k < N; k++) {
-                            matrixC[i][j] += matrixA[i][k] * matrixB[k][j];
+                            sum += matrixA[i][k] * matrixB[k][j];
                         }
+                        matrixC[i][j] = sum;
                     }
                 }
             }
@@ -33,27 +30,32 @@ void matrixmultiply_blocked(int N, int **matrixA, int **matrixB, int **matrixC)
     }
 }
 
+void matrixmultiply_blocked(int N, int **matrixA, int **matrixB, int **matrixC) {
+    matrixmultiply_blocked_ex(N, matrixA, matrixB, matrixC, MM_OVERWRITE);
+}
+
 // 改进的分块算法，使用更好的数据局部性
-void matrixmultiply_blocked_optimized(int N, int **matrixA, int **matrixB, int **matrixC) {
+void matrixmultiply_blocked_optimized_ex(int N, int **matrixA, int **matrixB, int **matrixC, int flags) {
     int i, j, k, ii, jj, kk;
     
-    // 初始化结果矩阵
-    for (i = 0; i < N; i++) {
-        for (j = 0; j < N; j++) {
-            matrixC[i][j] = 0;
-        }
-    }
-    
     // 分块矩阵乘法，改变循环顺序以提高cache命中率
     for (kk = 0; kk < N; kk += BLOCK_SIZE) {
         for (ii = 0; ii < N; ii += BLOCK_SIZE) {
             for (jj = 0; jj < N; jj += BLOCK_SIZE) {
                 // 在每个块内进行矩阵乘法
                 for (k = kk; k < kk + BLOCK_SIZE && k < N; k++) {
+                    // k == 0 是对C的第一次写入：覆盖而不是累加
+                    int first = (k == 0) && !(flags & MM_ACCUMULATE);
                     for (i = ii; i < ii + BLOCK_SIZE && i < N; i++) {
                         int temp = matrixA[i][k];
-                        for (j = jj; j < jj + BLOCK_SIZE && j < N; j++) {
-                            matrixC[i][j] += temp * matrixB[k][j];
+                        if (first) {
+                            for (j = jj; j < jj + BLOCK_SIZE && j < N; j++) {
+                                matrixC[i][j] = temp * matrixB[k][j];
+                            }
+                        } else {
+                            for (j = jj; j < jj + BLOCK_SIZE && j < N; j++) {
+                                matrixC[i][j] += temp * matrixB[k][j];
+                            }
                         }
                     }
                 }
@@ -62,8 +64,12 @@ void matrixmultiply_blocked_optimized(int N, int **matrixA, int **matrixB, int *
     }
 }
 
+void matrixmultiply_blocked_optimized(int N, int **matrixA, int **matrixB, int **matrixC) {
+    matrixmultiply_blocked_optimized_ex(N, matrixA, matrixB, matrixC, MM_OVERWRITE);
+}
+
 // 自适应块大小的版本
-void matrixmultiply_blocked_adaptive(int N, int **matrixA, int **matrixB, int **matrixC) {
+void matrixmultiply_blocked_adaptive_ex(int N, int **matrixA, int **matrixB, int **matrixC, int flags) {
     int block_size;
     
     // 根据矩阵大小选择合适的块大小
@@ -81,23 +87,24 @@ void matrixmultiply_blocked_adaptive(int N, int **matrixA, int **matrixB, int **
     
     int i, j, k, ii, jj, kk;
     
-    // 初始化结果矩阵
-    for (i = 0; i < N; i++) {
-        for (j = 0; j < N; j++) {
-            matrixC[i][j] = 0;
-        }
-    }
-    
     // 分块矩阵乘法
     for (kk = 0; kk < N; kk += block_size) {
         for (ii = 0; ii < N; ii += block_size) {
             for (jj = 0; jj < N; jj += block_size) {
                 // 在每个块内进行矩阵乘法
                 for (k = kk; k < kk + block_size && k < N; k++) {
+                    // k == 0 是对C的第一次写入：覆盖而不是累加
+                    int first = (k == 0) && !(flags & MM_ACCUMULATE);
                     for (i = ii; i < ii + block_size && i < N; i++) {
                         int temp = matrixA[i][k];
-                        for (j = jj; j < jj + block_size && j < N; j++) {
-                            matrixC[i][j] += temp * matrixB[k][j];
+                        if (first) {
+                            for (j = jj; j < jj + block_size && j < N; j++) {
+                                matrixC[i][j] = temp * matrixB[k][j];
+                            }
+                        } else {
+                            for (j = jj; j < jj + block_size && j < N; j++) {
+                                matrixC[i][j] += temp * matrixB[k][j];
+                            }
                         }
                     }
                 }
@@ -106,20 +113,25 @@ void matrixmultiply_blocked_adaptive(int N, int **matrixA, int **matrixB, int **
     }
 }
 
+void matrixmultiply_blocked_adaptive(int N, int **matrixA, int **matrixB, int **matrixC) {
+    matrixmultiply_blocked_adaptive_ex(N, matrixA, matrixB, matrixC, MM_OVERWRITE);
+}
+
 // 辅助函数
 int** create_matrix(int N) {
-    int **matrix = (int**)malloc(N * sizeof(int*));
-    for (int i = 0; i < N; i++) {
-        matrix[i] = (int*)malloc(N * sizeof(int));
-    }
-    return matrix;
+    return mm_alloc_matrix(N, N);
 }
 
 void free_matrix(int **matrix, int N) {
-    for (int i = 0; i < N; i++) {
-        free(matrix[i]);
-    }
-    free(matrix);
+    mm_free_matrix(matrix);
+}
+
+void matrix_set_padding(int enabled) {
+    mm_set_padding(enabled);
+}
+
+int matrix_leading_dim(int **matrix, int N) {
+    return mm_matrix_leading_dim(matrix, N);
 }
 
 void init_test_matrices(int N, int **matrixA, int **matrixB) {
@@ -0,0 +1,428 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <string.h>
+#include <immintrin.h>
+#include "matrix_platform.h"
+#include "matrix_transpose.h"
+#include "matrix_kernel.h"
+
+// 二维卷积（int32），转化为矩阵乘法后用分块SIMD内核计算，不再需要完整的im2col缓冲区。
+//
+//   NCHW: 输入[n][c][h][w]，权重[k][c][r][s]，输出[n][k][p][q]
+//         每张图像: O[K x PQ] = W[K x CRS] x col[CRS x PQ]
+//   NHWC: 输入[n][h][w][c]，权重[k][r][s][c]，输出[n][p][q][k]
+//         每张图像: O[PQ x K] = patch[PQ x RSC] x W^T[RSC x K]
+//
+// 两种模式：
+//   MM_CONV_IM2COL   - 分块im2col：每次只展开一个输出分块所需的im2col数据，而不是整张图
+//   MM_CONV_IMPLICIT - 隐式GEMM：打包时直接从输入中收集卷积窗口，只使用一个L2大小的面板缓冲区
+// 完整im2col缓冲区的大小为 CRS x PQ（每张图像），分块后只需 CRS x PANEL_NR 或 PANEL_KC x PANEL_NR。
+
+// 数据布局
+#define MM_NCHW 0
+#define MM_NHWC 1
+
+// 计算模式
+#define MM_CONV_IM2COL   0
+#define MM_CONV_IMPLICIT 1
+
+#define PANEL_NR MM_KERNEL_NR   // 面板宽度（列数），与共享行内核一致
+#define PANEL_KC MM_KERNEL_KC   // k方向的分块大小，使面板块驻留在L2 cache中
+
+// 卷积形状参数
+typedef struct {
+    int batch, in_channels, height, width;
+    int out_channels, kernel_h, kernel_w;
+    int stride_h, stride_w;
+    int pad_h, pad_w;
+    int dilation_h, dilation_w;
+    int layout;
+} ConvShape;
+
+// 步长和膨胀必须为正数（否则输出尺寸的除法没有意义）
+static int conv2d_shape_valid(const ConvShape *shape) {
+    return shape->stride_h > 0 && shape->stride_w > 0 &&
+           shape->dilation_h > 0 && shape->dilation_w > 0;
+}
+
+// 输出特征图的高和宽；步长或膨胀非正时输出0x0
+void conv2d_output_dims(const ConvShape *shape, int *out_h, int *out_w) {
+    if (!conv2d_shape_valid(shape)) {
+        *out_h = *out_w = 0;
+        return;
+    }
+    *out_h = (shape->height + 2 * shape->pad_h - shape->dilation_h * (shape->kernel_h - 1) - 1) / shape->stride_h + 1;
+    *out_w = (shape->width + 2 * shape->pad_w - shape->dilation_w * (shape->kernel_w - 1) - 1) / shape->stride_w + 1;
+}
+
+// 线程参数结构体
+typedef struct {
+    const ConvShape *shape;
+    int out_h, out_w;
+    const int *input;
+    const int *weight;
+    const int *packedW;   // NHWC: 按面板打包的W^T
+    int *output;
+    int mode;
+    int thread_id;
+    int num_threads;
+} ConvThreadParams;
+
+// ==================== NCHW ====================
+
+// NCHW的im2col面板：panel[k'][j] = col[kd_start + k'][pq_start + j]，越界（填充区域）为0
+static void gather_nchw_panel(const ConvShape *s, int out_w, const int *image,
+                              int kd_start, int kc, int pq_start, int ncols, int *panel) {
+    int RS = s->kernel_h * s->kernel_w;
+
+    for (int kp = 0; kp < kc; kp++) {
+        int kd = kd_start + kp;
+        int c = kd / RS;
+        int r = (kd / s->kernel_w) % s->kernel_h;
+        int t = kd % s->kernel_w;
+        const int *plane = image + (size_t)c * s->height * s->width;
+        int *dst = panel + (size_t)kp * PANEL_NR;
+
+        for (int j = 0; j < ncols; j++) {
+            int pq = pq_start + j;
+            int ih = (pq / out_w) * s->stride_h - s->pad_h + r * s->dilation_h;
+            int iw = (pq % out_w) * s->stride_w - s->pad_w + t * s->dilation_w;
+            dst[j] = (ih >= 0 && ih < s->height && iw >= 0 && iw < s->width) ? plane[ih * s->width + iw] : 0;
+        }
+        for (int j = ncols; j < PANEL_NR; j++) {
+            dst[j] = 0;
+        }
+    }
+}
+
+// 任务为(图像, PQ方向的列分块)，每个任务计算所有输出通道
+MM_THREAD_FUNC conv_nchw_thread(void* arg) {
+    ConvThreadParams* params = (ConvThreadParams*)arg;
+    const ConvShape *s = params->shape;
+    int PQ = params->out_h * params->out_w;
+    int CRS = s->in_channels * s->kernel_h * s->kernel_w;
+    int col_tiles = (PQ + PANEL_NR - 1) / PANEL_NR;
+    int num_tasks = s->batch * col_tiles;
+
+    // 分块im2col展开整个深度（CRS x PANEL_NR），隐式GEMM只需一个PANEL_KC x PANEL_NR的面板
+    int depth = (params->mode == MM_CONV_IM2COL) ? CRS : (CRS < PANEL_KC ? CRS : PANEL_KC);
+    int *panel = (int*)mm_aligned_malloc((size_t)depth * PANEL_NR * sizeof(int), 32);
+
+    for (int task = params->thread_id; task < num_tasks; task += params->num_threads) {
+        int n = task / col_tiles;
+        int pq_start = (task % col_tiles) * PANEL_NR;
+        int ncols = (PQ - pq_start < PANEL_NR) ? PQ - pq_start : PANEL_NR;
+        const int *image = params->input + (size_t)n * s->in_channels * s->height * s->width;
+        int *out = params->output + (size_t)n * s->out_channels * PQ + pq_start;
+
+        if (params->mode == MM_CONV_IM2COL) {
+            gather_nchw_panel(s, params->out_w, image, 0, CRS, pq_start, ncols, panel);
+        }
+
+        // CRS == 0 时也要执行一轮，以便把输出清零
+        int kk = 0;
+        do {
+            int kc = (CRS - kk < PANEL_KC) ? CRS - kk : PANEL_KC;
+            const int *block = panel + (size_t)kk * PANEL_NR;
+
+            if (params->mode == MM_CONV_IMPLICIT) {
+                gather_nchw_panel(s, params->out_w, image, kk, kc, pq_start, ncols, panel);
+                block = panel;
+            }
+
+            for (int k = 0; k < s->out_channels; k++) {
+                mm_row_kernel_i32(params->weight + (size_t)k * CRS + kk, 1, block, PANEL_NR, kc,
+                                  out + (size_t)k * PQ, ncols, kk == 0, 0);
+            }
+
+            kk += PANEL_KC;
+        } while (kk < CRS);
+    }
+
+    mm_aligned_free(panel);
+    return MM_THREAD_RETURN;
+}
+
+// ==================== NHWC ====================
+
+// NHWC的一段卷积窗口：row[k'] = patch(p, q)[kd_start + k']，kd按(r, s, c)展开，越界为0
+static void gather_nhwc_patch(const ConvShape *s, const int *image, int p, int q,
+                              int kd_start, int kc, int *row) {
+    int C = s->in_channels;
+    int kd = kd_start;
+    int kd_end = kd_start + kc;
+
+    while (kd < kd_end) {
+        int rs = kd / C;
+        int c = kd % C;
+        int r = rs / s->kernel_w;
+        int t = rs % s->kernel_w;
+        int ih = p * s->stride_h - s->pad_h + r * s->dilation_h;
+        int iw = q * s->stride_w - s->pad_w + t * s->dilation_w;
+
+        // 同一个(r, s)位置的通道在输入中连续存放，整段复制
+        int len = (C - c < kd_end - kd) ? C - c : kd_end - kd;
+        int *dst = row + (kd - kd_start);
+        if (ih >= 0 && ih < s->height && iw >= 0 && iw < s->width) {
+            memcpy(dst, image + ((size_t)ih * s->width + iw) * C + c, len * sizeof(int));
+        } else {
+            memset(dst, 0, len * sizeof(int));
+        }
+        kd += len;
+    }
+}
+
+// 任务为(图像, PQ方向的行分块)，每个任务计算分块内所有输出像素的所有输出通道
+MM_THREAD_FUNC conv_nhwc_thread(void* arg) {
+    ConvThreadParams* params = (ConvThreadParams*)arg;
+    const ConvShape *s = params->shape;
+    int out_w = params->out_w;
+    int PQ = params->out_h * out_w;
+    int K = s->out_channels;
+    int RSC = s->kernel_h * s->kernel_w * s->in_channels;
+    int row_tiles = (PQ + PANEL_NR - 1) / PANEL_NR;
+    int num_tasks = s->batch * row_tiles;
+    int num_panels = (K + PANEL_NR - 1) / PANEL_NR;
+
+    // 分块im2col展开PANEL_NR个完整的窗口，隐式GEMM只需一个窗口片段
+    size_t a_size = (params->mode == MM_CONV_IM2COL) ? (size_t)PANEL_NR * RSC : PANEL_KC;
+    int *a_buf = (int*)malloc((a_size > 0 ? a_size : 1) * sizeof(int));
+
+    for (int task = params->thread_id; task < num_tasks; task += params->num_threads) {
+        int n = task / row_tiles;
+        int pq_start = (task % row_tiles) * PANEL_NR;
+        int nrows = (PQ - pq_start < PANEL_NR) ? PQ - pq_start : PANEL_NR;
+        const int *image = params->input + (size_t)n * s->height * s->width * s->in_channels;
+        int *out = params->output + ((size_t)n * PQ + pq_start) * K;
+
+        if (params->mode == MM_CONV_IM2COL) {
+            for (int i = 0; i < nrows; i++) {
+                int pq = pq_start + i;
+                gather_nhwc_patch(s, image, pq / out_w, pq % out_w, 0, RSC, a_buf + (size_t)i * RSC);
+            }
+        }
+
+        for (int p = 0; p < num_panels; p++) {
+            int jj = p * PANEL_NR;
+            int ncols = (K - jj < PANEL_NR) ? K - jj : PANEL_NR;
+            const int *panel = params->packedW + (size_t)p * RSC * PANEL_NR;
+
+            int kk = 0;
+            do {
+                int kc = (RSC - kk < PANEL_KC) ? RSC - kk : PANEL_KC;
+
+                for (int i = 0; i < nrows; i++) {
+                    const int *a_row;
+                    if (params->mode == MM_CONV_IM2COL) {
+                        a_row = a_buf + (size_t)i * RSC + kk;
+                    } else {
+                        int pq = pq_start + i;
+                        gather_nhwc_patch(s, image, pq / out_w, pq % out_w, kk, kc, a_buf);
+                        a_row = a_buf;
+                    }
+                    mm_row_kernel_i32(a_row, 1, panel + (size_t)kk * PANEL_NR, PANEL_NR, kc,
+                                      out + (size_t)i * K + jj, ncols, kk == 0, 0);
+                }
+
+                kk += PANEL_KC;
+            } while (kk < RSC);
+        }
+    }
+
+    free(a_buf);
+    return MM_THREAD_RETURN;
+}
+
+// 把NHWC权重W[k][rsc]打包为W^T的列面板：第p个面板的第kd行位于 (p * RSC + kd) * PANEL_NR 处
+static int* pack_nhwc_weight(int K, int RSC, const int *weight) {
+    int num_panels = (K + PANEL_NR - 1) / PANEL_NR;
+    int *packed = (int*)mm_aligned_malloc((size_t)num_panels * RSC * PANEL_NR * sizeof(int), 32);
+
+    for (int p = 0; p < num_panels; p++) {
+        int jj = p * PANEL_NR;
+        int width = (K - jj < PANEL_NR) ? K - jj : PANEL_NR;
+        int *panel = packed + (size_t)p * RSC * PANEL_NR;
+
+        // 面板是W中width行的分块转置，不足PANEL_NR的列补0
+        mm_transpose(width, RSC, weight + (size_t)jj * RSC, RSC, panel, PANEL_NR, 1);
+        for (int kd = 0; kd < RSC; kd++) {
+            for (int j = width; j < PANEL_NR; j++) {
+                panel[(size_t)kd * PANEL_NR + j] = 0;
+            }
+        }
+    }
+
+    return packed;
+}
+
+// 卷积入口。layout由shape->layout指定（MM_NCHW / MM_NHWC），mode为MM_CONV_IM2COL或MM_CONV_IMPLICIT，
+// num_threads <= 0 时自动选择线程数。输出形状见conv2d_output_dims
+// 步长或膨胀非正时返回-1且不写输出，否则返回0
+int conv2d(const ConvShape *shape, const int *input, const int *weight, int *output,
+           int mode, int num_threads) {
+    if (!conv2d_shape_valid(shape)) {
+        return -1;
+    }
+    int out_h, out_w;
+    conv2d_output_dims(shape, &out_h, &out_w);
+    if (shape->batch <= 0 || shape->out_channels <= 0 || out_h <= 0 || out_w <= 0) {
+        return 0;
+    }
+
+    if (num_threads <= 0) {
+        // 获取系统CPU核心数
+        num_threads = mm_cpu_count();
+        if (num_threads > 8) num_threads = 8; // 限制线程数
+    }
+
+    int *packedW = NULL;
+    if (shape->layout == MM_NHWC) {
+        int RSC = shape->kernel_h * shape->kernel_w * shape->in_channels;
+        packedW = pack_nhwc_weight(shape->out_channels, RSC, weight);
+    }
+    mm_thread_fn fn = (shape->layout == MM_NHWC) ? conv_nhwc_thread : conv_nchw_thread;
+
+    mm_thread_t* threads = (mm_thread_t*)malloc(num_threads * sizeof(mm_thread_t));
+    ConvThreadParams* params = (ConvThreadParams*)malloc(num_threads * sizeof(ConvThreadParams));
+
+    for (int t = 0; t < num_threads; t++) {
+        params[t].shape = shape;
+        params[t].out_h = out_h;
+        params[t].out_w = out_w;
+        params[t].input = input;
+        params[t].weight = weight;
+        params[t].packedW = packedW;
+        params[t].output = output;
+        params[t].mode = mode;
+        params[t].thread_id = t;
+        params[t].num_threads = num_threads;
+    }
+
+    if (num_threads == 1) {
+        // 单线程时直接在调用线程中计算，避免创建线程的开销
+        fn(&params[0]);
+    } else {
+        for (int t = 0; t < num_threads; t++) {
+            mm_thread_create(&threads[t], fn, &params[t]);
+        }
+
+        mm_thread_join_all(threads, num_threads);
+    }
+
+    free(threads);
+    free(params);
+    if (packedW != NULL) {
+        mm_aligned_free(packedW);
+    }
+    return 0;
+}
+
+#ifdef STANDALONE_TEST
+// 直接按定义计算的参考实现
+static void conv2d_reference(const ConvShape *s, const int *input, const int *weight, int *output) {
+    int P, Q;
+    conv2d_output_dims(s, &P, &Q);
+    int C = s->in_channels, H = s->height, W = s->width, K = s->out_channels;
+    int R = s->kernel_h, S = s->kernel_w;
+
+    for (int n = 0; n < s->batch; n++) {
+        for (int k = 0; k < K; k++) {
+            for (int p = 0; p < P; p++) {
+                for (int q = 0; q < Q; q++) {
+                    int sum = 0;
+                    for (int c = 0; c < C; c++) {
+                        for (int r = 0; r < R; r++) {
+                            for (int t = 0; t < S; t++) {
+                                int ih = p * s->stride_h - s->pad_h + r * s->dilation_h;
+                                int iw = q * s->stride_w - s->pad_w + t * s->dilation_w;
+                                if (ih < 0 || ih >= H || iw < 0 || iw >= W) continue;
+                                if (s->layout == MM_NCHW) {
+                                    sum += input[(((size_t)n * C + c) * H + ih) * W + iw] *
+                                           weight[(((size_t)k * C + c) * R + r) * S + t];
+                                } else {
+                                    sum += input[(((size_t)n * H + ih) * W + iw) * C + c] *
+                                           weight[(((size_t)k * R + r) * S + t) * C + c];
+                                }
+                            }
+                        }
+                    }
+                    if (s->layout == MM_NCHW) {
+                        output[(((size_t)n * K + k) * P + p) * Q + q] = sum;
+                    } else {
+                        output[(((size_t)n * P + p) * Q + q) * K + k] = sum;
+                    }
+                }
+            }
+        }
+    }
+}
+
+static void run_case(const char *name, ConvShape shape) {
+    int P, Q;
+    conv2d_output_dims(&shape, &P, &Q);
+    size_t in_size = (size_t)shape.batch * shape.in_channels * shape.height * shape.width;
+    size_t w_size = (size_t)shape.out_channels * shape.in_channels * shape.kernel_h * shape.kernel_w;
+    size_t out_size = (size_t)shape.batch * shape.out_channels * P * Q;
+    size_t crs = (size_t)shape.in_channels * shape.kernel_h * shape.kernel_w;
+
+    int *input = (int*)malloc(in_size * sizeof(int));
+    int *weight = (int*)malloc(w_size * sizeof(int));
+    int *output = (int*)malloc(out_size * sizeof(int));
+    int *reference = (int*)malloc(out_size * sizeof(int));
+    for (size_t i = 0; i < in_size; i++) input[i] = (int)(i % 17) - 8;
+    for (size_t i = 0; i < w_size; i++) weight[i] = (int)(i % 7) - 3;
+
+    printf("\n%s: N=%d C=%d H=%d W=%d K=%d R=%d S=%d stride=%d pad=%d dilation=%d -> %dx%d\n",
+           name, shape.batch, shape.in_channels, shape.height, shape.width, shape.out_channels,
+           shape.kernel_h, shape.kernel_w, shape.stride_h, shape.pad_h, shape.dilation_h, P, Q);
+    // 隐式GEMM：NCHW为一个面板块，NHWC只需一段卷积窗口
+    size_t implicit_size = (shape.layout == MM_NCHW) ? (crs < PANEL_KC ? crs : PANEL_KC) * PANEL_NR : PANEL_KC;
+    printf("完整im2col缓冲区: %.2f MB, 分块im2col: %.3f MB/线程, 隐式GEMM: %.3f MB/线程\n",
+           crs * P * Q * shape.batch * sizeof(int) / 1048576.0,
+           crs * PANEL_NR * sizeof(int) / 1048576.0,
+           implicit_size * sizeof(int) / 1048576.0);
+
+    conv2d_reference(&shape, input, weight, reference);
+
+    const char *mode_names[] = {"分块im2col", "隐式GEMM"};
+    for (int mode = MM_CONV_IM2COL; mode <= MM_CONV_IMPLICIT; mode++) {
+        clock_t start = clock();
+        conv2d(&shape, input, weight, output, mode, 0);
+        clock_t end = clock();
+        int correct = memcmp(output, reference, out_size * sizeof(int)) == 0;
+        printf("  %s: %.4f 秒, %s\n", mode_names[mode], ((double)(end - start)) / CLOCKS_PER_SEC,
+               correct ? "正确" : "错误");
+    }
+
+    free(input);
+    free(weight);
+    free(output);
+    free(reference);
+}
+
+int main() {
+    printf("测试卷积（im2col / 隐式GEMM）\n");
+
+    ConvShape shape = {4, 64, 56, 56, 64, 3, 3, 1, 1, 1, 1, 1, 1, MM_NCHW};
+    run_case("NCHW 3x3卷积", shape);
+    shape.layout = MM_NHWC;
+    run_case("NHWC 3x3卷积", shape);
+
+    // 步长、填充、膨胀和非方形卷积核
+    ConvShape odd = {2, 3, 31, 29, 70, 5, 3, 2, 2, 2, 1, 2, 1, MM_NCHW};
+    run_case("NCHW 步长2/膨胀2", odd);
+    odd.layout = MM_NHWC;
+    run_case("NHWC 步长2/膨胀2", odd);
+
+    // 步长为0应被拒绝，而不是触发除零
+    ConvShape bad = odd;
+    bad.stride_w = 0;
+    int bad_p, bad_q;
+    conv2d_output_dims(&bad, &bad_p, &bad_q);
+    int rejected = conv2d(&bad, NULL, NULL, NULL, MM_CONV_IMPLICIT, 0) == -1 && bad_p == 0 && bad_q == 0;
+    printf("\n步长为0: %s\n", rejected ? "已拒绝" : "错误");
+
+    return 0;
+}
+#endif
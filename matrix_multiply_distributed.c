@@ -0,0 +1,559 @@
+// 多进程分布式矩阵乘法（SUMMA算法）
+// P = q x q 个进程组成二维进程网格，进程(r, c)持有A、B、C各自的第(r, c)块。
+// 第t步时，A的第t列块沿进程行广播，B的第t行块沿进程列广播，各进程用分块SIMD内核累加本地C块。
+// 每个进程有一个通信线程负责面板广播，计算线程在计算第t步的同时，通信线程已经在接收第t+1步的面板（双缓冲）。
+//
+// 传输层是可替换的（Transport），默认实现为本机进程间的Unix域套接字全互联，
+// 输入/输出矩阵通过共享内存分发和收集，因此可以在单机上完整测试。
+// 注意：本文件依赖fork、Unix域套接字和pthread，需要POSIX环境（Linux/WSL）编译运行。
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <immintrin.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+// ==================== 可替换的传输层 ====================
+
+typedef struct Transport Transport;
+
+struct Transport {
+    int rank;
+    int size;
+    // 发送/接收恰好bytes字节，成功返回0，失败返回-1
+    int (*send)(Transport *t, int peer, const void *buf, size_t bytes);
+    int (*recv)(Transport *t, int peer, void *buf, size_t bytes);
+    void (*destroy)(Transport *t);
+    void *impl;
+};
+
+// 传输层工厂：create在fork之前由父进程调用，attach在每个子进程中得到本进程的端点，
+// release在所有子进程结束后由父进程调用
+typedef struct {
+    const char *name;
+    void* (*create)(int size);
+    Transport* (*attach)(void *shared, int rank);
+    void (*release)(void *shared);
+} TransportFactory;
+
+// ---------- 默认实现：Unix域套接字全互联 ----------
+
+typedef struct {
+    int size;
+    int *fds;   // fds[i * size + j]: 进程i用来和进程j通信的套接字
+} SocketMesh;
+
+static void* socket_mesh_create(int size) {
+    SocketMesh *mesh = (SocketMesh*)malloc(sizeof(SocketMesh));
+    mesh->size = size;
+    mesh->fds = (int*)malloc(size * size * sizeof(int));
+    for (int i = 0; i < size * size; i++) {
+        mesh->fds[i] = -1;
+    }
+
+    for (int i = 0; i < size; i++) {
+        for (int j = i + 1; j < size; j++) {
+            int pair[2];
+            if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0) {
+                perror("socketpair");
+                return NULL;
+            }
+            mesh->fds[i * size + j] = pair[0];
+            mesh->fds[j * size + i] = pair[1];
+        }
+    }
+
+    return mesh;
+}
+
+static int socket_send(Transport *t, int peer, const void *buf, size_t bytes) {
+    SocketMesh *mesh = (SocketMesh*)t->impl;
+    int fd = mesh->fds[t->rank * mesh->size + peer];
+    const char *p = (const char*)buf;
+
+    while (bytes > 0) {
+        ssize_t n = write(fd, p, bytes);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += n;
+        bytes -= n;
+    }
+    return 0;
+}
+
+static int socket_recv(Transport *t, int peer, void *buf, size_t bytes) {
+    SocketMesh *mesh = (SocketMesh*)t->impl;
+    int fd = mesh->fds[t->rank * mesh->size + peer];
+    char *p = (char*)buf;
+
+    while (bytes > 0) {
+        ssize_t n = read(fd, p, bytes);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (n == 0) {
+            return -1; // 对端提前关闭
+        }
+        p += n;
+        bytes -= n;
+    }
+    return 0;
+}
+
+static void socket_destroy(Transport *t) {
+    SocketMesh *mesh = (SocketMesh*)t->impl;
+    for (int j = 0; j < mesh->size; j++) {
+        if (mesh->fds[t->rank * mesh->size + j] >= 0) {
+            close(mesh->fds[t->rank * mesh->size + j]);
+        }
+    }
+    free(t);
+}
+
+static Transport* socket_mesh_attach(void *shared, int rank) {
+    SocketMesh *mesh = (SocketMesh*)shared;
+
+    // 关闭不属于本进程的套接字端点，使对端退出时能检测到EOF
+    for (int i = 0; i < mesh->size; i++) {
+        if (i == rank) continue;
+        for (int j = 0; j < mesh->size; j++) {
+            if (mesh->fds[i * mesh->size + j] >= 0) {
+                close(mesh->fds[i * mesh->size + j]);
+                mesh->fds[i * mesh->size + j] = -1;
+            }
+        }
+    }
+
+    Transport *t = (Transport*)malloc(sizeof(Transport));
+    t->rank = rank;
+    t->size = mesh->size;
+    t->send = socket_send;
+    t->recv = socket_recv;
+    t->destroy = socket_destroy;
+    t->impl = mesh;
+    return t;
+}
+
+static void socket_mesh_release(void *shared) {
+    SocketMesh *mesh = (SocketMesh*)shared;
+    for (int i = 0; i < mesh->size * mesh->size; i++) {
+        if (mesh->fds[i] >= 0) {
+            close(mesh->fds[i]);
+        }
+    }
+    free(mesh->fds);
+    free(mesh);
+}
+
+const TransportFactory unix_socket_transport = {
+    "unix-socket",
+    socket_mesh_create,
+    socket_mesh_attach,
+    socket_mesh_release
+};
+
+// ==================== 本地计算内核 ====================
+
+// 与matrixmultiply_simd_blocked相同的分块 + AVX2内核，推广到连续存储的矩形块：
+// C[m x n] (+)= A[m x kw] * B[kw x n]，first非0时覆盖C
+static void local_gemm_simd_blocked(int m, int n, int kw,
+                                    const int *A, int lda, const int *B, int ldb,
+                                    int *C, int ldc, int first) {
+    const int BLOCK_SIZE = 64;
+
+    for (int kk = 0; kk < kw; kk += BLOCK_SIZE) {
+        int kk_end = (kk + BLOCK_SIZE < kw) ? kk + BLOCK_SIZE : kw;
+
+        for (int ii = 0; ii < m; ii += BLOCK_SIZE) {
+            int ii_end = (ii + BLOCK_SIZE < m) ? ii + BLOCK_SIZE : m;
+
+            for (int jj = 0; jj < n; jj += BLOCK_SIZE) {
+                int jj_end = (jj + BLOCK_SIZE < n) ? jj + BLOCK_SIZE : n;
+                int j_simd = jj + ((jj_end - jj) / 8) * 8;
+
+                for (int k = kk; k < kk_end; k++) {
+                    // 只有整个乘积的第一个k才覆盖C
+                    int overwrite = first && (k == 0);
+
+                    for (int i = ii; i < ii_end; i++) {
+                        int a = A[(size_t)i * lda + k];
+                        __m256i a_broadcast = _mm256_set1_epi32(a);
+                        const int *b_row = &B[(size_t)k * ldb];
+                        int *c_row = &C[(size_t)i * ldc];
+
+                        for (int j = jj; j < j_simd; j += 8) {
+                            __m256i b_vec = _mm256_loadu_si256((__m256i*)&b_row[j]);
+                            __m256i prod = _mm256_mullo_epi32(a_broadcast, b_vec);
+                            __m256i result = overwrite ? prod :
+                                _mm256_add_epi32(_mm256_loadu_si256((__m256i*)&c_row[j]), prod);
+                            _mm256_storeu_si256((__m256i*)&c_row[j], result);
+                        }
+
+                        for (int j = j_simd; j < jj_end; j++) {
+                            if (overwrite) {
+                                c_row[j] = a * b_row[j];
+                            } else {
+                                c_row[j] += a * b_row[j];
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// ==================== SUMMA ====================
+
+// 第r个进程行/列负责的全局下标区间 [block_start(r), block_start(r + 1))
+static int block_start(int N, int q, int r) {
+    return (int)((long long)N * r / q);
+}
+
+// 每个进程的SUMMA状态（计算线程与通信线程共享）
+typedef struct {
+    Transport *transport;
+    int N, q, row, col;
+
+    // 本地持有的A、B块（连续存储）
+    int *A_local, *B_local;
+    int my_rows, my_cols;
+    int a_width, b_height; // 本地A块的列数、本地B块的行数
+
+    // 双缓冲的面板：A面板为 my_rows x kw，B面板为 kw x my_cols
+    int *A_panel[2], *B_panel[2];
+
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int steps_received;  // 已收到面板的步数
+    int steps_computed;  // 已完成计算的步数
+    int failed;
+} SummaState;
+
+// 通信线程：按步骤顺序完成面板广播，提前一步接收下一步的面板
+static void* summa_comm_thread(void *arg) {
+    SummaState *s = (SummaState*)arg;
+    Transport *t = s->transport;
+    int q = s->q;
+
+    for (int step = 0; step < q; step++) {
+        int buf = step % 2;
+        int kw = block_start(s->N, q, step + 1) - block_start(s->N, q, step);
+        size_t a_bytes = (size_t)s->my_rows * kw * sizeof(int);
+        size_t b_bytes = (size_t)kw * s->my_cols * sizeof(int);
+        int ok = 1;
+
+        // 等待该缓冲区上一次（step - 2）的计算完成
+        pthread_mutex_lock(&s->lock);
+        while (s->steps_computed < step - 1 && !s->failed) {
+            pthread_cond_wait(&s->cond, &s->lock);
+        }
+        pthread_mutex_unlock(&s->lock);
+
+        // A的第step列块沿进程行广播：所有者为(row, step)
+        if (s->col == step) {
+            memcpy(s->A_panel[buf], s->A_local, a_bytes);
+            for (int c = 0; c < q && ok; c++) {
+                if (c != s->col) {
+                    ok = t->send(t, s->row * q + c, s->A_panel[buf], a_bytes) == 0;
+                }
+            }
+        } else {
+            ok = t->recv(t, s->row * q + step, s->A_panel[buf], a_bytes) == 0;
+        }
+
+        // B的第step行块沿进程列广播：所有者为(step, col)
+        if (ok && s->row == step) {
+            memcpy(s->B_panel[buf], s->B_local, b_bytes);
+            for (int r = 0; r < q && ok; r++) {
+                if (r != s->row) {
+                    ok = t->send(t, r * q + s->col, s->B_panel[buf], b_bytes) == 0;
+                }
+            }
+        } else if (ok) {
+            ok = t->recv(t, step * q + s->col, s->B_panel[buf], b_bytes) == 0;
+        }
+
+        pthread_mutex_lock(&s->lock);
+        if (ok) {
+            s->steps_received = step + 1;
+        } else {
+            s->failed = 1;
+        }
+        pthread_cond_broadcast(&s->cond);
+        pthread_mutex_unlock(&s->lock);
+
+        if (!ok) break;
+    }
+
+    return NULL;
+}
+
+// 单个进程上执行的SUMMA，A_global/B_global/C_global为共享内存中的N x N连续矩阵
+static int summa_worker(Transport *t, int q, int N,
+                        const int *A_global, const int *B_global, int *C_global) {
+    SummaState s;
+    memset(&s, 0, sizeof(s));
+    s.transport = t;
+    s.N = N;
+    s.q = q;
+    s.row = t->rank / q;
+    s.col = t->rank % q;
+
+    int r0 = block_start(N, q, s.row), r1 = block_start(N, q, s.row + 1);
+    int c0 = block_start(N, q, s.col), c1 = block_start(N, q, s.col + 1);
+    s.my_rows = r1 - r0;
+    s.my_cols = c1 - c0;
+    s.a_width = c1 - c0;
+    s.b_height = r1 - r0;
+
+    // 从共享内存中取出本进程的A(row, col)和B(row, col)块（相当于scatter）
+    s.A_local = (int*)malloc((size_t)s.my_rows * s.a_width * sizeof(int));
+    s.B_local = (int*)malloc((size_t)s.b_height * s.my_cols * sizeof(int));
+    for (int i = 0; i < s.my_rows; i++) {
+        memcpy(&s.A_local[(size_t)i * s.a_width], &A_global[(size_t)(r0 + i) * N + c0], s.a_width * sizeof(int));
+    }
+    for (int i = 0; i < s.b_height; i++) {
+        memcpy(&s.B_local[(size_t)i * s.my_cols], &B_global[(size_t)(r0 + i) * N + c0], s.my_cols * sizeof(int));
+    }
+
+    int max_kw = 0;
+    for (int step = 0; step < q; step++) {
+        int kw = block_start(N, q, step + 1) - block_start(N, q, step);
+        if (kw > max_kw) max_kw = kw;
+    }
+    for (int b = 0; b < 2; b++) {
+        s.A_panel[b] = (int*)malloc((size_t)s.my_rows * max_kw * sizeof(int));
+        s.B_panel[b] = (int*)malloc((size_t)max_kw * s.my_cols * sizeof(int));
+    }
+    int *C_local = (int*)malloc((size_t)s.my_rows * s.my_cols * sizeof(int));
+
+    pthread_mutex_init(&s.lock, NULL);
+    pthread_cond_init(&s.cond, NULL);
+
+    pthread_t comm;
+    pthread_create(&comm, NULL, summa_comm_thread, &s);
+
+    // 计算线程：第step步的面板到达后立即计算，同时通信线程接收下一步的面板
+    for (int step = 0; step < q; step++) {
+        pthread_mutex_lock(&s.lock);
+        while (s.steps_received <= step && !s.failed) {
+            pthread_cond_wait(&s.cond, &s.lock);
+        }
+        int failed = s.failed;
+        pthread_mutex_unlock(&s.lock);
+        if (failed) break;
+
+        int kw = block_start(N, q, step + 1) - block_start(N, q, step);
+        local_gemm_simd_blocked(s.my_rows, s.my_cols, kw,
+                                s.A_panel[step % 2], kw, s.B_panel[step % 2], s.my_cols,
+                                C_local, s.my_cols, step == 0);
+
+        pthread_mutex_lock(&s.lock);
+        s.steps_computed = step + 1;
+        pthread_cond_broadcast(&s.cond);
+        pthread_mutex_unlock(&s.lock);
+    }
+
+    pthread_join(comm, NULL);
+
+    // 写回本进程的C块（相当于gather）
+    if (!s.failed) {
+        for (int i = 0; i < s.my_rows; i++) {
+            memcpy(&C_global[(size_t)(r0 + i) * N + c0], &C_local[(size_t)i * s.my_cols], s.my_cols * sizeof(int));
+        }
+    }
+
+    pthread_mutex_destroy(&s.lock);
+    pthread_cond_destroy(&s.cond);
+    free(s.A_local);
+    free(s.B_local);
+    for (int b = 0; b < 2; b++) {
+        free(s.A_panel[b]);
+        free(s.B_panel[b]);
+    }
+    free(C_local);
+
+    return s.failed ? -1 : 0;
+}
+
+// 使用指定传输层的分布式乘法。num_procs必须是完全平方数q²（q x q进程网格），且q <= N。
+// 成功返回0，失败返回-1
+int matrixmultiply_distributed_ex(int N, int **matrixA, int **matrixB, int **matrixC,
+                                  int num_procs, const TransportFactory *factory) {
+    int q = (int)(sqrt((double)num_procs) + 0.5);
+    if (q < 1 || q * q != num_procs || q > N) {
+        printf("Distributed multiply needs a perfect-square process count q*q with q <= N (N = %d), got %d\n",
+               N, num_procs);
+        return -1;
+    }
+
+    // 共享内存中存放全局A、B、C
+    size_t bytes = (size_t)N * N * sizeof(int);
+    int *shared = (int*)mmap(NULL, 3 * bytes, PROT_READ | PROT_WRITE,
+                             MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED) {
+        perror("mmap");
+        return -1;
+    }
+    int *A_global = shared;
+    int *B_global = shared + (size_t)N * N;
+    int *C_global = shared + 2 * (size_t)N * N;
+
+    for (int i = 0; i < N; i++) {
+        memcpy(&A_global[(size_t)i * N], matrixA[i], N * sizeof(int));
+        memcpy(&B_global[(size_t)i * N], matrixB[i], N * sizeof(int));
+    }
+
+    void *transport_shared = factory->create(num_procs);
+    if (!transport_shared) {
+        munmap(shared, 3 * bytes);
+        return -1;
+    }
+
+    pid_t *pids = (pid_t*)malloc(num_procs * sizeof(pid_t));
+    int spawned = 0;
+
+    for (int rank = 0; rank < num_procs; rank++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            Transport *t = factory->attach(transport_shared, rank);
+            int rc = summa_worker(t, q, N, A_global, B_global, C_global);
+            t->destroy(t);
+            _exit(rc == 0 ? 0 : 1);
+        }
+        if (pid < 0) {
+            perror("fork");
+            break;
+        }
+        pids[spawned++] = pid;
+    }
+
+    // 父进程关闭自己持有的全部端点，子进程间的连接才能在出错时正确断开
+    factory->release(transport_shared);
+
+    int result = (spawned == num_procs) ? 0 : -1;
+    for (int i = 0; i < spawned; i++) {
+        int status;
+        waitpid(pids[i], &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            result = -1;
+        }
+    }
+
+    if (result == 0) {
+        for (int i = 0; i < N; i++) {
+            memcpy(matrixC[i], &C_global[(size_t)i * N], N * sizeof(int));
+        }
+    }
+
+    free(pids);
+    munmap(shared, 3 * bytes);
+    return result;
+}
+
+int matrixmultiply_distributed(int N, int **matrixA, int **matrixB, int **matrixC, int num_procs) {
+    return matrixmultiply_distributed_ex(N, matrixA, matrixB, matrixC, num_procs, &unix_socket_transport);
+}
+
+// 辅助函数
+int** create_matrix(int N) {
+    int **matrix = (int**)malloc(N * sizeof(int*));
+    for (int i = 0; i < N; i++) {
+        matrix[i] = (int*)malloc(N * sizeof(int));
+    }
+    return matrix;
+}
+
+void free_matrix(int **matrix, int N) {
+    for (int i = 0; i < N; i++) {
+        free(matrix[i]);
+    }
+    free(matrix);
+}
+
+void init_test_matrices(int N, int **matrixA, int **matrixB) {
+    for (int i = 0; i < N; i++) {
+        for (int j = 0; j < N; j++) {
+            matrixA[i][j] = i + j;
+            matrixB[i][j] = i * j + 1;
+        }
+    }
+}
+
+int verify_result(int N, int **matrixC, int **reference) {
+    for (int i = 0; i < N; i++) {
+        for (int j = 0; j < N; j++) {
+            if (matrixC[i][j] != reference[i][j]) {
+                return 0; // 不匹配
+            }
+        }
+    }
+    return 1; // 匹配
+}
+
+#ifdef STANDALONE_TEST
+static double wall_time() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv) {
+    int N = 1024; // 测试矩阵大小
+    int max_procs = 16;
+    if (argc > 1) N = atoi(argv[1]);
+    if (argc > 2) max_procs = atoi(argv[2]);
+
+    printf("测试分布式SUMMA矩阵乘法，矩阵大小: %dx%d，传输层: %s\n", N, N, unix_socket_transport.name);
+
+    int **matrixA = create_matrix(N);
+    int **matrixB = create_matrix(N);
+    int **matrixC = create_matrix(N);
+    int **reference = create_matrix(N);
+
+    init_test_matrices(N, matrixA, matrixB);
+
+    // 单进程结果作为基准
+    double start = wall_time();
+    if (matrixmultiply_distributed(N, matrixA, matrixB, reference, 1) != 0) {
+        printf("单进程运行失败\n");
+        return 1;
+    }
+    double time_1 = wall_time() - start;
+
+    printf("\n%8s %12s %10s %10s %8s\n", "进程数", "时间(秒)", "加速比", "效率", "结果");
+    printf("%8d %12.4f %10.2f %9.0f%% %8s\n", 1, time_1, 1.0, 100.0, "基准");
+
+    // 从1到P个进程的扩展性（进程数需为完全平方数）
+    for (int q = 2; q * q <= max_procs; q++) {
+        int P = q * q;
+        start = wall_time();
+        int rc = matrixmultiply_distributed(N, matrixA, matrixB, matrixC, P);
+        double elapsed = wall_time() - start;
+
+        const char *status = (rc == 0 && verify_result(N, matrixC, reference)) ? "正确" : "错误";
+        printf("%8d %12.4f %10.2f %9.0f%% %8s\n", P, elapsed, time_1 / elapsed,
+               100.0 * time_1 / elapsed / P, status);
+    }
+
+    free_matrix(matrixA, N);
+    free_matrix(matrixB, N);
+    free_matrix(matrixC, N);
+    free_matrix(reference, N);
+
+    return 0;
+}
+#endif
@@ -0,0 +1,346 @@
+#define _POSIX_C_SOURCE 200809L  // clock_gettime
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <immintrin.h>
+#include "matrix_platform.h"
+#include "matrix_layout.h"
+#include "matrix_kernel.h"
+
+// 16位浮点存储、float32累加的矩阵乘法：C[M x N] (+)= A[M x K] x B[K x N]，
+// A、B以16位格式存放（内存和带宽是float32的一半），C为float32。
+//   MM_FP16 - IEEE半精度：1位符号、5位指数、10位尾数，用F16C指令（_mm256_cvtph_ps）转换
+//   MM_BF16 - bfloat16：float32的高16位（8位指数、7位尾数），范围与float32相同，转换只需移位
+// 转换在打包时完成：每个k分块的B面板由各线程分担转换一次后共用，A的行块由各线程自己转换，
+// 内层循环与float32版本完全相同，是8个ymm累加器上的FMA。
+// 矩阵按行主序存放，lda / ldb / ldc为行间距（元素个数）。
+
+// 16位格式
+#define MM_FP16 0
+#define MM_BF16 1
+
+#define HALF_NR MM_KERNEL_NR   // 面板宽度（列数），与共享行内核一致
+#define HALF_KC MM_KERNEL_KC   // k方向的分块大小，使float32面板块(64KB)驻留在L2 cache中
+
+// ==================== 格式转换 ====================
+
+static inline float bf16_to_float_scalar(uint16_t h) {
+    uint32_t bits = (uint32_t)h << 16;
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+// 就近舍入到偶数；NaN保持为（安静的）NaN
+static inline uint16_t float_to_bf16_scalar(float f) {
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    if ((bits & 0x7FFFFFFF) > 0x7F800000) {
+        return (uint16_t)((bits >> 16) | 0x0040);
+    }
+    bits += 0x7FFF + ((bits >> 16) & 1);
+    return (uint16_t)(bits >> 16);
+}
+
+static inline float fp16_to_float_scalar(uint16_t h) {
+    return _cvtsh_ss(h);
+}
+
+static inline uint16_t float_to_fp16_scalar(float f) {
+    return (uint16_t)_cvtss_sh(f, _MM_FROUND_TO_NEAREST_INT);
+}
+
+// 8个16位值 -> 8个float32
+static inline __m256 half8_to_float(const uint16_t *src, int format) {
+    __m128i h = _mm_loadu_si128((const __m128i*)src);
+    if (format == MM_BF16) {
+        return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(h), 16));
+    }
+    return _mm256_cvtph_ps(h);
+}
+
+// 8个float32 -> 8个16位值
+static inline void float8_to_half(__m256 v, uint16_t *dst, int format) {
+    __m128i h;
+    if (format == MM_BF16) {
+        __m256i bits = _mm256_castps_si256(v);
+        __m256i lsb = _mm256_and_si256(_mm256_srli_epi32(bits, 16), _mm256_set1_epi32(1));
+        __m256i rounded = _mm256_srli_epi32(_mm256_add_epi32(bits, _mm256_add_epi32(lsb, _mm256_set1_epi32(0x7FFF))), 16);
+        __m256i quiet_nan = _mm256_or_si256(_mm256_srli_epi32(bits, 16), _mm256_set1_epi32(0x0040));
+        __m256 is_nan = _mm256_cmp_ps(v, v, _CMP_UNORD_Q);
+        rounded = _mm256_blendv_epi8(rounded, quiet_nan, _mm256_castps_si256(is_nan));
+        // 32位 -> 16位：packus在每个128位通道内打包，再把两个通道的低64位拼到一起
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(rounded, rounded), 0x08);
+        h = _mm256_castsi256_si128(packed);
+    } else {
+        h = _mm256_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT);
+    }
+    _mm_storeu_si128((__m128i*)dst, h);
+}
+
+// 批量转换：float32 -> 16位格式（就近舍入到偶数）
+void half_from_float(const float *src, uint16_t *dst, long long n, int format) {
+    long long i = 0;
+    for (; i + 8 <= n; i += 8) {
+        float8_to_half(_mm256_loadu_ps(src + i), dst + i, format);
+    }
+    for (; i < n; i++) {
+        dst[i] = (format == MM_BF16) ? float_to_bf16_scalar(src[i]) : float_to_fp16_scalar(src[i]);
+    }
+}
+
+// 批量转换：16位格式 -> float32（精确）
+void half_to_float(const uint16_t *src, float *dst, long long n, int format) {
+    long long i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(dst + i, half8_to_float(src + i, format));
+    }
+    for (; i < n; i++) {
+        dst[i] = (format == MM_BF16) ? bf16_to_float_scalar(src[i]) : fp16_to_float_scalar(src[i]);
+    }
+}
+
+// 转换一段连续的16位值到float32，不足8个的部分逐个转换
+static inline void convert_span(const uint16_t *src, float *dst, int n, int format) {
+    int j = 0;
+    for (; j + 8 <= n; j += 8) {
+        _mm256_store_ps(dst + j, half8_to_float(src + j, format));
+    }
+    for (; j < n; j++) {
+        dst[j] = (format == MM_BF16) ? bf16_to_float_scalar(src[j]) : fp16_to_float_scalar(src[j]);
+    }
+}
+
+// ==================== 矩阵乘法 ====================
+
+// 线程参数结构体
+typedef struct {
+    int N, K;
+    int format;
+    const uint16_t *A;
+    long long lda;
+    const uint16_t *B;
+    long long ldb;
+    float *C;
+    long long ldc;
+    int start_row;
+    int end_row;
+    int flags;
+    float *a_pack;          // 本线程的A行块缓冲区(rows x HALF_KC)
+    float *b_pack;          // 所有线程共用的B面板块，第p个面板位于 p * HALF_KC * HALF_NR 处
+    int start_panel;        // 转换阶段本线程负责的面板范围
+    int end_panel;
+    int kk, kc;             // 当前的k分块
+} HalfThreadParams;
+
+// 转换阶段：把B的当前k分块中本线程负责的面板转换为float32，不足HALF_NR的列补0
+MM_THREAD_FUNC half_convert_function(void* arg) {
+    HalfThreadParams* params = (HalfThreadParams*)arg;
+    for (int p = params->start_panel; p < params->end_panel; p++) {
+        int jj = p * HALF_NR;
+        int ncols = (params->N - jj < HALF_NR) ? params->N - jj : HALF_NR;
+        for (int k = 0; k < params->kc; k++) {
+            float *dst = params->b_pack + ((size_t)p * HALF_KC + k) * HALF_NR;
+            convert_span(params->B + (params->kk + k) * params->ldb + jj, dst, ncols, params->format);
+            for (int j = ncols; j < HALF_NR; j++) {
+                dst[j] = 0.0f;
+            }
+        }
+    }
+    return MM_THREAD_RETURN;
+}
+
+// 计算阶段：转换本线程的A行块，再与共用的B面板块相乘
+MM_THREAD_FUNC half_thread_function(void* arg) {
+    HalfThreadParams* params = (HalfThreadParams*)arg;
+    int N = params->N, kc = params->kc;
+    int rows = params->end_row - params->start_row;
+    int first = (params->kk == 0) && !(params->flags & MM_ACCUMULATE);
+
+    for (int i = 0; i < rows; i++) {
+        convert_span(params->A + (params->start_row + i) * params->lda + params->kk,
+                     params->a_pack + (size_t)i * HALF_KC, kc, params->format);
+    }
+
+    for (int jj = 0; jj < N; jj += HALF_NR) {
+        int ncols = (N - jj < HALF_NR) ? N - jj : HALF_NR;
+        const float *panel = params->b_pack + (size_t)(jj / HALF_NR) * HALF_KC * HALF_NR;
+        for (int i = 0; i < rows; i++) {
+            mm_row_kernel_f32(params->a_pack + (size_t)i * HALF_KC, 1, panel, HALF_NR, kc,
+                              params->C + (params->start_row + i) * params->ldc + jj, ncols, first);
+        }
+    }
+    return MM_THREAD_RETURN;
+}
+
+static void half_run_threads(mm_thread_t *threads, HalfThreadParams *params, int num_threads,
+                             mm_thread_fn fn) {
+    if (num_threads == 1) {
+        // 单线程时直接在调用线程中计算，避免创建线程的开销
+        fn(&params[0]);
+        return;
+    }
+    for (int t = 0; t < num_threads; t++) {
+        mm_thread_create(&threads[t], fn, &params[t]);
+    }
+    mm_thread_join_all(threads, num_threads);
+}
+
+// 16位存储的矩阵乘法。format为MM_FP16或MM_BF16（否则返回-1），flags为MM_OVERWRITE或MM_ACCUMULATE，
+// num_threads <= 0时自动选择线程数。
+// 每个k分块分两个阶段：先由各线程分担把B的整行面板块(HALF_KC x N)转换为float32，
+// 再各自计算自己的行，这样B的每个元素只转换一次，而不是每个线程各转换一遍
+int matrixmultiply_half(int M, int N, int K, int format,
+                        const uint16_t *A, long long lda, const uint16_t *B, long long ldb,
+                        float *C, long long ldc, int flags, int num_threads) {
+    if (format != MM_FP16 && format != MM_BF16) {
+        return -1;
+    }
+    if (M <= 0 || N <= 0) {
+        return 0;
+    }
+
+    if (num_threads <= 0) {
+        // 获取系统CPU核心数
+        num_threads = mm_cpu_count();
+        if (num_threads > 8) num_threads = 8; // 限制线程数
+    }
+    if (num_threads > M) num_threads = M;
+
+    mm_thread_t* threads = (mm_thread_t*)malloc(num_threads * sizeof(mm_thread_t));
+    HalfThreadParams* params = (HalfThreadParams*)malloc(num_threads * sizeof(HalfThreadParams));
+
+    int num_panels = (N + HALF_NR - 1) / HALF_NR;
+    float *b_pack = (float*)mm_aligned_malloc((size_t)num_panels * HALF_KC * HALF_NR * sizeof(float), 32);
+
+    int rows_per_thread = M / num_threads;
+    int remaining_rows = M % num_threads;
+
+    for (int t = 0; t < num_threads; t++) {
+        params[t].N = N;
+        params[t].K = K;
+        params[t].format = format;
+        params[t].A = A;
+        params[t].lda = lda;
+        params[t].B = B;
+        params[t].ldb = ldb;
+        params[t].C = C;
+        params[t].ldc = ldc;
+        params[t].start_row = t * rows_per_thread;
+        params[t].end_row = (t + 1) * rows_per_thread;
+        params[t].flags = flags;
+
+        // 最后一个线程处理剩余的行
+        if (t == num_threads - 1) {
+            params[t].end_row += remaining_rows;
+        }
+
+        params[t].a_pack = (float*)mm_aligned_malloc(
+            (size_t)(params[t].end_row - params[t].start_row) * HALF_KC * sizeof(float), 32);
+        params[t].b_pack = b_pack;
+        params[t].start_panel = (int)((long long)num_panels * t / num_threads);
+        params[t].end_panel = (int)((long long)num_panels * (t + 1) / num_threads);
+    }
+
+    // K == 0 时也要执行一轮，以便在覆盖模式下把C清零
+    int kk = 0;
+    do {
+        int kc = (K - kk < HALF_KC) ? K - kk : HALF_KC;
+        for (int t = 0; t < num_threads; t++) {
+            params[t].kk = kk;
+            params[t].kc = kc;
+        }
+
+        half_run_threads(threads, params, num_threads, half_convert_function);
+        half_run_threads(threads, params, num_threads, half_thread_function);
+
+        kk += HALF_KC;
+    } while (kk < K);
+
+    for (int t = 0; t < num_threads; t++) {
+        mm_aligned_free(params[t].a_pack);
+    }
+    mm_aligned_free(b_pack);
+    free(threads);
+    free(params);
+    return 0;
+}
+
+#ifdef STANDALONE_TEST
+// 墙上时间（秒）：矩阵乘法是多线程的，clock()统计的是所有线程的CPU时间之和
+static double wall_time() {
+#ifdef _WIN32
+    LARGE_INTEGER freq, counter;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+}
+
+int main() {
+    int N = 1024; // 测试矩阵大小
+    const char *names[] = {"fp16", "bf16"};
+    printf("测试16位存储矩阵乘法，矩阵大小: %dx%d\n", N, N);
+
+    size_t count = (size_t)N * N;
+    float *A = (float*)malloc(count * sizeof(float));
+    float *B = (float*)malloc(count * sizeof(float));
+    float *C = (float*)malloc(count * sizeof(float));
+    uint16_t *A16 = (uint16_t*)malloc(count * sizeof(uint16_t));
+    uint16_t *B16 = (uint16_t*)malloc(count * sizeof(uint16_t));
+
+    // [-1, 1)内的伪随机数
+    uint64_t state = 88172645463325252ULL;
+    for (size_t i = 0; i < count; i++) {
+        state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+        A[i] = (float)((state >> 11) * (1.0 / 9007199254740992.0)) * 2.0f - 1.0f;
+        state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+        B[i] = (float)((state >> 11) * (1.0 / 9007199254740992.0)) * 2.0f - 1.0f;
+    }
+
+    for (int format = MM_FP16; format <= MM_BF16; format++) {
+        double start = wall_time();
+        half_from_float(A, A16, count, format);
+        half_from_float(B, B16, count, format);
+        double convert_time = wall_time() - start;
+
+        start = wall_time();
+        matrixmultiply_half(N, N, N, format, A16, N, B16, N, C, N, MM_OVERWRITE, 0);
+        double gemm_time = wall_time() - start;
+
+        // 抽样与double精度的原始float32数据乘积对比，报告相对误差（Frobenius范数）
+        double err = 0.0, norm = 0.0;
+        for (int i = 0; i < N; i += 31) {
+            for (int j = 0; j < N; j++) {
+                double ref = 0.0;
+                for (int k = 0; k < N; k++) {
+                    ref += (double)A[(size_t)i * N + k] * B[(size_t)k * N + j];
+                }
+                double d = C[(size_t)i * N + j] - ref;
+                err += d * d;
+                norm += ref * ref;
+            }
+        }
+
+        printf("\n%s:\n", names[format]);
+        printf("转换 %zu 个元素: %.4f 秒\n", 2 * count, convert_time);
+        printf("矩阵乘法: %.4f 秒 (%.2f GFLOPS)，相对误差: %.2e\n",
+               gemm_time, 2.0 * N * N * N / gemm_time / 1e9, sqrt(err / norm));
+    }
+
+    free(A);
+    free(B);
+    free(C);
+    free(A16);
+    free(B16);
+
+    return 0;
+}
+#endif
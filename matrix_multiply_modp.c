@@ -0,0 +1,324 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <string.h>
+#include <stdint.h>
+#include <immintrin.h>
+#include "matrix_platform.h"
+#include "matrix_layout.h"
+
+// 模p矩阵乘法：C = A x B mod p，p为小于2^31的奇素数，A、B的元素按无符号数解释并先模p。
+// 普通int版本在32位中溢出回绕，结果对数论计算没有意义；这里的乘积在64位通道中累加：
+//   1. a, b < p < 2^31，乘积 < 2^62，用_mm256_mul_epu32（32x32->64位）一次计算4个
+//   2. 延迟约减：累加器在溢出之前一直累加，只在必要时做一次"折叠"
+//        acc = (acc mod 2^32) + (acc >> 32) * (2^32 mod p)
+//      折叠后 acc < p * 2^32，且与原值模p同余
+//   3. 最后用向量化的Montgomery约减(REDC, R = 2^32)得到[0, p)内的结果；
+//      A预先乘以R转换为Montgomery形式，REDC除以R后正好得到真实值
+// 分块和多线程方式与matrixmultiply_ultimate相同：按行分配给线程，64x64分块。
+
+#define MODP_BLOCK 64   // 分块大小，与综合优化版本相同
+
+// 模数相关的预计算参数
+typedef struct {
+    uint32_t p;
+    uint32_t p_inv_neg;   // -p^(-1) mod 2^32，Montgomery约减使用
+    uint32_t r_mod_p;     // 2^32 mod p，折叠使用
+    uint32_t r2_mod_p;    // 2^64 mod p，把A转换为Montgomery形式使用
+    int fold_interval;    // 两次折叠之间最多可以累加的乘积个数
+} ModParams;
+
+// 检查模数并计算预计算参数，p不是小于2^31的奇数时返回-1
+static int modp_setup(uint32_t p, ModParams *mp) {
+    if (p < 3 || (p & 1) == 0 || p >= (1u << 31)) {
+        return -1;
+    }
+
+    // 牛顿迭代求p^(-1) mod 2^32：每次迭代正确的位数翻倍
+    uint32_t inv = p;
+    for (int i = 0; i < 5; i++) {
+        inv *= 2 - p * inv;
+    }
+
+    mp->p = p;
+    mp->p_inv_neg = (uint32_t)(0u - inv);
+    mp->r_mod_p = (uint32_t)((1ULL << 32) % p);
+    mp->r2_mod_p = (uint32_t)(((uint64_t)mp->r_mod_p * mp->r_mod_p) % p);
+
+    // 折叠后 acc < p * 2^32，之后每个乘积最多为 (p-1)^2，累加到不超过2^64-1为止
+    uint64_t headroom = UINT64_MAX - ((uint64_t)p << 32);
+    uint64_t max_product = (uint64_t)(p - 1) * (p - 1);
+    uint64_t interval = headroom / max_product;
+    mp->fold_interval = interval > (uint64_t)1 << 30 ? 1 << 30 : (int)interval;
+
+    return 0;
+}
+
+// 折叠：acc -> (acc mod 2^32) + (acc >> 32) * (2^32 mod p)，结果 < p * 2^32
+static inline __m256i modp_fold(__m256i acc, __m256i r_mod_p, __m256i low_mask) {
+    __m256i lo = _mm256_and_si256(acc, low_mask);
+    __m256i hi = _mm256_srli_epi64(acc, 32);
+    return _mm256_add_epi64(lo, _mm256_mul_epu32(hi, r_mod_p));
+}
+
+// Montgomery约减：T < p * 2^32 时返回 T * 2^(-32) mod p（位于[0, p)，在64位通道的低32位中）
+static inline __m256i modp_redc(__m256i t, __m256i p, __m256i p_inv_neg, __m256i p_minus_1) {
+    __m256i m = _mm256_mul_epu32(t, p_inv_neg);                      // 只用到低32位
+    __m256i u = _mm256_srli_epi64(_mm256_add_epi64(t, _mm256_mul_epu32(m, p)), 32);
+    __m256i ge = _mm256_cmpgt_epi64(u, p_minus_1);                  // u < 2p < 2^32，可以用有符号比较
+    return _mm256_sub_epi64(u, _mm256_and_si256(ge, p));
+}
+
+static inline uint64_t modp_fold_scalar(uint64_t acc, const ModParams *mp) {
+    return (acc & 0xFFFFFFFFu) + (acc >> 32) * mp->r_mod_p;
+}
+
+static inline uint32_t modp_redc_scalar(uint64_t t, const ModParams *mp) {
+    uint32_t m = (uint32_t)t * mp->p_inv_neg;
+    uint64_t u = (t + (uint64_t)m * mp->p) >> 32;
+    return (uint32_t)(u >= mp->p ? u - mp->p : u);
+}
+
+// 线程参数结构体
+typedef struct {
+    int N;
+    const uint32_t *A_mont;   // Montgomery形式的A（A * 2^32 mod p），行主序连续存放
+    const uint64_t *B64;      // 模p后的B，每个元素扩展到64位，可以直接作为_mm256_mul_epu32的操作数
+    int **matrixC;
+    int start_row;
+    int end_row;
+    const ModParams *mp;
+} ModpThreadParams;
+
+MM_THREAD_FUNC modp_thread_function(void* arg) {
+    ModpThreadParams* params = (ModpThreadParams*)arg;
+    int N = params->N;
+    const ModParams *mp = params->mp;
+    __m256i r_mod_p = _mm256_set1_epi64x(mp->r_mod_p);
+    __m256i low_mask = _mm256_set1_epi64x(0xFFFFFFFFLL);
+    __m256i p = _mm256_set1_epi64x(mp->p);
+    __m256i p_inv_neg = _mm256_set1_epi64x(mp->p_inv_neg);
+    __m256i p_minus_1 = _mm256_set1_epi64x(mp->p - 1);
+    __m256i pack_even = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+
+    // 每个C块对应一个64x64的64位累加器块（32KB），在整个k循环中驻留在cache中
+    uint64_t *acc = (uint64_t*)mm_aligned_malloc(MODP_BLOCK * MODP_BLOCK * sizeof(uint64_t), 32);
+
+    for (int ii = params->start_row; ii < params->end_row; ii += MODP_BLOCK) {
+        int ii_end = (ii + MODP_BLOCK < params->end_row) ? ii + MODP_BLOCK : params->end_row;
+
+        for (int jj = 0; jj < N; jj += MODP_BLOCK) {
+            int jj_end = (jj + MODP_BLOCK < N) ? jj + MODP_BLOCK : N;
+            int width = jj_end - jj;
+            int j_simd = (width / 4) * 4;
+
+            memset(acc, 0, MODP_BLOCK * MODP_BLOCK * sizeof(uint64_t));
+            int pending = 0;   // 上次折叠之后累加的乘积个数
+
+            for (int kk = 0; kk < N; kk += MODP_BLOCK) {
+                int kk_end = (kk + MODP_BLOCK < N) ? kk + MODP_BLOCK : N;
+
+                for (int k = kk; k < kk_end; k++) {
+                    // 延迟约减：只有再累加一个乘积就可能溢出时才折叠
+                    if (pending == mp->fold_interval) {
+                        for (int i = 0; i < ii_end - ii; i++) {
+                            uint64_t *acc_row = acc + i * MODP_BLOCK;
+                            for (int j = 0; j < j_simd; j += 4) {
+                                __m256i v = _mm256_load_si256((__m256i*)&acc_row[j]);
+                                _mm256_store_si256((__m256i*)&acc_row[j], modp_fold(v, r_mod_p, low_mask));
+                            }
+                            for (int j = j_simd; j < width; j++) {
+                                acc_row[j] = modp_fold_scalar(acc_row[j], mp);
+                            }
+                        }
+                        pending = 0;
+                    }
+
+                    const uint64_t *b_row = params->B64 + (size_t)k * N + jj;
+                    for (int i = ii; i < ii_end; i++) {
+                        uint32_t a_val = params->A_mont[(size_t)i * N + k];
+                        __m256i a = _mm256_set1_epi64x(a_val);
+                        uint64_t *acc_row = acc + (i - ii) * MODP_BLOCK;
+
+                        for (int j = 0; j < j_simd; j += 4) {
+                            __m256i b = _mm256_loadu_si256((const __m256i*)&b_row[j]);
+                            __m256i v = _mm256_load_si256((__m256i*)&acc_row[j]);
+                            _mm256_store_si256((__m256i*)&acc_row[j], _mm256_add_epi64(v, _mm256_mul_epu32(a, b)));
+                        }
+                        for (int j = j_simd; j < width; j++) {
+                            acc_row[j] += (uint64_t)a_val * b_row[j];
+                        }
+                    }
+                    pending++;
+                }
+            }
+
+            // 最后折叠一次，使累加器 < p * 2^32，再用Montgomery约减得到结果
+            for (int i = ii; i < ii_end; i++) {
+                uint64_t *acc_row = acc + (i - ii) * MODP_BLOCK;
+                int *c_row = params->matrixC[i] + jj;
+
+                for (int j = 0; j < j_simd; j += 4) {
+                    __m256i v = modp_fold(_mm256_load_si256((__m256i*)&acc_row[j]), r_mod_p, low_mask);
+                    __m256i r = _mm256_permutevar8x32_epi32(modp_redc(v, p, p_inv_neg, p_minus_1), pack_even);
+                    _mm_storeu_si128((__m128i*)&c_row[j], _mm256_castsi256_si128(r));
+                }
+                for (int j = j_simd; j < width; j++) {
+                    c_row[j] = (int)modp_redc_scalar(modp_fold_scalar(acc_row[j], mp), mp);
+                }
+            }
+        }
+    }
+
+    mm_aligned_free(acc);
+    return MM_THREAD_RETURN;
+}
+
+// 模p矩阵乘法：C = A x B mod p（结果位于[0, p)）。p必须是小于2^31的奇数（通常为素数），否则返回-1
+int matrixmultiply_modp(int N, int **matrixA, int **matrixB, int **matrixC, unsigned int p) {
+    ModParams mp;
+    if (modp_setup(p, &mp) != 0) {
+        return -1;
+    }
+    if (N <= 0) {
+        return 0;
+    }
+
+    // 预处理：A转换为Montgomery形式，B模p后扩展为64位
+    uint32_t *A_mont = (uint32_t*)mm_aligned_malloc((size_t)N * N * sizeof(uint32_t), 32);
+    uint64_t *B64 = (uint64_t*)mm_aligned_malloc((size_t)N * N * sizeof(uint64_t), 32);
+    for (int i = 0; i < N; i++) {
+        for (int j = 0; j < N; j++) {
+            uint64_t a = (uint32_t)matrixA[i][j] % p;
+            A_mont[(size_t)i * N + j] = modp_redc_scalar(a * mp.r2_mod_p, &mp);
+            B64[(size_t)i * N + j] = (uint32_t)matrixB[i][j] % p;
+        }
+    }
+
+    // 获取系统CPU核心数
+    int num_threads = mm_cpu_count();
+    if (num_threads > 8) num_threads = 8; // 限制线程数
+    if (num_threads > N) num_threads = N;
+
+    mm_thread_t* threads = (mm_thread_t*)malloc(num_threads * sizeof(mm_thread_t));
+    ModpThreadParams* params = (ModpThreadParams*)malloc(num_threads * sizeof(ModpThreadParams));
+
+    int rows_per_thread = N / num_threads;
+    int remaining_rows = N % num_threads;
+
+    for (int t = 0; t < num_threads; t++) {
+        params[t].N = N;
+        params[t].A_mont = A_mont;
+        params[t].B64 = B64;
+        params[t].matrixC = matrixC;
+        params[t].start_row = t * rows_per_thread;
+        params[t].end_row = (t + 1) * rows_per_thread;
+        params[t].mp = &mp;
+
+        // 最后一个线程处理剩余的行
+        if (t == num_threads - 1) {
+            params[t].end_row += remaining_rows;
+        }
+
+        mm_thread_create(&threads[t], modp_thread_function, &params[t]);
+    }
+
+    mm_thread_join_all(threads, num_threads);
+
+    free(threads);
+    free(params);
+    mm_aligned_free(A_mont);
+    mm_aligned_free(B64);
+    return 0;
+}
+
+// 朴素版本：每一步都用64位取模约减，作为性能对比的基准
+int matrixmultiply_modp_naive(int N, int **matrixA, int **matrixB, int **matrixC, unsigned int p) {
+    if (p < 2) {
+        return -1;
+    }
+
+    for (int i = 0; i < N; i++) {
+        for (int j = 0; j < N; j++) {
+            uint64_t sum = 0;
+            for (int k = 0; k < N; k++) {
+                uint64_t a = (uint32_t)matrixA[i][k] % p;
+                uint64_t b = (uint32_t)matrixB[k][j] % p;
+                sum = (sum + a * b % p) % p;
+            }
+            matrixC[i][j] = (int)sum;
+        }
+    }
+    return 0;
+}
+
+// 辅助函数
+int** create_matrix(int N) {
+    return mm_alloc_matrix(N, N);
+}
+
+void free_matrix(int **matrix, int N) {
+    mm_free_matrix(matrix);
+}
+
+// 用[0, p)内的伪随机数初始化测试矩阵
+void init_modp_matrices(int N, int **matrixA, int **matrixB, unsigned int p) {
+    uint64_t state = 88172645463325252ULL;
+    for (int i = 0; i < N; i++) {
+        for (int j = 0; j < N; j++) {
+            state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+            matrixA[i][j] = (int)(state % p);
+            state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+            matrixB[i][j] = (int)(state % p);
+        }
+    }
+}
+
+#ifdef STANDALONE_TEST
+int main() {
+    // 31位素数、30位素数（NTT常用）和小素数
+    unsigned int primes[] = {2147483647u, 998244353u, 65521u};
+    int N = 512;
+    printf("测试模p矩阵乘法，矩阵大小: %dx%d\n", N, N);
+
+    int **matrixA = create_matrix(N);
+    int **matrixB = create_matrix(N);
+    int **matrixC = create_matrix(N);
+    int **reference = create_matrix(N);
+
+    for (int t = 0; t < 3; t++) {
+        unsigned int p = primes[t];
+        ModParams mp;
+        modp_setup(p, &mp);
+        init_modp_matrices(N, matrixA, matrixB, p);
+        printf("\np = %u（每%d个乘积折叠一次）:\n", p, mp.fold_interval);
+
+        clock_t start = clock();
+        matrixmultiply_modp_naive(N, matrixA, matrixB, reference, p);
+        double naive_time = ((double)(clock() - start)) / CLOCKS_PER_SEC;
+
+        start = clock();
+        matrixmultiply_modp(N, matrixA, matrixB, matrixC, p);
+        double fast_time = ((double)(clock() - start)) / CLOCKS_PER_SEC;
+
+        int errors = 0;
+        for (int i = 0; i < N; i++) {
+            for (int j = 0; j < N; j++) {
+                if (matrixC[i][j] != reference[i][j]) errors++;
+            }
+        }
+
+        double macs = (double)N * N * N;
+        printf("每步取模版本: %.4f 秒 (%.3f GMAC/s)\n", naive_time, macs / naive_time / 1e9);
+        printf("延迟约减SIMD版本: %.4f 秒 (%.3f GMAC/s)，加速 %.1fx，验证%s\n",
+               fast_time, macs / fast_time / 1e9, naive_time / fast_time, errors == 0 ? "正确" : "错误");
+    }
+
+    free_matrix(matrixA, N);
+    free_matrix(matrixB, N);
+    free_matrix(matrixC, N);
+    free_matrix(reference, N);
+
+    return 0;
+}
+#endif
@@ -2,8 +2,8 @@
 #include <stdlib.h>
 #include <time.h>
 #include <string.h>
-#include <windows.h>
-#include <process.h>
+#include "matrix_platform.h"
+#include "matrix_layout.h"
 
 // 线程参数结构体
 typedef struct {
@@ -17,7 +17,7 @@ typedef struct {
 } ThreadParams;
 
 // 线程函数
-unsigned __stdcall matrix_multiply_thread(void* arg) {
+MM_THREAD_FUNC matrix_multiply_thread(void* arg) {
     ThreadParams* params = (ThreadParams*)arg;
     int N = params->N;
     int **matrixA = params->matrixA;
@@ -36,14 +36,12 @@ unsigned __stdcall matrix_multiply_thread(void* arg) {
         }
     }
     
-    return 0;
+    return MM_THREAD_RETURN;
 }
 
 void matrixmultiply_multithread(int N, int **matrixA, int **matrixB, int **matrixC) {
     // 获取系统CPU核心数
-    SYSTEM_INFO sysinfo;
-    GetSystemInfo(&sysinfo);
-    int num_threads = sysinfo.dwNumberOfProcessors;
+    int num_threads = mm_cpu_count();
     
     // 限制最大线程数
     if (num_threads > 16) num_threads = 16;
@@ -51,7 +49,7 @@ void matrixmultiply_multithread(int N, int **matrixA, int **matrixB, int **matri
     printf("Using %d threads for computation\n", num_threads);
     
     // 创建线程句柄和参数数组
-    HANDLE* threads = (HANDLE*)malloc(num_threads * sizeof(HANDLE));
+    mm_thread_t* threads = (mm_thread_t*)malloc(num_threads * sizeof(mm_thread_t));
     ThreadParams* params = (ThreadParams*)malloc(num_threads * sizeof(ThreadParams));
     
     int rows_per_thread = N / num_threads;
@@ -72,17 +70,11 @@ void matrixmultiply_multithread(int N, int **matrixA, int **matrixB, int **matri
             params[t].end_row += remaining_rows;
         }
         
-        threads[t] = (HANDLE)_beginthreadex(NULL, 0, matrix_multiply_thread, 
-                                           &params[t], 0, NULL);
+        mm_thread_create(&threads[t], matrix_multiply_thread, &params[t]);
     }
     
-    // 等待所有线程完成
-    WaitForMultipleObjects(num_threads, threads, TRUE, INFINITE);
-    
-    // 清理资源
-    for (int t = 0; t < num_threads; t++) {
-        CloseHandle(threads[t]);
-    }
+    // 等待所有线程完成并清理资源
+    mm_thread_join_all(threads, num_threads);
     
     free(threads);
     free(params);
@@ -90,18 +82,19 @@ void matrixmultiply_multithread(int N, int **matrixA, int **matrixB, int **matri
 
 // 辅助函数（重用之前的）
 int** create_matrix(int N) {
-    int **matrix = (int**)malloc(N * sizeof(int*));
-    for (int i = 0; i < N; i++) {
-        matrix[i] = (int*)malloc(N * sizeof(int));
-    }
-    return matrix;
+    return mm_alloc_matrix(N, N);
 }
 
 void free_matrix(int **matrix, int N) {
-    for (int i = 0; i < N; i++) {
-        free(matrix[i]);
-    }
-    free(matrix);
+    mm_free_matrix(matrix);
+}
+
+void matrix_set_padding(int enabled) {
+    mm_set_padding(enabled);
+}
+
+int matrix_leading_dim(int **matrix, int N) {
+    return mm_matrix_leading_dim(matrix, N);
 }
 
 void init_test_matrices(int N, int **matrixA, int **matrixB) {
@@ -1,27 +1,39 @@
+#define _POSIX_C_SOURCE 200809L  // clock_gettime（执行时间线追踪）
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
 #include <string.h>
+#include <stdint.h>
 #include <immintrin.h>
-#include <windows.h>
-#include <process.h>
+#include "matrix_platform.h"
+#include "matrix_layout.h"
+#include "matrix_transpose.h"
+#include "matrix_trace.h"
+#include "matrix_verify.h"
+#include "matrix_kernel.h"
+
+// 带校验版本的返回值
+#define MM_VERIFY_FAILED    0   // 重新计算后仍不一致
+#define MM_VERIFY_PASSED    1   // 结果通过校验
+#define MM_VERIFY_RECOVERED 2   // 快速版本的结果不一致，已用单线程转置版本重新计算并通过校验
 
 // 循环展开的优化版本
-void matrixmultiply_unrolled(int N, int **matrixA, int **matrixB, int **matrixC) {
+void matrixmultiply_unrolled_ex(int N, int **matrixA, int **matrixB, int **matrixC, int flags) {
     int i, j, k;
-    
-    // 初始化结果矩阵
-    for (i = 0; i < N; i++) {
-        for (j = 0; j < N; j++) {
-            matrixC[i][j] = 0;
-        }
-    }
+    int accumulate = flags & MM_ACCUMULATE;
     
     // 循环展开优化，每次处理4个元素
     for (i = 0; i < N; i++) {
         for (j = 0; j < N; j += 4) {
             int sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0;
             
+            if (accumulate) {
+                sum0 = matrixC[i][j];
+                if (j + 1 < N) sum1 = matrixC[i][j + 1];
+                if (j + 2 < N) sum2 = matrixC[i][j + 2];
+                if (j + 3 < N) sum3 = matrixC[i][j + 3];
+            }
+            
             for (k = 0; k < N; k++) {
                 int a_ik = matrixA[i][k];
                 sum0 += a_ik * matrixB[k][j];
@@ -38,56 +50,40 @@ void matrixmultiply_unrolled(int N, int **matrixA, int **matrixB, int **matrixC)
     }
 }
 
+void matrixmultiply_unrolled(int N, int **matrixA, int **matrixB, int **matrixC) {
+    matrixmultiply_unrolled_ex(N, matrixA, matrixB, matrixC, MM_OVERWRITE);
+}
+
 // 矩阵转置优化版本（改善数据局部性）
-void matrixmultiply_transpose(int N, int **matrixA, int **matrixB, int **matrixC) {
+void matrixmultiply_transpose_ex(int N, int **matrixA, int **matrixB, int **matrixC, int flags) {
     int i, j, k;
     
-    // 创建转置矩阵B
-    int **matrixB_T = (int**)malloc(N * sizeof(int*));
-    for (i = 0; i < N; i++) {
-        matrixB_T[i] = (int*)malloc(N * sizeof(int));
-    }
-    
-    // 转置矩阵B
-    for (i = 0; i < N; i++) {
-        for (j = 0; j < N; j++) {
-            matrixB_T[j][i] = matrixB[i][j];
-        }
-    }
-    
-    // 初始化结果矩阵
-    for (i = 0; i < N; i++) {
-        for (j = 0; j < N; j++) {
-            matrixC[i][j] = 0;
-        }
-    }
+    // 转置矩阵B（分块 + AVX2 8x8寄存器转置 + 多线程，行间距由分配器选择以避免cache组冲突）
+    int **matrixB_T = mm_transpose_matrix(N, N, matrixB, 0);
     
-    // 使用转置矩阵进行乘法（改善cache命中率）
+    // 使用转置矩阵进行乘法（改善cache命中率），点积在寄存器中完成后一次写回C
     for (i = 0; i < N; i++) {
         for (j = 0; j < N; j++) {
+            int sum = (flags & MM_ACCUMULATE) ? matrixC[i][j] : 0;
             for (k = 0; k < N; k++) {
-                matrixC[i][j] += matrixA[i][k] * matrixB_T[j][k];
+                sum += matrixA[i][k] * matrixB_T[j][k];
             }
+            matrixC[i][j] = sum;
         }
     }
     
     // 释放转置矩阵
-    for (i = 0; i < N; i++) {
-        free(matrixB_T[i]);
-    }
-    free(matrixB_T);
+    mm_free_matrix(matrixB_T);
+}
+
+void matrixmultiply_transpose(int N, int **matrixA, int **matrixB, int **matrixC) {
+    matrixmultiply_transpose_ex(N, matrixA, matrixB, matrixC, MM_OVERWRITE);
 }
 
 // 预取优化版本
-void matrixmultiply_prefetch(int N, int **matrixA, int **matrixB, int **matrixC) {
+void matrixmultiply_prefetch_ex(int N, int **matrixA, int **matrixB, int **matrixC, int flags) {
     int i, j, k;
-    
-    // 初始化结果矩阵
-    for (i = 0; i < N; i++) {
-        for (j = 0; j < N; j++) {
-            matrixC[i][j] = 0;
-        }
-    }
+    int accumulate = flags & MM_ACCUMULATE;
     
     for (i = 0; i < N; i++) {
         for (k = 0; k < N; k++) {
@@ -100,13 +96,24 @@ void matrixmultiply_prefetch(int N, int **matrixA, int **matrixB, int **matrixC)
             }
             
             int temp = matrixA[i][k];
-            for (j = 0; j < N; j++) {
-                matrixC[i][j] += temp * matrixB[k][j];
+            if (k == 0 && !accumulate) {
+                // 第一次写入C的这一行：直接覆盖
+                for (j = 0; j < N; j++) {
+                    matrixC[i][j] = temp * matrixB[k][j];
+                }
+            } else {
+                for (j = 0; j < N; j++) {
+                    matrixC[i][j] += temp * matrixB[k][j];
+                }
             }
         }
     }
 }
 
+void matrixmultiply_prefetch(int N, int **matrixA, int **matrixB, int **matrixC) {
+    matrixmultiply_prefetch_ex(N, matrixA, matrixB, matrixC, MM_OVERWRITE);
+}
+
 // 线程参数结构体
 typedef struct {
     int N;
@@ -115,11 +122,14 @@ typedef struct {
     int **matrixC;
     int start_row;
     int end_row;
-    int thread_id;
+    int start_col;   // 负责的列范围（增量重新计算时只算C的部分列）
+    int end_col;
+    int thread_id;   // 追踪事件的线程编号（1, 2, ...），-1表示本次调用不记录
+    int flags;
 } ThreadParams;
 
 // 综合优化线程函数（分块 + SIMD + 循环展开）
-unsigned __stdcall optimized_thread_function(void* arg) {
+MM_THREAD_FUNC optimized_thread_function(void* arg) {
     ThreadParams* params = (ThreadParams*)arg;
     int N = params->N;
     int **matrixA = params->matrixA;
@@ -127,6 +137,9 @@ unsigned __stdcall optimized_thread_function(void* arg) {
     int **matrixC = params->matrixC;
     int start_row = params->start_row;
     int end_row = params->end_row;
+    int accumulate = params->flags & MM_ACCUMULATE;
+    int tid = params->thread_id;
+    double trace_thread = mm_trace_begin();
     
     const int BLOCK_SIZE = 64;
     
@@ -134,13 +147,18 @@ unsigned __stdcall optimized_thread_function(void* arg) {
     for (int kk = 0; kk < N; kk += BLOCK_SIZE) {
         for (int ii = start_row; ii < end_row; ii += BLOCK_SIZE) {
             int ii_end = (ii + BLOCK_SIZE < end_row) ? ii + BLOCK_SIZE : end_row;
+            double trace_tile = mm_trace_begin();
             
-            for (int jj = 0; jj < N; jj += BLOCK_SIZE) {
-                int jj_end = (jj + BLOCK_SIZE < N) ? jj + BLOCK_SIZE : N;
+            for (int jj = params->start_col; jj < params->end_col; jj += BLOCK_SIZE) {
+                int jj_end = (jj + BLOCK_SIZE < params->end_col) ? jj + BLOCK_SIZE : params->end_col;
                 int kk_end = (kk + BLOCK_SIZE < N) ? kk + BLOCK_SIZE : N;
                 
                 // 在每个块内使用SIMD优化
                 for (int k = kk; k < kk_end; k++) {
+                    // k == 0 是C块的第一次写入（覆盖），k == N-1 是最后一次写入（可流式存储）
+                    int first = (k == 0) && !accumulate;
+                    int last = (k == N - 1) && (params->flags & MM_STREAM);
+                    
                     for (int i = ii; i < ii_end; i++) {
                         // 预取下一行数据
                         if (i + 1 < ii_end) {
@@ -151,86 +169,656 @@ unsigned __stdcall optimized_thread_function(void* arg) {
                         __m256i a_broadcast = _mm256_set1_epi32(matrixA[i][k]);
                         
                         int j_simd = jj + ((jj_end - jj) / 8) * 8;
+                        int stream = last && ((uintptr_t)matrixC[i] & 31) == 0;
                         
                         // SIMD处理
                         for (int j = jj; j < j_simd; j += 8) {
                             __m256i b_vec = _mm256_loadu_si256((__m256i*)&matrixB[k][j]);
-                            __m256i c_vec = _mm256_loadu_si256((__m256i*)&matrixC[i][j]);
                             __m256i prod = _mm256_mullo_epi32(a_broadcast, b_vec);
-                            __m256i result = _mm256_add_epi32(c_vec, prod);
-                            _mm256_storeu_si256((__m256i*)&matrixC[i][j], result);
+                            __m256i result = first ? prod :
+                                _mm256_add_epi32(_mm256_loadu_si256((__m256i*)&matrixC[i][j]), prod);
+                            if (stream) {
+                                _mm256_stream_si256((__m256i*)&matrixC[i][j], result);
+                            } else {
+                                _mm256_storeu_si256((__m256i*)&matrixC[i][j], result);
+                            }
                         }
                         
                         // 处理剩余元素
                         int temp = matrixA[i][k];
                         for (int j = j_simd; j < jj_end; j++) {
-                            matrixC[i][j] += temp * matrixB[k][j];
+                            if (first) {
+                                matrixC[i][j] = temp * matrixB[k][j];
+                            } else {
+                                matrixC[i][j] += temp * matrixB[k][j];
+                            }
                         }
                     }
                 }
             }
+            mm_trace_event(tid, "tile", trace_tile, "row", ii, "k", kk);
         }
     }
     
-    return 0;
+    // 确保流式存储在线程结束前全部完成
+    if (params->flags & MM_STREAM) {
+        _mm_sfence();
+    }
+    
+    mm_trace_event(tid, "rows", trace_thread, "start_row", start_row, "end_row", end_row);
+    return MM_THREAD_RETURN;
+}
+
+// 多线程计算C的区域 [row_start, row_end) x [col_start, col_end)（k方向始终为完整的0..N）。
+// 行数不少于线程数时按行划分，否则（例如只重新计算几行）按64列的块划分；trace_setup为准备阶段开始的时间戳
+static void ultimate_region(int N, int **matrixA, int **matrixB, int **matrixC,
+                            int row_start, int row_end, int col_start, int col_end,
+                            int flags, int num_threads, double trace_setup) {
+    int rows = row_end - row_start;
+    int col_blocks = (col_end - col_start + 63) / 64;
+    if (rows <= 0 || col_blocks <= 0) {
+        return;
+    }
+    
+    int split_cols = rows < num_threads;
+    int units = split_cols ? col_blocks : rows;
+    if (num_threads > units) num_threads = units;
+    
+    // 创建线程句柄和参数数组
+    mm_thread_t* threads = (mm_thread_t*)malloc(num_threads * sizeof(mm_thread_t));
+    ThreadParams* params = (ThreadParams*)malloc(num_threads * sizeof(ThreadParams));
+    
+    int units_per_thread = units / num_threads;
+    int remaining_units = units % num_threads;
+    int trace_tid = mm_trace_acquire();
+    mm_trace_event(trace_tid, "setup", trace_setup, "threads", num_threads, NULL, 0);
+    
+    // 创建并启动线程
+    for (int t = 0; t < num_threads; t++) {
+        int begin = t * units_per_thread;
+        int end = (t + 1) * units_per_thread;
+        
+        // 最后一个线程处理剩余的行（或列块）
+        if (t == num_threads - 1) {
+            end += remaining_units;
+        }
+        
+        params[t].N = N;
+        params[t].matrixA = matrixA;
+        params[t].matrixB = matrixB;
+        params[t].matrixC = matrixC;
+        params[t].start_row = split_cols ? row_start : row_start + begin;
+        params[t].end_row = split_cols ? row_end : row_start + end;
+        params[t].start_col = split_cols ? col_start + begin * 64 : col_start;
+        params[t].end_col = split_cols ? col_start + end * 64 : col_end;
+        if (params[t].end_col > col_end) params[t].end_col = col_end;
+        params[t].thread_id = trace_tid < 0 ? -1 : t + 1;
+        params[t].flags = flags;
+        
+        double trace_spawn = mm_trace_begin();
+        mm_thread_create(&threads[t], optimized_thread_function, &params[t]);
+        mm_trace_event(trace_tid, "spawn", trace_spawn, "thread", t + 1, NULL, 0);
+    }
+    
+    // 等待所有线程完成并清理资源
+    double trace_join = mm_trace_begin();
+    mm_thread_join_all(threads, num_threads);
+    mm_trace_event(trace_tid, "join", trace_join, NULL, 0, NULL, 0);
+    mm_trace_release(trace_tid);
+    
+    free(threads);
+    free(params);
 }
 
 // 终极优化版本：多线程 + 分块 + SIMD + 预取
-void matrixmultiply_ultimate(int N, int **matrixA, int **matrixB, int **matrixC) {
+void matrixmultiply_ultimate_ex(int N, int **matrixA, int **matrixB, int **matrixC, int flags) {
+    double trace_setup = mm_trace_begin();
+    
     // 获取系统CPU核心数
-    SYSTEM_INFO sysinfo;
-    GetSystemInfo(&sysinfo);
-    int num_threads = sysinfo.dwNumberOfProcessors;
+    int num_threads = mm_cpu_count();
     
     if (num_threads > 8) num_threads = 8; // 限制线程数
     
     printf("Using ultimate optimization: %d threads + blocking + SIMD + prefetching\n", num_threads);
     
-    // 初始化结果矩阵
-    for (int i = 0; i < N; i++) {
+    // 不再串行清零C：每个线程在自己负责的行块第一次写入时直接覆盖
+    ultimate_region(N, matrixA, matrixB, matrixC, 0, N, 0, N, flags, num_threads, trace_setup);
+}
+
+void matrixmultiply_ultimate(int N, int **matrixA, int **matrixB, int **matrixC) {
+    matrixmultiply_ultimate_ex(N, matrixA, matrixB, matrixC, MM_OVERWRITE);
+}
+
+// ==================== 预打包的可复用操作数 ====================
+// 推理类场景中B是固定的权重矩阵，会与一系列不同的A相乘。
+// 先调用一次matrix_pack_B把B整理成内核偏好的面板布局（可选缩窄为int16），
+// 之后每次乘法直接使用打包后的句柄，打包开销只需付出一次。
+
+#define PACK_NR MM_KERNEL_NR   // 面板宽度（列数），一行正好对应8个AVX2寄存器
+#define PACK_KC MM_KERNEL_KC   // k方向的分块大小，使面板块(PACK_KC x PACK_NR)驻留在L2 cache中
+
+typedef struct {
+    int N;
+    int elem_bytes;   // 4: int32存储；2: 缩窄为int16存储
+    int num_panels;   // 列面板个数，最后一个面板不足PACK_NR列时用0填充
+    void *data;       // 第p个面板的第k行位于 (p * N + k) * PACK_NR 个元素处，32字节对齐
+} PackedMatrix;
+
+// 打包矩阵B。narrow非0时，若B的所有元素都能用int16表示则缩窄存储，带宽减半
+PackedMatrix* matrix_pack_B(int N, int **matrixB, int narrow) {
+    double trace_pack = mm_trace_begin();
+    PackedMatrix *packed = (PackedMatrix*)malloc(sizeof(PackedMatrix));
+    packed->N = N;
+    packed->num_panels = (N + PACK_NR - 1) / PACK_NR;
+    
+    // 检查是否可以缩窄为int16
+    int fits = narrow;
+    for (int i = 0; i < N && fits; i++) {
         for (int j = 0; j < N; j++) {
-            matrixC[i][j] = 0;
+            if (matrixB[i][j] < -32768 || matrixB[i][j] > 32767) {
+                fits = 0;
+                break;
+            }
         }
     }
+    packed->elem_bytes = fits ? 2 : 4;
     
-    // 创建线程句柄和参数数组
-    HANDLE* threads = (HANDLE*)malloc(num_threads * sizeof(HANDLE));
-    ThreadParams* params = (ThreadParams*)malloc(num_threads * sizeof(ThreadParams));
+    size_t count = (size_t)packed->num_panels * N * PACK_NR;
+    packed->data = mm_aligned_malloc(count * packed->elem_bytes, 32);
+    
+    for (int p = 0; p < packed->num_panels; p++) {
+        int jj = p * PACK_NR;
+        int width = (N - jj < PACK_NR) ? N - jj : PACK_NR;
+        
+        for (int k = 0; k < N; k++) {
+            size_t offset = ((size_t)p * N + k) * PACK_NR;
+            if (packed->elem_bytes == 2) {
+                short *dst = (short*)packed->data + offset;
+                for (int j = 0; j < width; j++) {
+                    dst[j] = (short)matrixB[k][jj + j];
+                }
+                for (int j = width; j < PACK_NR; j++) {
+                    dst[j] = 0;
+                }
+            } else {
+                int *dst = (int*)packed->data + offset;
+                memcpy(dst, &matrixB[k][jj], width * sizeof(int));
+                for (int j = width; j < PACK_NR; j++) {
+                    dst[j] = 0;
+                }
+            }
+        }
+    }
+    
+    int trace_tid = mm_trace_acquire();
+    mm_trace_event(trace_tid, "pack", trace_pack, "bytes", packed->elem_bytes, NULL, 0);
+    mm_trace_release(trace_tid);
+    return packed;
+}
+
+void matrix_packed_free(PackedMatrix *packed) {
+    if (packed) {
+        mm_aligned_free(packed->data);
+        free(packed);
+    }
+}
+
+// 计算C的一行在一个面板上的部分结果：c_row[0..ncols) (+)= a_row[k_start..k_end) x panel
+// 按面板的元素宽度调用共享行内核（matrix_kernel.h），int16面板在加载时符号扩展为int32
+static void packed_row_kernel(const int *a_row, const PackedMatrix *packed, int p,
+                              int k_start, int k_end, int *c_row, int ncols,
+                              int first, int stream) {
+    size_t offset = ((size_t)p * packed->N + k_start) * PACK_NR;
+    
+    if (packed->elem_bytes == 2) {
+        mm_row_kernel_i16(a_row + k_start, 1, (const short*)packed->data + offset, PACK_NR,
+                          k_end - k_start, c_row, ncols, first, stream);
+    } else {
+        mm_row_kernel_i32(a_row + k_start, 1, (const int*)packed->data + offset, PACK_NR,
+                          k_end - k_start, c_row, ncols, first, stream);
+    }
+}
+
+// 预打包版本的线程参数
+typedef struct {
+    int **matrixA;
+    const PackedMatrix *packedB;
+    int **matrixC;
+    int start_row;
+    int end_row;
+    int thread_id;   // 追踪事件的线程编号（1, 2, ...），-1表示本次调用不记录
+    int flags;
+} PackedThreadParams;
+
+MM_THREAD_FUNC packed_thread_function(void* arg) {
+    PackedThreadParams* params = (PackedThreadParams*)arg;
+    const PackedMatrix *packed = params->packedB;
+    int N = packed->N;
+    int accumulate = params->flags & MM_ACCUMULATE;
+    int tid = params->thread_id;
+    double trace_thread = mm_trace_begin();
+    
+    // 面板块(PACK_KC x PACK_NR)在L2中被该线程负责的所有行复用
+    for (int kk = 0; kk < N; kk += PACK_KC) {
+        int kk_end = (kk + PACK_KC < N) ? kk + PACK_KC : N;
+        int first = (kk == 0) && !accumulate;
+        int last = (kk_end == N) && (params->flags & MM_STREAM);
+        
+        for (int p = 0; p < packed->num_panels; p++) {
+            int jj = p * PACK_NR;
+            int ncols = (N - jj < PACK_NR) ? N - jj : PACK_NR;
+            double trace_tile = mm_trace_begin();
+            
+            for (int i = params->start_row; i < params->end_row; i++) {
+                int stream = last && ((uintptr_t)&params->matrixC[i][jj] & 31) == 0;
+                packed_row_kernel(params->matrixA[i], packed, p, kk, kk_end,
+                                  &params->matrixC[i][jj], ncols, first, stream);
+            }
+            mm_trace_event(tid, "panel", trace_tile, "col", jj, "k", kk);
+        }
+    }
+    
+    if (params->flags & MM_STREAM) {
+        _mm_sfence();
+    }
+    
+    mm_trace_event(tid, "rows", trace_thread, "start_row", params->start_row, "end_row", params->end_row);
+    return MM_THREAD_RETURN;
+}
+
+// 使用预打包B的多线程乘法：C (+)= A x B。成功返回0，打包矩阵的大小与N不一致时返回-1（不修改C）
+int matrixmultiply_ultimate_packed(int N, int **matrixA, const PackedMatrix *packedB, int **matrixC, int flags) {
+    if (packedB->N != N) {
+        return -1;
+    }
+    
+    // 获取系统CPU核心数
+    int num_threads = mm_cpu_count();
+    
+    if (num_threads > 8) num_threads = 8; // 限制线程数
+    if (num_threads > N) num_threads = N;
+    
+    mm_thread_t* threads = (mm_thread_t*)malloc(num_threads * sizeof(mm_thread_t));
+    PackedThreadParams* params = (PackedThreadParams*)malloc(num_threads * sizeof(PackedThreadParams));
     
     int rows_per_thread = N / num_threads;
     int remaining_rows = N % num_threads;
+    int trace_tid = mm_trace_acquire();
     
-    // 创建并启动线程
     for (int t = 0; t < num_threads; t++) {
-        params[t].N = N;
         params[t].matrixA = matrixA;
-        params[t].matrixB = matrixB;
+        params[t].packedB = packedB;
         params[t].matrixC = matrixC;
         params[t].start_row = t * rows_per_thread;
         params[t].end_row = (t + 1) * rows_per_thread;
-        params[t].thread_id = t;
+        params[t].thread_id = trace_tid < 0 ? -1 : t + 1;
+        params[t].flags = flags;
         
         // 最后一个线程处理剩余的行
         if (t == num_threads - 1) {
             params[t].end_row += remaining_rows;
         }
         
-        threads[t] = (HANDLE)_beginthreadex(NULL, 0, optimized_thread_function, 
-                                           &params[t], 0, NULL);
+        double trace_spawn = mm_trace_begin();
+        mm_thread_create(&threads[t], packed_thread_function, &params[t]);
+        mm_trace_event(trace_tid, "spawn", trace_spawn, "thread", t + 1, NULL, 0);
     }
     
-    // 等待所有线程完成
-    WaitForMultipleObjects(num_threads, threads, TRUE, INFINITE);
+    double trace_join = mm_trace_begin();
+    mm_thread_join_all(threads, num_threads);
+    mm_trace_event(trace_tid, "join", trace_join, NULL, 0, NULL, 0);
+    mm_trace_release(trace_tid);
+    
+    free(threads);
+    free(params);
+    return 0;
+}
+
+// ==================== 增量重新计算 ====================
+// 迭代计算中相邻两次乘法之间往往只有A的少数行或B的少数列发生变化，没有必要每次完整重算。
+// 增量句柄保存上一次计算时A、B的副本，只更新C中受影响的部分：
+//   A的行集合R变化   -> 重新计算C的这些行        （|R|·N²次乘加）
+//   B的列集合S变化   -> 重新计算C的这些列        （|S|·N²次乘加）
+//   变化集中在A的少数列K_A、B的少数行K_B时，改用低秩更新（|K_A|+|K_B|）·N²次乘加：
+//     A'B' = AB + ΔA[:,K_A]·B[K_A,:] + A'[:,K_B]·ΔB[K_B,:]
+// 变化位置可以由调用者用matrix_incremental_mark给出；没有标记时与副本比较（O(N²)，相对O(N³)可以忽略）。
+// 需要重新计算的量超过完整乘法的一半时直接完整计算。
+
+#define MM_DIRTY_A_ROWS 0   // A的行 [start, end) 已变化
+#define MM_DIRTY_B_COLS 1   // B的列 [start, end) 已变化
+
+// matrix_incremental_update采用的更新方式
+#define MM_INC_NONE    0
+#define MM_INC_ROWCOL  1
+#define MM_INC_LOWRANK 2
+#define MM_INC_FULL    3
+
+typedef struct {
+    int N;
+    int **matrixA;            // 调用者的矩阵：原地修改A、B后调用update
+    int **matrixB;
+    int **matrixC;
+    int **shadowA;            // 上一次计算时的A、B
+    int **shadowB;
+    unsigned char *rowsA;     // A中变化的行 / 列
+    unsigned char *colsA;
+    unsigned char *rowsB;     // B中变化的行 / 列
+    unsigned char *colsB;
+    int marked;               // 调用者已给出变化位置，不需要与副本比较
+    int num_threads;
+} IncrementalProduct;
+
+// 低秩更新的线程参数：C[i][:] += Σ_t U[i][t] * V[t][:]，U为N x r，V为r个长度为N的行
+typedef struct {
+    int N;
+    int r;
+    int **U;
+    int **V;
+    int **matrixC;
+    int start_row;
+    int end_row;
+} RankUpdateParams;
+
+MM_THREAD_FUNC rank_update_thread_function(void* arg) {
+    RankUpdateParams *params = (RankUpdateParams*)arg;
+    int N = params->N;
+    int r = params->r;
+    
+    for (int i = params->start_row; i < params->end_row; i++) {
+        int *c_row = params->matrixC[i];
+        const int *u_row = params->U[i];
+        int jj = 0;
+        
+        // 64列的寄存器面板：r个秩一更新在8个累加器中完成，C的每个元素只读写一次
+        for (; jj + 64 <= N; jj += 64) {
+            __m256i acc[8];
+            for (int v = 0; v < 8; v++) {
+                acc[v] = _mm256_loadu_si256((__m256i*)&c_row[jj + v * 8]);
+            }
+            for (int t = 0; t < r; t++) {
+                if (u_row[t] == 0) {
+                    continue;
+                }
+                __m256i a_broadcast = _mm256_set1_epi32(u_row[t]);
+                const int *v_row = params->V[t] + jj;
+                for (int v = 0; v < 8; v++) {
+                    acc[v] = _mm256_add_epi32(acc[v],
+                        _mm256_mullo_epi32(a_broadcast, _mm256_loadu_si256((const __m256i*)&v_row[v * 8])));
+                }
+            }
+            for (int v = 0; v < 8; v++) {
+                _mm256_storeu_si256((__m256i*)&c_row[jj + v * 8], acc[v]);
+            }
+        }
+        
+        // 剩余的8列一组
+        for (; jj + 8 <= N; jj += 8) {
+            __m256i acc = _mm256_loadu_si256((__m256i*)&c_row[jj]);
+            for (int t = 0; t < r; t++) {
+                __m256i a_broadcast = _mm256_set1_epi32(u_row[t]);
+                acc = _mm256_add_epi32(acc,
+                    _mm256_mullo_epi32(a_broadcast, _mm256_loadu_si256((const __m256i*)&params->V[t][jj])));
+            }
+            _mm256_storeu_si256((__m256i*)&c_row[jj], acc);
+        }
+        
+        // 处理剩余元素
+        for (; jj < N; jj++) {
+            int sum = c_row[jj];
+            for (int t = 0; t < r; t++) {
+                sum += u_row[t] * params->V[t][jj];
+            }
+            c_row[jj] = sum;
+        }
+    }
+    
+    return MM_THREAD_RETURN;
+}
+
+static void rank_update(int N, int r, int **U, int **V, int **matrixC, int num_threads) {
+    if (N <= 0 || r <= 0) {
+        return;
+    }
+    if (num_threads > N) num_threads = N;
+    
+    mm_thread_t* threads = (mm_thread_t*)malloc(num_threads * sizeof(mm_thread_t));
+    RankUpdateParams* params = (RankUpdateParams*)malloc(num_threads * sizeof(RankUpdateParams));
+    
+    int rows_per_thread = N / num_threads;
+    int remaining_rows = N % num_threads;
     
-    // 清理资源
     for (int t = 0; t < num_threads; t++) {
-        CloseHandle(threads[t]);
+        params[t].N = N;
+        params[t].r = r;
+        params[t].U = U;
+        params[t].V = V;
+        params[t].matrixC = matrixC;
+        params[t].start_row = t * rows_per_thread;
+        params[t].end_row = (t + 1) * rows_per_thread;
+        
+        // 最后一个线程处理剩余的行
+        if (t == num_threads - 1) {
+            params[t].end_row += remaining_rows;
+        }
+        
+        mm_thread_create(&threads[t], rank_update_thread_function, &params[t]);
     }
     
+    mm_thread_join_all(threads, num_threads);
+    
     free(threads);
     free(params);
 }
 
+// 低秩更新：C += U x V，U为N x r（每行至少r个元素），V为r x N（r个行指针）
+void matrixmultiply_rank_update(int N, int r, int **U, int **V, int **matrixC) {
+    int num_threads = mm_cpu_count();
+    if (num_threads > 8) num_threads = 8; // 限制线程数
+    rank_update(N, r, U, V, matrixC, num_threads);
+}
+
+static int** incremental_copy(int N, int **src) {
+    int **copy = mm_alloc_matrix(N, N);
+    for (int i = 0; i < N; i++) {
+        memcpy(copy[i], src[i], N * sizeof(int));
+    }
+    return copy;
+}
+
+// 创建增量句柄并完整计算一次 C = A x B。句柄保存A、B的副本（额外2·N²个int）
+IncrementalProduct* matrix_incremental_create(int N, int **matrixA, int **matrixB, int **matrixC) {
+    IncrementalProduct *inc = (IncrementalProduct*)malloc(sizeof(IncrementalProduct));
+    inc->N = N;
+    inc->matrixA = matrixA;
+    inc->matrixB = matrixB;
+    inc->matrixC = matrixC;
+    inc->shadowA = incremental_copy(N, matrixA);
+    inc->shadowB = incremental_copy(N, matrixB);
+    inc->rowsA = (unsigned char*)calloc(N > 0 ? N : 1, 1);
+    inc->colsA = (unsigned char*)calloc(N > 0 ? N : 1, 1);
+    inc->rowsB = (unsigned char*)calloc(N > 0 ? N : 1, 1);
+    inc->colsB = (unsigned char*)calloc(N > 0 ? N : 1, 1);
+    inc->marked = 0;
+    inc->num_threads = mm_cpu_count();
+    if (inc->num_threads > 8) inc->num_threads = 8; // 限制线程数
+    
+    ultimate_region(N, matrixA, matrixB, matrixC, 0, N, 0, N, MM_OVERWRITE, inc->num_threads, mm_trace_begin());
+    return inc;
+}
+
+// 标记变化位置（which为MM_DIRTY_A_ROWS或MM_DIRTY_B_COLS）。标记后update不再与副本比较，
+// 未标记的修改不会反映到C中
+void matrix_incremental_mark(IncrementalProduct *inc, int which, int start, int end) {
+    if (start < 0) start = 0;
+    if (end > inc->N) end = inc->N;
+    unsigned char *flags = (which == MM_DIRTY_A_ROWS) ? inc->rowsA : inc->colsB;
+    for (int i = start; i < end; i++) {
+        flags[i] = 1;
+    }
+    inc->marked = 1;
+}
+
+// 与副本比较，找出matrix中变化的行和列
+static void incremental_diff(int N, int **matrix, int **shadow, unsigned char *rows, unsigned char *cols) {
+    for (int i = 0; i < N; i++) {
+        if (memcmp(matrix[i], shadow[i], N * sizeof(int)) == 0) {
+            continue;
+        }
+        rows[i] = 1;
+        for (int j = 0; j < N; j++) {
+            if (matrix[i][j] != shadow[i][j]) {
+                cols[j] = 1;
+            }
+        }
+    }
+}
+
+static int incremental_count(const unsigned char *flags, int N) {
+    int count = 0;
+    for (int i = 0; i < N; i++) {
+        count += flags[i];
+    }
+    return count;
+}
+
+// 把flags中连续为1的区间依次重新计算（按行或按列）
+static void incremental_recompute_runs(IncrementalProduct *inc, const unsigned char *flags, int by_rows) {
+    int N = inc->N;
+    for (int start = 0; start < N; start++) {
+        if (!flags[start]) {
+            continue;
+        }
+        int end = start;
+        while (end < N && flags[end]) {
+            end++;
+        }
+        if (by_rows) {
+            ultimate_region(N, inc->matrixA, inc->matrixB, inc->matrixC, start, end, 0, N,
+                            MM_OVERWRITE, inc->num_threads, mm_trace_begin());
+        } else {
+            ultimate_region(N, inc->matrixA, inc->matrixB, inc->matrixC, 0, N, start, end,
+                            MM_OVERWRITE, inc->num_threads, mm_trace_begin());
+        }
+        start = end;
+    }
+}
+
+// 低秩更新：C += ΔA[:,K_A]·B_old[K_A,:] + A'[:,K_B]·ΔB[K_B,:]（差值按32位无符号回绕计算，与乘法本身一致）
+static void incremental_lowrank(IncrementalProduct *inc, int nKA, int nKB) {
+    int N = inc->N;
+    int r = nKA > nKB ? nKA : nKB;
+    int *index = (int*)malloc((r > 0 ? r : 1) * sizeof(int));
+    int **U = mm_alloc_matrix(N, r > 0 ? r : 1);
+    int **V = (int**)malloc((r > 0 ? r : 1) * sizeof(int*));
+    
+    if (nKA > 0) {
+        int t = 0;
+        for (int k = 0; k < N; k++) {
+            if (inc->colsA[k]) index[t++] = k;
+        }
+        for (int i = 0; i < N; i++) {
+            for (t = 0; t < nKA; t++) {
+                U[i][t] = (int)((unsigned)inc->matrixA[i][index[t]] - (unsigned)inc->shadowA[i][index[t]]);
+            }
+        }
+        for (t = 0; t < nKA; t++) {
+            V[t] = inc->shadowB[index[t]];
+        }
+        rank_update(N, nKA, U, V, inc->matrixC, inc->num_threads);
+    }
+    
+    if (nKB > 0) {
+        int t = 0;
+        for (int k = 0; k < N; k++) {
+            if (inc->rowsB[k]) index[t++] = k;
+        }
+        int **deltaB = mm_alloc_matrix(nKB, N);
+        for (t = 0; t < nKB; t++) {
+            for (int j = 0; j < N; j++) {
+                deltaB[t][j] = (int)((unsigned)inc->matrixB[index[t]][j] - (unsigned)inc->shadowB[index[t]][j]);
+            }
+            V[t] = deltaB[t];
+        }
+        for (int i = 0; i < N; i++) {
+            for (t = 0; t < nKB; t++) {
+                U[i][t] = inc->matrixA[i][index[t]];
+            }
+        }
+        rank_update(N, nKB, U, V, inc->matrixC, inc->num_threads);
+        mm_free_matrix(deltaB);
+    }
+    
+    mm_free_matrix(U);
+    free(V);
+    free(index);
+}
+
+// 根据A、B的变化更新C，返回采用的方式（MM_INC_NONE / ROWCOL / LOWRANK / FULL）
+int matrix_incremental_update(IncrementalProduct *inc) {
+    int N = inc->N;
+    
+    if (!inc->marked) {
+        incremental_diff(N, inc->matrixA, inc->shadowA, inc->rowsA, inc->colsA);
+        incremental_diff(N, inc->matrixB, inc->shadowB, inc->rowsB, inc->colsB);
+    }
+    
+    // 需要重新计算的行/列数，都以N²次乘加为单位；只有比较得到的变化位置才能用低秩更新
+    int rowcol = incremental_count(inc->rowsA, N) + incremental_count(inc->colsB, N);
+    int nKA = inc->marked ? 0 : incremental_count(inc->colsA, N);
+    int nKB = inc->marked ? 0 : incremental_count(inc->rowsB, N);
+    int lowrank = inc->marked ? N + 1 : nKA + nKB;
+    
+    int mode;
+    if (rowcol == 0) {
+        mode = MM_INC_NONE;
+    } else if ((rowcol < lowrank ? rowcol : lowrank) * 2 >= N) {
+        mode = MM_INC_FULL;
+        ultimate_region(N, inc->matrixA, inc->matrixB, inc->matrixC, 0, N, 0, N,
+                        MM_OVERWRITE, inc->num_threads, mm_trace_begin());
+    } else if (lowrank < rowcol) {
+        mode = MM_INC_LOWRANK;
+        incremental_lowrank(inc, nKA, nKB);
+    } else {
+        mode = MM_INC_ROWCOL;
+        incremental_recompute_runs(inc, inc->rowsA, 1);
+        incremental_recompute_runs(inc, inc->colsB, 0);
+    }
+    
+    // 更新副本：A的变化都在rowsA的行中；B的变化在比较时都在rowsB的行中，标记时在colsB的列中
+    for (int i = 0; i < N; i++) {
+        if (inc->rowsA[i]) {
+            memcpy(inc->shadowA[i], inc->matrixA[i], N * sizeof(int));
+        }
+        if (inc->rowsB[i]) {
+            memcpy(inc->shadowB[i], inc->matrixB[i], N * sizeof(int));
+        }
+        if (inc->marked) {
+            for (int j = 0; j < N; j++) {
+                if (inc->colsB[j]) inc->shadowB[i][j] = inc->matrixB[i][j];
+            }
+        }
+    }
+    
+    memset(inc->rowsA, 0, N);
+    memset(inc->colsA, 0, N);
+    memset(inc->rowsB, 0, N);
+    memset(inc->colsB, 0, N);
+    inc->marked = 0;
+    return mode;
+}
+
+void matrix_incremental_free(IncrementalProduct *inc) {
+    if (inc) {
+        mm_free_matrix(inc->shadowA);
+        mm_free_matrix(inc->shadowB);
+        free(inc->rowsA);
+        free(inc->colsA);
+        free(inc->rowsB);
+        free(inc->colsB);
+        free(inc);
+    }
+}
+
 // Strassen算法的递归实现（仅作演示，对大矩阵效果更明显）
 void strassen_add(int **A, int **B, int **C, int size) {
     for (int i = 0; i < size; i++) {
@@ -292,20 +880,67 @@ void matrixmultiply_strassen(int N, int **matrixA, int **matrixB, int **matrixC)
     }
 }
 
+// 转置原语：dst（cols x rows）= src（rows x cols）的转置，两者都由create_matrix/mm_alloc_matrix分配
+void matrix_transpose(int rows, int cols, int **src, int **dst) {
+    mm_transpose(rows, cols, src[0], mm_matrix_ld(src, rows), dst[0], mm_matrix_ld(dst, cols), 0);
+}
+
+// 原地转置N x N方阵
+void matrix_transpose_inplace(int N, int **matrix) {
+    mm_transpose_inplace(N, matrix[0], mm_matrix_ld(matrix, N), 0);
+}
+
 // 辅助函数
-int** create_matrix(int N) {
-    int **matrix = (int**)malloc(N * sizeof(int*));
-    for (int i = 0; i < N; i++) {
-        matrix[i] = (int*)_aligned_malloc(N * sizeof(int), 32);
+// 执行时间线追踪：start清空并开启，stop关闭并写出Chrome trace JSON（返回事件数，失败返回-1）
+void matrix_trace_start(void) {
+    mm_trace_start();
+}
+
+int matrix_trace_stop(const char *path) {
+    return mm_trace_stop(path);
+}
+
+// 结果校验（Freivalds算法）：O(N²)检查C是否等于A*B，reps次重复的漏检率不超过2^-reps。
+// 可用于检查任何版本由create_matrix分配的结果。通过返回1，不一致返回0
+int matrix_verify_freivalds(int N, int **matrixA, int **matrixB, int **matrixC, int reps) {
+    if (N <= 0) {
+        return 1;
     }
-    return matrix;
+    return mm_verify_freivalds(N, N, N, matrixA[0], mm_matrix_ld(matrixA, N), matrixB[0], mm_matrix_ld(matrixB, N),
+                               matrixC[0], mm_matrix_ld(matrixC, N), reps, 0, 0);
 }
 
-void free_matrix(int **matrix, int N) {
-    for (int i = 0; i < N; i++) {
-        _aligned_free(matrix[i]);
+// 达到目标漏检率需要的重复次数
+int matrix_verify_reps(double target) {
+    return mm_verify_reps(target);
+}
+
+// 带校验的终极优化版本（覆盖C）：计算后用Freivalds检查，发现不一致时改用单线程转置版本重新计算。
+// 返回MM_VERIFY_PASSED / MM_VERIFY_RECOVERED / MM_VERIFY_FAILED
+int matrixmultiply_ultimate_verified(int N, int **matrixA, int **matrixB, int **matrixC, int reps) {
+    matrixmultiply_ultimate_ex(N, matrixA, matrixB, matrixC, MM_OVERWRITE);
+    if (matrix_verify_freivalds(N, matrixA, matrixB, matrixC, reps)) {
+        return MM_VERIFY_PASSED;
     }
-    free(matrix);
+    fprintf(stderr, "matrixmultiply_ultimate: %dx%d 结果未通过校验，使用转置版本重新计算\n", N, N);
+    matrixmultiply_transpose_ex(N, matrixA, matrixB, matrixC, MM_OVERWRITE);
+    return matrix_verify_freivalds(N, matrixA, matrixB, matrixC, reps) ? MM_VERIFY_RECOVERED : MM_VERIFY_FAILED;
+}
+
+int** create_matrix(int N) {
+    return mm_alloc_matrix(N, N);
+}
+
+void free_matrix(int **matrix, int N) {
+    mm_free_matrix(matrix);
+}
+
+void matrix_set_padding(int enabled) {
+    mm_set_padding(enabled);
+}
+
+int matrix_leading_dim(int **matrix, int N) {
+    return mm_matrix_leading_dim(matrix, N);
 }
 
 void init_test_matrices(int N, int **matrixA, int **matrixB) {
@@ -318,6 +953,41 @@ void init_test_matrices(int N, int **matrixA, int **matrixB) {
 }
 
 #ifdef STANDALONE_TEST
+static int matrices_equal(int N, int **X, int **Y) {
+    for (int i = 0; i < N; i++) {
+        if (memcmp(X[i], Y[i], N * sizeof(int)) != 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// 预打包版本与终极优化版本的结果比较：N不是64的倍数时覆盖掩码处理的尾部面板，
+// B的元素都在int16范围内时覆盖缩窄为int16的面板
+static void check_packed(int N, int small_values) {
+    int **matrixA = create_matrix(N);
+    int **matrixB = create_matrix(N);
+    int **expected = create_matrix(N);
+    int **actual = create_matrix(N);
+    srand(N);
+    for (int i = 0; i < N; i++) {
+        for (int j = 0; j < N; j++) {
+            matrixA[i][j] = rand() % 2001 - 1000;
+            matrixB[i][j] = small_values ? rand() % 2001 - 1000 : rand() - RAND_MAX / 2;
+        }
+    }
+    matrixmultiply_ultimate(N, matrixA, matrixB, expected);
+    PackedMatrix *packedB = matrix_pack_B(N, matrixB, 1);
+    int status = matrixmultiply_ultimate_packed(N, matrixA, packedB, actual, MM_OVERWRITE);
+    printf("N=%d, 元素宽度%d字节: %s\n", N, packedB->elem_bytes,
+           status == 0 && matrices_equal(N, expected, actual) ? "与终极优化版本一致" : "结果不一致");
+    matrix_packed_free(packedB);
+    free_matrix(matrixA, N);
+    free_matrix(matrixB, N);
+    free_matrix(expected, N);
+    free_matrix(actual, N);
+}
+
 int main() {
     int N = 1024; // 测试矩阵大小
     printf("测试各种高级优化版本矩阵乘法，矩阵大小: %dx%d\n", N, N);
@@ -383,11 +1053,61 @@ int main() {
     double time_ultimate = ((double)(end - start)) / CLOCKS_PER_SEC;
     printf("终极优化版本执行时间: %.4f 秒\n", time_ultimate);
     
+    // 测试预打包B版本：打包开销单独计时，乘法重复多次以模拟B固定的场景
+    printf("\n5. 测试预打包B版本:\n");
+    start = clock();
+    PackedMatrix *packedB = matrix_pack_B(N, matrixB, 1);
+    end = clock();
+    double time_pack = ((double)(end - start)) / CLOCKS_PER_SEC;
+    printf("打包B耗时: %.4f 秒 (元素宽度: %d字节)\n", time_pack, packedB->elem_bytes);
+    
+    const int repeats = 3;
+    start = clock();
+    for (int r = 0; r < repeats; r++) {
+        matrixmultiply_ultimate_packed(N, matrixA, packedB, matrixC, MM_OVERWRITE);
+    }
+    end = clock();
+    double time_packed = ((double)(end - start)) / CLOCKS_PER_SEC / repeats;
+    printf("预打包版本单次乘法执行时间: %.4f 秒 (平均%d次)\n", time_packed, repeats);
+    int **matrixP = create_matrix(N);
+    matrixmultiply_ultimate_packed(N, matrixA, packedB, matrixP, MM_OVERWRITE);
+    printf("与终极优化版本一致: %s\n", matrices_equal(N, matrixC, matrixP) ? "是" : "否");
+    PackedMatrix *packedSmall = matrix_pack_B(N - 1, matrixB, 1);
+    printf("打包大小不匹配时返回: %d\n", matrixmultiply_ultimate_packed(N, matrixA, packedSmall, matrixP, MM_OVERWRITE));
+    matrix_packed_free(packedSmall);
+    free_matrix(matrixP, N);
+    matrix_packed_free(packedB);
+    check_packed(100, 1);
+    check_packed(100, 0);
+    check_packed(257, 1);
+    
+    // 执行时间线追踪：用 chrome://tracing 或 ui.perfetto.dev 打开
+    printf("\n6. 记录终极优化版本的执行时间线:\n");
+    matrix_trace_start();
+    matrixmultiply_ultimate(N, matrixA, matrixB, matrixC);
+    int events = matrix_trace_stop("trace_ultimate.json");
+    printf("写出 %d 个事件到 trace_ultimate.json\n", events);
+    
+    // Freivalds校验：代价与一次矩阵乘法相比；再改动一个元素，检查能否发现
+    printf("\n7. Freivalds结果校验:\n");
+    int reps = matrix_verify_reps(1e-6);
+    start = clock();
+    int passed = matrix_verify_freivalds(N, matrixA, matrixB, matrixC, reps);
+    end = clock();
+    double time_verify = ((double)(end - start)) / CLOCKS_PER_SEC;
+    printf("校验%d次（漏检率 <= 2^-%d）: %s，耗时 %.4f 秒（终极优化版本的 %.2f%%）\n", reps, reps,
+           passed ? "通过" : "未通过", time_verify, time_verify / time_ultimate * 100);
+    matrixC[N / 3][N - 1] += 1;
+    printf("改动一个元素后: %s\n", matrix_verify_freivalds(N, matrixA, matrixB, matrixC, reps) ? "未发现" : "发现不一致");
+    printf("带校验版本: %s\n", matrixmultiply_ultimate_verified(N, matrixA, matrixB, matrixC, reps) == MM_VERIFY_PASSED ?
+           "通过" : "未通过");
+    
     // 性能对比
     printf("\n性能对比（以循环展开为基准）:\n");
     printf("转置优化加速: %.2fx\n", time_unrolled / time_transpose);
     printf("预取优化加速: %.2fx\n", time_unrolled / time_prefetch);
     printf("终极优化加速: %.2fx\n", time_unrolled / time_ultimate);
+    printf("预打包版本加速: %.2fx (不含打包)\n", time_unrolled / time_packed);
     
     // 释放内存
     free_matrix(matrixA, N);
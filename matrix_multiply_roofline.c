@@ -0,0 +1,276 @@
+#define _POSIX_C_SOURCE 200809L  // clock_gettime
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <immintrin.h>
+#include "matrix_platform.h"
+
+// Roofline微基准探针：测量本机的峰值SIMD运算吞吐量和持续内存带宽，
+// 作为performance_test.py --roofline中各个版本的"屋顶"。
+// 每个探针执行固定的工作量并返回完成的工作量（运算次数或字节数），
+// 计时由调用方完成，与其他版本的测试方式保持一致。
+//
+// 运算次数的计法与矩阵乘法相同：一次乘法和一次加法各算一次运算，
+// 即 N x N 矩阵乘法共 2 * N^3 次运算。
+
+#define INT32_CHAINS   8   // int32探针的独立累加器个数（对应8个ymm寄存器）
+#define FLOAT32_CHAINS 10  // FMA延迟约4个周期、每周期可发射2条，需要至少8条独立依赖链
+
+// 防止编译器把探针的计算结果当作无用代码删除
+static volatile int probe_sink_i;
+static volatile float probe_sink_f;
+
+// 探针线程参数结构体
+typedef struct {
+    long long iterations;   // 计算探针：每个线程的迭代次数
+    const int *buffer;      // 带宽探针：本线程读取的内存区域
+    size_t count;           // 带宽探针：区域中的int个数
+    int passes;             // 带宽探针：重复读取的遍数
+    int seed;
+    int result_i;
+    float result_f;
+} ProbeThreadParams;
+
+// int32峰值：与SIMD版本内层循环相同的指令组合（_mm256_mullo_epi32 + _mm256_add_epi32）。
+// a每次迭代都变化，乘法不能被提到循环外；b由运行时的seed得到，编译器无法把乘法化简为移位；
+// 累加器之间互不依赖，吞吐量受乘法单元限制
+MM_THREAD_FUNC int32_probe_thread(void* arg) {
+    ProbeThreadParams* params = (ProbeThreadParams*)arg;
+    __m256i a = _mm256_set1_epi32(params->seed);
+    __m256i one = _mm256_set1_epi32(1);
+    __m256i b[INT32_CHAINS];
+    __m256i acc[INT32_CHAINS];
+
+    #pragma GCC unroll 8
+    for (int v = 0; v < INT32_CHAINS; v++) {
+        b[v] = _mm256_set1_epi32(params->seed * (v * 2 + 3));
+        acc[v] = _mm256_setzero_si256();
+    }
+
+    for (long long it = 0; it < params->iterations; it++) {
+        a = _mm256_add_epi32(a, one);
+        #pragma GCC unroll 8
+        for (int v = 0; v < INT32_CHAINS; v++) {
+            acc[v] = _mm256_add_epi32(acc[v], _mm256_mullo_epi32(a, b[v]));
+        }
+    }
+
+    __m256i sum = acc[0];
+    for (int v = 1; v < INT32_CHAINS; v++) {
+        sum = _mm256_add_epi32(sum, acc[v]);
+    }
+    params->result_i = _mm256_extract_epi32(sum, 0);
+
+    return MM_THREAD_RETURN;
+}
+
+// float32峰值：acc = acc * 0.5 + 1 收敛到2，数值始终保持正常范围（不会出现非规格化数）
+MM_THREAD_FUNC float32_probe_thread(void* arg) {
+    ProbeThreadParams* params = (ProbeThreadParams*)arg;
+    __m256 half = _mm256_set1_ps(0.5f);
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 acc[FLOAT32_CHAINS];
+
+    #pragma GCC unroll 10
+    for (int v = 0; v < FLOAT32_CHAINS; v++) {
+        acc[v] = _mm256_set1_ps((float)(params->seed + v));
+    }
+
+    for (long long it = 0; it < params->iterations; it++) {
+        #pragma GCC unroll 10
+        for (int v = 0; v < FLOAT32_CHAINS; v++) {
+            acc[v] = _mm256_fmadd_ps(acc[v], half, one);
+        }
+    }
+
+    __m256 sum = acc[0];
+    for (int v = 1; v < FLOAT32_CHAINS; v++) {
+        sum = _mm256_add_ps(sum, acc[v]);
+    }
+    params->result_f = _mm_cvtss_f32(_mm256_castps256_ps128(sum));
+
+    return MM_THREAD_RETURN;
+}
+
+// 内存带宽：顺序读取远大于末级cache的缓冲区（矩阵乘法对A、B以读为主）
+MM_THREAD_FUNC bandwidth_probe_thread(void* arg) {
+    ProbeThreadParams* params = (ProbeThreadParams*)arg;
+    const __m256i *data = (const __m256i*)params->buffer;
+    size_t vectors = params->count / 8;
+    __m256i acc0 = _mm256_setzero_si256();
+    __m256i acc1 = _mm256_setzero_si256();
+    __m256i acc2 = _mm256_setzero_si256();
+    __m256i acc3 = _mm256_setzero_si256();
+
+    for (int pass = 0; pass < params->passes; pass++) {
+        for (size_t v = 0; v + 4 <= vectors; v += 4) {
+            acc0 = _mm256_add_epi32(acc0, _mm256_load_si256(data + v));
+            acc1 = _mm256_add_epi32(acc1, _mm256_load_si256(data + v + 1));
+            acc2 = _mm256_add_epi32(acc2, _mm256_load_si256(data + v + 2));
+            acc3 = _mm256_add_epi32(acc3, _mm256_load_si256(data + v + 3));
+        }
+    }
+
+    __m256i sum = _mm256_add_epi32(_mm256_add_epi32(acc0, acc1), _mm256_add_epi32(acc2, acc3));
+    params->result_i = _mm256_extract_epi32(sum, 0);
+
+    return MM_THREAD_RETURN;
+}
+
+// 用num_threads个线程运行探针（num_threads == 1 时直接在调用线程中运行）
+static void run_probe(mm_thread_fn fn, ProbeThreadParams *params, int num_threads) {
+    if (num_threads == 1) {
+        fn(&params[0]);
+        return;
+    }
+
+    mm_thread_t* threads = (mm_thread_t*)malloc(num_threads * sizeof(mm_thread_t));
+    for (int t = 0; t < num_threads; t++) {
+        mm_thread_create(&threads[t], fn, &params[t]);
+    }
+    mm_thread_join_all(threads, num_threads);
+    free(threads);
+}
+
+// 探针默认使用的线程数：系统逻辑CPU核心数
+int roofline_default_threads() {
+    return mm_cpu_count();
+}
+
+// int32峰值探针，返回完成的运算次数
+long long roofline_probe_int32(int num_threads, long long iterations) {
+    if (num_threads <= 0) num_threads = mm_cpu_count();
+
+    ProbeThreadParams* params = (ProbeThreadParams*)calloc(num_threads, sizeof(ProbeThreadParams));
+    for (int t = 0; t < num_threads; t++) {
+        params[t].iterations = iterations;
+        params[t].seed = t + 1;
+    }
+
+    run_probe(int32_probe_thread, params, num_threads);
+
+    int sink = 0;
+    for (int t = 0; t < num_threads; t++) {
+        sink += params[t].result_i;
+    }
+    probe_sink_i = sink;
+    free(params);
+
+    // 每次迭代：INT32_CHAINS个向量 x 8个元素 x（乘法 + 加法）
+    return (long long)num_threads * iterations * INT32_CHAINS * 8 * 2;
+}
+
+// float32峰值探针（FMA），返回完成的浮点运算次数
+long long roofline_probe_float32(int num_threads, long long iterations) {
+    if (num_threads <= 0) num_threads = mm_cpu_count();
+
+    ProbeThreadParams* params = (ProbeThreadParams*)calloc(num_threads, sizeof(ProbeThreadParams));
+    for (int t = 0; t < num_threads; t++) {
+        params[t].iterations = iterations;
+        params[t].seed = t + 1;
+    }
+
+    run_probe(float32_probe_thread, params, num_threads);
+
+    float sink = 0.0f;
+    for (int t = 0; t < num_threads; t++) {
+        sink += params[t].result_f;
+    }
+    probe_sink_f = sink;
+    free(params);
+
+    // 每条FMA：8个元素 x（乘法 + 加法）
+    return (long long)num_threads * iterations * FLOAT32_CHAINS * 8 * 2;
+}
+
+// 分配并初始化带宽探针使用的缓冲区（初始化使物理页在计时之前全部分配好）
+int* roofline_buffer_alloc(long long bytes) {
+    size_t count = (size_t)bytes / sizeof(int);
+    int *buffer = (int*)mm_aligned_malloc(count * sizeof(int), 64);
+    if (buffer == NULL) {
+        return NULL;
+    }
+    for (size_t i = 0; i < count; i++) {
+        buffer[i] = (int)i;
+    }
+    return buffer;
+}
+
+void roofline_buffer_free(int *buffer) {
+    mm_aligned_free(buffer);
+}
+
+// 内存带宽探针：各线程读取缓冲区中互不重叠的一段，返回读取的总字节数
+long long roofline_probe_bandwidth(int num_threads, const int *buffer, long long bytes, int passes) {
+    if (num_threads <= 0) num_threads = mm_cpu_count();
+
+    // 每个线程的区域按32个int（128字节）对齐，与循环一次读取的4个向量一致
+    size_t count = (size_t)bytes / sizeof(int);
+    size_t per_thread = (count / num_threads) / 32 * 32;
+
+    ProbeThreadParams* params = (ProbeThreadParams*)calloc(num_threads, sizeof(ProbeThreadParams));
+    for (int t = 0; t < num_threads; t++) {
+        params[t].buffer = buffer + (size_t)t * per_thread;
+        params[t].count = per_thread;
+        params[t].passes = passes;
+    }
+
+    run_probe(bandwidth_probe_thread, params, num_threads);
+
+    int sink = 0;
+    for (int t = 0; t < num_threads; t++) {
+        sink += params[t].result_i;
+    }
+    probe_sink_i = sink;
+    free(params);
+
+    return (long long)num_threads * per_thread * sizeof(int) * passes;
+}
+
+#ifdef STANDALONE_TEST
+// 墙上时间（秒）：多线程探针不能用clock()计时，它统计的是所有线程的CPU时间
+static double wall_time() {
+#ifdef _WIN32
+    LARGE_INTEGER freq, counter;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+}
+
+int main() {
+    int num_threads = roofline_default_threads();
+    long long bytes = 512LL * 1024 * 1024;
+    printf("Roofline微基准探针，线程数: %d\n", num_threads);
+
+    // 单核峰值和全部核心的峰值
+    for (int threads = 1; threads <= num_threads; threads = (threads == 1 && num_threads > 1) ? num_threads : threads + 1) {
+        double start = wall_time();
+        long long ops = roofline_probe_int32(threads, 50000000);
+        double int32_rate = ops / (wall_time() - start);
+
+        start = wall_time();
+        ops = roofline_probe_float32(threads, 50000000);
+        double float32_rate = ops / (wall_time() - start);
+
+        printf("%2d线程: int32峰值 %8.2f GOPS, float32峰值 %8.2f GFLOPS\n",
+               threads, int32_rate / 1e9, float32_rate / 1e9);
+    }
+
+    int *buffer = roofline_buffer_alloc(bytes);
+    if (buffer == NULL) {
+        printf("带宽探针缓冲区分配失败\n");
+        return 1;
+    }
+    double start = wall_time();
+    long long read_bytes = roofline_probe_bandwidth(num_threads, buffer, bytes, 3);
+    printf("内存读带宽: %.2f GB/s\n", read_bytes / (wall_time() - start) / 1e9);
+    roofline_buffer_free(buffer);
+
+    return 0;
+}
+#endif
@@ -0,0 +1,489 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <string.h>
+#include <stdint.h>
+#include <immintrin.h>
+#include "matrix_platform.h"
+#include "matrix_layout.h"
+#include "matrix_kernel.h"
+
+// 半环上的矩阵乘法：C[i][j] = ⊕_k (A[i][k] ⊗ B[k][j])，把普通乘法中的"乘"和"加"换成半环的两个运算。
+//   MM_PLUS_TIMES - (+, x)，普通矩阵乘法，加法单位元为0
+//   MM_MIN_PLUS   - (min, +)，热带半环，加法单位元为+∞：最短路径
+//   MM_MAX_PLUS   - (max, +)，加法单位元为-∞：最长路径、关键路径调度
+// 计算方式与预打包版本相同：按行分配给线程，k方向按SR_KC分块，C的一行在64列的面板上
+// 用8个寄存器累加。半环的两个运算由semiring参数选择，内核对每种半环强制内联一份，
+// 编译后内层循环里只有对应的指令（min-plus为_mm256_add_epi32 + _mm256_min_epi32）。
+// (+, x)在B的各行间距相同时（create_matrix分配的矩阵）直接使用共享行内核 matrix_kernel.h。
+//
+// 无穷大：+∞用MM_INF表示，-∞用-MM_INF表示。min-plus中 >= MM_INF / 2 的输入和结果都视为+∞，
+// 结果统一写成MM_INF（max-plus对称）；因此有限值应位于(-MM_INF / 2, MM_INF / 2)之间，
+// 两个操作数的和始终不会溢出int。
+
+// 半环
+#define MM_PLUS_TIMES 0
+#define MM_MIN_PLUS   1
+#define MM_MAX_PLUS   2
+
+#define MM_INF        0x3FFFFFFF          // +∞
+#define MM_INF_LIMIT  (MM_INF / 2)        // 绝对值不小于它的值视为无穷
+
+#define SR_NR MM_KERNEL_NR   // 面板宽度（列数），与共享行内核一致
+#define SR_KC MM_KERNEL_KC   // k方向的分块大小，使B的块(SR_KC x SR_NR)驻留在L2 cache中
+
+#if defined(_MSC_VER)
+#define SR_INLINE static __forceinline
+#else
+#define SR_INLINE static inline __attribute__((always_inline))
+#endif
+
+// ==================== 半环运算 ====================
+
+// 加法单位元（也是乘法的零元：a ⊗ 单位元 = 单位元）
+SR_INLINE int sr_identity(int semiring) {
+    switch (semiring) {
+    case MM_MIN_PLUS: return MM_INF;
+    case MM_MAX_PLUS: return -MM_INF;
+    default:          return 0;
+    }
+}
+
+// a是否为乘法零元：A[i][k]为零元时第k项对整行没有贡献，可以跳过
+SR_INLINE int sr_is_zero(int semiring, int a) {
+    switch (semiring) {
+    case MM_MIN_PLUS: return a >= MM_INF_LIMIT;
+    case MM_MAX_PLUS: return a <= -MM_INF_LIMIT;
+    default:          return a == 0;
+    }
+}
+
+SR_INLINE __m256i sr_vadd(int semiring, __m256i x, __m256i y) {
+    switch (semiring) {
+    case MM_MIN_PLUS: return _mm256_min_epi32(x, y);
+    case MM_MAX_PLUS: return _mm256_max_epi32(x, y);
+    default:          return _mm256_add_epi32(x, y);
+    }
+}
+
+SR_INLINE __m256i sr_vmul(int semiring, __m256i a, __m256i b) {
+    if (semiring == MM_PLUS_TIMES) {
+        return _mm256_mullo_epi32(a, b);
+    }
+    return _mm256_add_epi32(a, b);
+}
+
+// 把超出有限范围的值规范为MM_INF / -MM_INF
+SR_INLINE __m256i sr_vnormalize(int semiring, __m256i v) {
+    if (semiring == MM_MIN_PLUS) {
+        __m256i inf = _mm256_cmpgt_epi32(v, _mm256_set1_epi32(MM_INF_LIMIT - 1));
+        return _mm256_blendv_epi8(v, _mm256_set1_epi32(MM_INF), inf);
+    }
+    if (semiring == MM_MAX_PLUS) {
+        __m256i inf = _mm256_cmpgt_epi32(_mm256_set1_epi32(1 - MM_INF_LIMIT), v);
+        return _mm256_blendv_epi8(v, _mm256_set1_epi32(-MM_INF), inf);
+    }
+    return v;
+}
+
+static inline int sr_add(int semiring, int x, int y) {
+    switch (semiring) {
+    case MM_MIN_PLUS: return x < y ? x : y;
+    case MM_MAX_PLUS: return x > y ? x : y;
+    default:          return x + y;
+    }
+}
+
+static inline int sr_mul(int semiring, int a, int b) {
+    return semiring == MM_PLUS_TIMES ? a * b : a + b;
+}
+
+static inline int sr_normalize(int semiring, int v) {
+    if (semiring == MM_MIN_PLUS && v >= MM_INF_LIMIT) return MM_INF;
+    if (semiring == MM_MAX_PLUS && v <= -MM_INF_LIMIT) return -MM_INF;
+    return v;
+}
+
+// ==================== 分块SIMD多线程引擎 ====================
+
+// 计算C的一行在一个面板上的部分结果：c_row[0..ncols) (⊕)= ⊕_{k in [k_start, k_end)} a_row[k] ⊗ B[k][jj..]
+// 64个累加值全程保存在8个寄存器中，C在每个k块只读写一次
+SR_INLINE void sr_row_kernel(int semiring, const int *a_row, int **matrixB, int jj,
+                             int k_start, int k_end, int *c_row, int ncols, int first) {
+    __m256i c[8];
+    __m256i mask[8];
+    int full = (ncols == SR_NR);
+
+    // 最后一个面板不足64列时，用掩码只读写有效的列
+    mm_kernel_masks(ncols, mask);
+
+    #pragma GCC unroll 8
+    for (int v = 0; v < 8; v++) {
+        if (first) {
+            c[v] = _mm256_set1_epi32(sr_identity(semiring));
+        } else if (full) {
+            c[v] = _mm256_loadu_si256((__m256i*)&c_row[v * 8]);
+        } else {
+            c[v] = _mm256_maskload_epi32(&c_row[v * 8], mask[v]);
+        }
+    }
+
+    for (int k = k_start; k < k_end; k++) {
+        if (sr_is_zero(semiring, a_row[k])) {
+            continue;
+        }
+        __m256i a = _mm256_set1_epi32(a_row[k]);
+        const int *b_row = matrixB[k] + jj;
+
+        if (full) {
+            #pragma GCC unroll 8
+            for (int v = 0; v < 8; v++) {
+                __m256i b = _mm256_loadu_si256((const __m256i*)&b_row[v * 8]);
+                c[v] = sr_vadd(semiring, c[v], sr_vmul(semiring, a, b));
+            }
+        } else {
+            // 不读取有效列之外的内存（最后一行之后可能没有填充）
+            #pragma GCC unroll 8
+            for (int v = 0; v < 8; v++) {
+                __m256i b = _mm256_maskload_epi32(&b_row[v * 8], mask[v]);
+                c[v] = sr_vadd(semiring, c[v], sr_vmul(semiring, a, b));
+            }
+        }
+    }
+
+    #pragma GCC unroll 8
+    for (int v = 0; v < 8; v++) {
+        __m256i r = sr_vnormalize(semiring, c[v]);
+        if (full) {
+            _mm256_storeu_si256((__m256i*)&c_row[v * 8], r);
+        } else {
+            _mm256_maskstore_epi32(&c_row[v * 8], mask[v], r);
+        }
+    }
+}
+
+// 线程参数结构体
+typedef struct {
+    int N;
+    int **matrixA;
+    int **matrixB;
+    int **matrixC;
+    long long ldb;   // B各行间距相同时为行间距，否则为0
+    int start_row;
+    int end_row;
+    int semiring;
+} SemiringThreadParams;
+
+// 每种半环各实例化一份线程循环，内核中的switch在编译时即被消去
+SR_INLINE void sr_thread_loop(int semiring, SemiringThreadParams *params) {
+    int N = params->N;
+
+    // B的块(SR_KC x SR_NR)在L2中被该线程负责的所有行复用
+    for (int kk = 0; kk < N; kk += SR_KC) {
+        int kk_end = (kk + SR_KC < N) ? kk + SR_KC : N;
+        int first = (kk == 0);
+
+        for (int jj = 0; jj < N; jj += SR_NR) {
+            int ncols = (N - jj < SR_NR) ? N - jj : SR_NR;
+
+            for (int i = params->start_row; i < params->end_row; i++) {
+                if (semiring == MM_PLUS_TIMES && params->ldb > 0) {
+                    // 普通矩阵乘法直接使用共享行内核（matrix_kernel.h）
+                    mm_row_kernel_i32(params->matrixA[i] + kk, 1, params->matrixB[kk] + jj, params->ldb,
+                                      kk_end - kk, &params->matrixC[i][jj], ncols, first, 0);
+                } else {
+                    sr_row_kernel(semiring, params->matrixA[i], params->matrixB, jj,
+                                  kk, kk_end, &params->matrixC[i][jj], ncols, first);
+                }
+            }
+        }
+    }
+}
+
+MM_THREAD_FUNC semiring_thread_function(void* arg) {
+    SemiringThreadParams* params = (SemiringThreadParams*)arg;
+
+    switch (params->semiring) {
+    case MM_MIN_PLUS: sr_thread_loop(MM_MIN_PLUS, params); break;
+    case MM_MAX_PLUS: sr_thread_loop(MM_MAX_PLUS, params); break;
+    default:          sr_thread_loop(MM_PLUS_TIMES, params); break;
+    }
+
+    return MM_THREAD_RETURN;
+}
+
+// 半环矩阵乘法：C = A ⊗ B（C不能与A、B相同）。semiring不是已知的半环时返回-1
+int matrixmultiply_semiring(int N, int **matrixA, int **matrixB, int **matrixC, int semiring) {
+    if (semiring != MM_PLUS_TIMES && semiring != MM_MIN_PLUS && semiring != MM_MAX_PLUS) {
+        return -1;
+    }
+    if (N <= 0) {
+        return 0;
+    }
+
+    // 获取系统CPU核心数
+    int num_threads = mm_cpu_count();
+    if (num_threads > 8) num_threads = 8; // 限制线程数
+    if (num_threads > N) num_threads = N;
+
+    mm_thread_t* threads = (mm_thread_t*)malloc(num_threads * sizeof(mm_thread_t));
+    SemiringThreadParams* params = (SemiringThreadParams*)malloc(num_threads * sizeof(SemiringThreadParams));
+
+    int rows_per_thread = N / num_threads;
+    int remaining_rows = N % num_threads;
+
+    // create_matrix分配的矩阵各行间距相同，此时B可以按(首地址, 行间距)传给共享行内核
+    long long ldb = (N > 1) ? (long long)(matrixB[1] - matrixB[0]) : N;
+    for (int k = 2; k < N && ldb > 0; k++) {
+        if (matrixB[k] != matrixB[0] + k * ldb) {
+            ldb = 0;
+        }
+    }
+    if (ldb < N) {
+        ldb = 0;
+    }
+
+    for (int t = 0; t < num_threads; t++) {
+        params[t].N = N;
+        params[t].matrixA = matrixA;
+        params[t].matrixB = matrixB;
+        params[t].matrixC = matrixC;
+        params[t].ldb = ldb;
+        params[t].start_row = t * rows_per_thread;
+        params[t].end_row = (t + 1) * rows_per_thread;
+        params[t].semiring = semiring;
+
+        // 最后一个线程处理剩余的行
+        if (t == num_threads - 1) {
+            params[t].end_row += remaining_rows;
+        }
+
+        mm_thread_create(&threads[t], semiring_thread_function, &params[t]);
+    }
+
+    mm_thread_join_all(threads, num_threads);
+
+    free(threads);
+    free(params);
+    return 0;
+}
+
+// 标量三重循环版本，作为正确性和性能对比的基准
+int matrixmultiply_semiring_naive(int N, int **matrixA, int **matrixB, int **matrixC, int semiring) {
+    if (semiring != MM_PLUS_TIMES && semiring != MM_MIN_PLUS && semiring != MM_MAX_PLUS) {
+        return -1;
+    }
+
+    for (int i = 0; i < N; i++) {
+        for (int j = 0; j < N; j++) {
+            int sum = sr_identity(semiring);
+            for (int k = 0; k < N; k++) {
+                sum = sr_add(semiring, sum, sr_mul(semiring, matrixA[i][k], matrixB[k][j]));
+            }
+            matrixC[i][j] = sr_normalize(semiring, sum);
+        }
+    }
+    return 0;
+}
+
+// ==================== 全源最短路径（重复平方） ====================
+
+// 全源最短路径（MM_MIN_PLUS）或最长路径（MM_MAX_PLUS）：W为边权矩阵，没有边时为MM_INF（最长路径为-MM_INF）。
+// D从 W（对角线取 min(0, W[i][i])）开始反复平方，D^(2^t)包含所有不超过2^t条边的路径。
+// 最短路径至多N-1条边，但检测负环需要覆盖长度为N的环，因此平方到2^t >= N为止，至多 ceil(log2(N)) 次；
+// D不再变化时提前结束。
+// 返回平方的次数；存在负环（最长路径时为正环）或semiring无效时返回-1
+int apsp_repeated_squaring(int N, int **matrixW, int **matrixD, int semiring) {
+    if (semiring != MM_MIN_PLUS && semiring != MM_MAX_PLUS) {
+        return -1;
+    }
+
+    for (int i = 0; i < N; i++) {
+        for (int j = 0; j < N; j++) {
+            matrixD[i][j] = sr_normalize(semiring, matrixW[i][j]);
+        }
+        // 不经过任何边时路径长度为0
+        matrixD[i][i] = sr_add(semiring, matrixD[i][i], 0);
+    }
+
+    int **temp = mm_alloc_matrix(N, N);
+    int squarings = 0;
+
+    for (long long edges = 1; edges < N; edges *= 2) {
+        matrixmultiply_semiring(N, matrixD, matrixD, temp, semiring);
+        squarings++;
+
+        int changed = 0;
+        for (int i = 0; i < N; i++) {
+            if (memcmp(temp[i], matrixD[i], N * sizeof(int)) != 0) {
+                memcpy(matrixD[i], temp[i], N * sizeof(int));
+                changed = 1;
+            }
+        }
+        if (!changed) {
+            break;
+        }
+    }
+
+    mm_free_matrix(temp);
+
+    // 对角线变为负数（最长路径为正数）说明存在可以无限绕行的环
+    for (int i = 0; i < N; i++) {
+        if (matrixD[i][i] != 0) {
+            return -1;
+        }
+    }
+    return squarings;
+}
+
+// Floyd-Warshall算法（标量），作为全源最短路径的对比基准，返回值含义与apsp_repeated_squaring相同
+int apsp_floyd_warshall(int N, int **matrixW, int **matrixD, int semiring) {
+    if (semiring != MM_MIN_PLUS && semiring != MM_MAX_PLUS) {
+        return -1;
+    }
+
+    for (int i = 0; i < N; i++) {
+        for (int j = 0; j < N; j++) {
+            matrixD[i][j] = sr_normalize(semiring, matrixW[i][j]);
+        }
+        matrixD[i][i] = sr_add(semiring, matrixD[i][i], 0);
+    }
+
+    for (int k = 0; k < N; k++) {
+        for (int i = 0; i < N; i++) {
+            int d_ik = matrixD[i][k];
+            if (sr_is_zero(semiring, d_ik)) {
+                continue;
+            }
+            for (int j = 0; j < N; j++) {
+                matrixD[i][j] = sr_normalize(semiring, sr_add(semiring, matrixD[i][j], d_ik + matrixD[k][j]));
+            }
+        }
+    }
+
+    for (int i = 0; i < N; i++) {
+        if (matrixD[i][i] != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// 辅助函数
+int** create_matrix(int N) {
+    return mm_alloc_matrix(N, N);
+}
+
+void free_matrix(int **matrix, int N) {
+    mm_free_matrix(matrix);
+}
+
+// 生成随机有向图的边权矩阵：每条边以density_percent%的概率存在，权重在[1, max_weight]之间，
+// 没有边时为MM_INF（semiring为MM_MAX_PLUS时生成只含i < j的边的有向无环图，没有边时为-MM_INF）
+void init_graph_matrix(int N, int **matrix, int density_percent, int max_weight, int semiring, unsigned int seed) {
+    uint64_t state = 88172645463325252ULL ^ seed;
+    for (int i = 0; i < N; i++) {
+        for (int j = 0; j < N; j++) {
+            state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+            int has_edge = (int)(state % 100) < density_percent && i != j;
+            if (semiring == MM_MAX_PLUS) {
+                has_edge = has_edge && i < j;
+            }
+            matrix[i][j] = has_edge ? 1 + (int)((state >> 8) % max_weight) : sr_identity(semiring);
+        }
+    }
+}
+
+#ifdef STANDALONE_TEST
+static int count_mismatches(int N, int **X, int **Y) {
+    int errors = 0;
+    for (int i = 0; i < N; i++) {
+        for (int j = 0; j < N; j++) {
+            if (X[i][j] != Y[i][j]) errors++;
+        }
+    }
+    return errors;
+}
+
+int main() {
+    int N = 1024;
+    const char *names[] = {"(+, x)", "(min, +)", "(max, +)"};
+    printf("测试半环矩阵乘法，矩阵大小: %dx%d\n", N, N);
+
+    int **matrixA = create_matrix(N);
+    int **matrixB = create_matrix(N);
+    int **matrixC = create_matrix(N);
+    int **reference = create_matrix(N);
+
+    // 单次乘法：稠密矩阵（density 100%），SIMD版本几乎不能跳过任何k
+    for (int semiring = MM_PLUS_TIMES; semiring <= MM_MAX_PLUS; semiring++) {
+        init_graph_matrix(N, matrixA, 100, 1000, semiring, 1);
+        init_graph_matrix(N, matrixB, 100, 1000, semiring, 2);
+
+        clock_t start = clock();
+        matrixmultiply_semiring_naive(N, matrixA, matrixB, reference, semiring);
+        double naive_time = ((double)(clock() - start)) / CLOCKS_PER_SEC;
+
+        start = clock();
+        matrixmultiply_semiring(N, matrixA, matrixB, matrixC, semiring);
+        double simd_time = ((double)(clock() - start)) / CLOCKS_PER_SEC;
+
+        printf("\n%s 半环:\n", names[semiring]);
+        printf("标量版本: %.4f 秒\n", naive_time);
+        printf("分块SIMD多线程版本: %.4f 秒 (CPU时间)，验证%s\n",
+               simd_time, count_mismatches(N, matrixC, reference) == 0 ? "正确" : "错误");
+    }
+
+    // 全源最短/最长路径：重复平方与Floyd-Warshall对比
+    for (int semiring = MM_MIN_PLUS; semiring <= MM_MAX_PLUS; semiring++) {
+        init_graph_matrix(N, matrixA, 5, 100, semiring, 3);
+
+        clock_t start = clock();
+        apsp_floyd_warshall(N, matrixA, reference, semiring);
+        double fw_time = ((double)(clock() - start)) / CLOCKS_PER_SEC;
+
+        start = clock();
+        int squarings = apsp_repeated_squaring(N, matrixA, matrixC, semiring);
+        double rs_time = ((double)(clock() - start)) / CLOCKS_PER_SEC;
+
+        printf("\n%s 路径:\n", semiring == MM_MIN_PLUS ? "全源最短" : "全源最长（有向无环图）");
+        printf("Floyd-Warshall: %.4f 秒\n", fw_time);
+        printf("重复平方: %.4f 秒 (CPU时间，%d次平方)，验证%s\n",
+               rs_time, squarings, count_mismatches(N, matrixC, reference) == 0 ? "正确" : "错误");
+    }
+
+    // 环检测：长度恰好为N的负环（最长路径为正环）也必须被发现
+    printf("\n环检测（返回-1表示发现负环/正环）:\n");
+    const int cycle2[2][2] = {{0, -5}, {1, 0}};
+    const int cycle3[3][3] = {{MM_INF, 1, MM_INF}, {MM_INF, MM_INF, 1}, {-3, MM_INF, MM_INF}};
+    const int positive2[2][2] = {{0, 5}, {-1, 0}};
+    struct { const char *name; int n; const int *w; int semiring; } cycles[] = {
+        {"2个节点的负环(min, +)", 2, &cycle2[0][0], MM_MIN_PLUS},
+        {"3条边的负环(min, +)", 3, &cycle3[0][0], MM_MIN_PLUS},
+        {"2个节点的正环(max, +)", 2, &positive2[0][0], MM_MAX_PLUS},
+    };
+    for (int c = 0; c < (int)(sizeof(cycles) / sizeof(cycles[0])); c++) {
+        int n = cycles[c].n;
+        int **W = create_matrix(n);
+        int **D = create_matrix(n);
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < n; j++) {
+                W[i][j] = cycles[c].w[i * n + j];
+            }
+        }
+        int rs = apsp_repeated_squaring(n, W, D, cycles[c].semiring);
+        int fw = apsp_floyd_warshall(n, W, D, cycles[c].semiring);
+        printf("%s: 重复平方 %d，Floyd-Warshall %d，%s\n", cycles[c].name, rs, fw,
+               rs == -1 && fw == -1 ? "正确" : "错误");
+        free_matrix(W, n);
+        free_matrix(D, n);
+    }
+
+    free_matrix(matrixA, N);
+    free_matrix(matrixB, N);
+    free_matrix(matrixC, N);
+    free_matrix(reference, N);
+
+    return 0;
+}
+#endif
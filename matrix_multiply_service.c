@@ -0,0 +1,1031 @@
+// 本机矩阵乘法服务（守护进程）
+// 同一台机器上的多个进程各自加载库、各自创建线程时，线程总数远超核心数，互相争抢。
+// 这里由一个常驻的守护进程持有唯一的工作线程池，其他进程通过Unix域套接字提交乘法请求：
+//
+//   - 零拷贝：客户端连接时创建一块共享内存（memfd），通过SCM_RIGHTS把文件描述符交给守护进程，
+//     双方映射同一块内存。A、B、C都分配在这块内存中，请求里只传偏移量，结果由守护进程直接写入C。
+//     守护进程只接受实际大小不小于声明大小、并且已封住缩小（F_SEAL_SHRINK）的memfd，
+//     客户端之后无法截断共享内存，守护进程访问时不会因为SIGBUS退出而影响其他客户端
+//   - 批处理：分派线程把同时排队的多个小请求合成一批，一次分给线程池（每个工作线程取整个小请求），
+//     排队的都是小请求时最多再等 batch_window_us 微秒收集更多请求；大请求按行切分给所有工作线程
+//   - 计算：每个请求（或大请求的一段行）由 matrix_kernel.h 的 mm_gemm_i32 直接在共享内存上计算，B不打包
+//   - 指标：排队深度（当前 / 最大）、批次数和平均批大小、排队时间、计算时间、端到端延迟及其分位数
+//
+// 服务端：matrix_service_run(socket_path, num_workers, batch_window_us) 在前台运行，收到关闭请求后返回。
+// 客户端：matrix_service_connect / matrix_service_alloc / matrix_service_multiply / matrix_service_stats /
+//         matrix_service_shutdown / matrix_service_disconnect。每个连接同一时刻只能有一个未完成的请求，
+//         并发的客户端（进程或线程）各自建立连接。
+// 套接字路径默认为 /tmp/matrix_service.sock，可由环境变量 MATRIX_SERVICE_SOCKET 指定。
+// 注意：本文件依赖Unix域套接字、共享内存和pthread，需要POSIX环境（Linux/WSL）编译运行。
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <immintrin.h>
+#include <pthread.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include "matrix_kernel.h"
+
+// 请求类型
+#define MM_SVC_HELLO    0   // 建立连接：附带共享内存的文件描述符
+#define MM_SVC_GEMM     1   // C[M x N] = A[M x K] x B[K x N]（int32，偏移量相对共享内存起点）
+#define MM_SVC_STATS    2   // 读取服务指标
+#define MM_SVC_SHUTDOWN 3   // 关闭服务
+
+#define MM_SVC_MAX_CLIENTS    64
+#define MM_SVC_QUEUE_CAPACITY 1024          // 排队请求数上限，超过时拒绝（背压）
+#define MM_SVC_MAX_BATCH      64            // 每批最多的请求数
+#define MM_SVC_MAX_WORKERS    8             // 与其他多线程版本相同的线程数上限
+#define MM_SVC_LARGE_WORK     (1LL << 21)   // M*N*K不小于它的请求按行切分给所有工作线程
+#define MM_SVC_HIST_BUCKETS   32            // 延迟直方图：第b个桶为 [2^(b-1), 2^b) 微秒
+
+typedef struct {
+    int type;
+    int M, N, K;
+    long long a_offset;      // A、B、C相对共享内存起点的字节偏移
+    long long b_offset;
+    long long c_offset;
+    int lda, ldb, ldc;       // 行间距（元素个数）
+    long long arena_bytes;   // HELLO：共享内存大小
+} MMServiceRequest;
+
+typedef struct {
+    int status;              // 0成功，-1失败
+    double queue_us;         // 从守护进程收到请求到开始计算
+    double compute_us;       // 计算时间
+} MMServiceReply;
+
+typedef struct {
+    long long requests;        // 已完成的乘法请求数
+    long long rejected;        // 参数无效或队列已满而拒绝的请求数
+    long long batches;         // 分派的批次数
+    int queue_depth;           // 当前排队（尚未分派）的请求数
+    int max_queue_depth;
+    int in_flight;             // 已分派、尚未完成的请求数
+    int workers;
+    int connections;
+    double mean_batch_size;
+    double mean_queue_us;
+    double mean_compute_us;
+    double mean_latency_us;    // 从收到请求到发出回复
+    double p50_latency_us;     // 按2的幂分桶估计（桶的上界）
+    double p99_latency_us;
+} MMServiceStats;
+
+static double svc_now_us() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec * 1e-3;
+}
+
+const char* matrix_service_default_path() {
+    const char *env = getenv("MATRIX_SERVICE_SOCKET");
+    return (env != NULL && env[0] != '\0') ? env : "/tmp/matrix_service.sock";
+}
+
+// 发送 / 接收恰好bytes字节，成功返回0，失败返回-1
+static int svc_send_all(int fd, const void *buf, size_t bytes) {
+    const char *p = (const char*)buf;
+    while (bytes > 0) {
+        ssize_t n = send(fd, p, bytes, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += n;
+        bytes -= n;
+    }
+    return 0;
+}
+
+static int svc_recv_all(int fd, void *buf, size_t bytes) {
+    char *p = (char*)buf;
+    while (bytes > 0) {
+        ssize_t n = recv(fd, p, bytes, 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (n == 0) {
+            return -1; // 对端关闭
+        }
+        p += n;
+        bytes -= n;
+    }
+    return 0;
+}
+
+// ==================== 服务端 ====================
+
+typedef struct {
+    int fd;
+    char *arena;             // 映射的共享内存（HELLO之前为NULL）
+    long long arena_bytes;
+    int in_flight;           // 尚未回复的请求数
+    int closing;             // 对端已断开，最后一个请求完成后释放
+    MMServiceRequest pending;   // 正在接收的请求：只收到一部分时留在这里，等待下一次可读
+    size_t received;            // pending中已收到的字节数
+    int pending_fd;             // 请求附带的文件描述符（没有时为-1）
+} ServiceConnection;
+
+typedef struct {
+    MMServiceRequest req;
+    ServiceConnection *conn;
+    int pending_tasks;       // 尚未完成的切片数
+    double received_us;
+    double dispatched_us;
+} ServiceJob;
+
+// 一个切片：请求的行 [row_start, row_end)
+typedef struct {
+    ServiceJob *job;
+    int row_start;
+    int row_end;
+} ServiceTask;
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t queue_cond;   // 有新请求 / 停止
+    pthread_cond_t work_cond;    // 有新批次 / 停止
+    pthread_cond_t done_cond;    // 当前批次完成
+
+    ServiceJob *queue[MM_SVC_QUEUE_CAPACITY];
+    int queue_head;
+    int queue_count;
+    long long queued_work;       // 排队请求的M*N*K之和
+
+    ServiceTask tasks[MM_SVC_MAX_BATCH * MM_SVC_MAX_WORKERS];
+    int task_count;
+    int next_task;
+    int tasks_done;
+
+    int num_workers;
+    int batch_window_us;
+    int connections;
+    int stop;
+
+    // 指标
+    long long requests, rejected, batches, batched_requests;
+    int max_queue_depth, in_flight;
+    double total_queue_us, total_compute_us, total_latency_us;
+    long long latency_hist[MM_SVC_HIST_BUCKETS];
+} ServiceState;
+
+static void service_release_connection(ServiceConnection *conn) {
+    if (conn->arena != NULL) {
+        munmap(conn->arena, conn->arena_bytes);
+    }
+    if (conn->pending_fd >= 0) {
+        close(conn->pending_fd);
+    }
+    close(conn->fd);
+    free(conn);
+}
+
+static void service_record_latency(ServiceState *s, double latency_us) {
+    int bucket = 0;
+    while (bucket < MM_SVC_HIST_BUCKETS - 1 && (double)(1LL << bucket) <= latency_us) {
+        bucket++;
+    }
+    s->latency_hist[bucket]++;
+}
+
+static double service_latency_percentile(const ServiceState *s, double fraction) {
+    long long total = 0;
+    for (int b = 0; b < MM_SVC_HIST_BUCKETS; b++) {
+        total += s->latency_hist[b];
+    }
+    long long target = (long long)(fraction * total + 0.5);
+    long long seen = 0;
+    for (int b = 0; b < MM_SVC_HIST_BUCKETS; b++) {
+        seen += s->latency_hist[b];
+        if (seen >= target && seen > 0) {
+            return (double)(1LL << b);
+        }
+    }
+    return 0.0;
+}
+
+// 完成一个请求：先记录指标再回复，客户端收到回复后读到的指标已包含该请求（调用时不持有锁）
+static void service_finish_job(ServiceState *s, ServiceJob *job, int status) {
+    double now = svc_now_us();
+    MMServiceReply reply = {status, job->dispatched_us - job->received_us, now - job->dispatched_us};
+
+    pthread_mutex_lock(&s->lock);
+    if (status == 0) {
+        s->requests++;
+        s->total_queue_us += reply.queue_us;
+        s->total_compute_us += reply.compute_us;
+        s->total_latency_us += now - job->received_us;
+        service_record_latency(s, now - job->received_us);
+    }
+    pthread_mutex_unlock(&s->lock);
+
+    // 发送失败说明客户端已断开，连接由下面的计数释放
+    svc_send_all(job->conn->fd, &reply, sizeof(reply));
+
+    pthread_mutex_lock(&s->lock);
+    s->in_flight--;
+    ServiceConnection *conn = job->conn;
+    conn->in_flight--;
+    int release = conn->closing && conn->in_flight == 0;
+    pthread_mutex_unlock(&s->lock);
+
+    if (release) {
+        service_release_connection(conn);
+    }
+    free(job);
+}
+
+static void* service_worker(void *arg) {
+    ServiceState *s = (ServiceState*)arg;
+
+    pthread_mutex_lock(&s->lock);
+    for (;;) {
+        while (!s->stop && s->next_task >= s->task_count) {
+            pthread_cond_wait(&s->work_cond, &s->lock);
+        }
+        // 停止时先做完当前批次剩余的切片
+        if (s->next_task >= s->task_count) {
+            break;
+        }
+
+        ServiceTask task = s->tasks[s->next_task++];
+        pthread_mutex_unlock(&s->lock);
+
+        const MMServiceRequest *req = &task.job->req;
+        char *arena = task.job->conn->arena;
+        const int *A = (const int*)(arena + req->a_offset) + (size_t)task.row_start * req->lda;
+        const int *B = (const int*)(arena + req->b_offset);
+        int *C = (int*)(arena + req->c_offset) + (size_t)task.row_start * req->ldc;
+        mm_gemm_i32(task.row_end - task.row_start, req->N, req->K,
+                    A, req->lda, B, req->ldb, C, req->ldc, 0);
+
+        pthread_mutex_lock(&s->lock);
+        int last = --task.job->pending_tasks == 0;
+        if (last) {
+            pthread_mutex_unlock(&s->lock);
+            service_finish_job(s, task.job, 0);
+            pthread_mutex_lock(&s->lock);
+        }
+        if (++s->tasks_done == s->task_count) {
+            pthread_cond_signal(&s->done_cond);
+        }
+    }
+    pthread_mutex_unlock(&s->lock);
+    return NULL;
+}
+
+// 分派线程：把排队的请求组成批次交给线程池，等待该批次完成后再分派下一批
+static void* service_dispatcher(void *arg) {
+    ServiceState *s = (ServiceState*)arg;
+
+    pthread_mutex_lock(&s->lock);
+    for (;;) {
+        while (!s->stop && s->queue_count == 0) {
+            pthread_cond_wait(&s->queue_cond, &s->lock);
+        }
+        if (s->stop) {
+            break;
+        }
+
+        // 批处理窗口：排队的都是小请求时再等一会儿，收集更多并发到达的请求
+        if (s->batch_window_us > 0 && s->queued_work < MM_SVC_LARGE_WORK && s->queue_count < MM_SVC_MAX_BATCH) {
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_nsec += (long)s->batch_window_us * 1000;
+            deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+            deadline.tv_nsec %= 1000000000L;
+            while (!s->stop && s->queued_work < MM_SVC_LARGE_WORK && s->queue_count < MM_SVC_MAX_BATCH) {
+                if (pthread_cond_timedwait(&s->queue_cond, &s->lock, &deadline) == ETIMEDOUT) {
+                    break;
+                }
+            }
+            if (s->stop) {
+                break;
+            }
+        }
+
+        // 取出一批请求：大请求按行切分给所有工作线程，小请求整个作为一个切片
+        int batch = s->queue_count < MM_SVC_MAX_BATCH ? s->queue_count : MM_SVC_MAX_BATCH;
+        double now = svc_now_us();
+        s->task_count = 0;
+        for (int b = 0; b < batch; b++) {
+            ServiceJob *job = s->queue[s->queue_head];
+            s->queue_head = (s->queue_head + 1) % MM_SVC_QUEUE_CAPACITY;
+            s->queue_count--;
+            long long work = (long long)job->req.M * job->req.N * job->req.K;
+            s->queued_work -= work;
+            job->dispatched_us = now;
+
+            int slices = (work >= MM_SVC_LARGE_WORK) ? s->num_workers : 1;
+            if (slices > job->req.M) slices = job->req.M;
+            if (slices < 1) slices = 1;
+            job->pending_tasks = slices;
+            for (int t = 0; t < slices; t++) {
+                ServiceTask *task = &s->tasks[s->task_count++];
+                task->job = job;
+                task->row_start = (int)((long long)job->req.M * t / slices);
+                task->row_end = (int)((long long)job->req.M * (t + 1) / slices);
+            }
+        }
+        s->in_flight += batch;
+        s->batches++;
+        s->batched_requests += batch;
+        s->next_task = 0;
+        s->tasks_done = 0;
+        pthread_cond_broadcast(&s->work_cond);
+
+        while (!s->stop && s->tasks_done < s->task_count) {
+            pthread_cond_wait(&s->done_cond, &s->lock);
+        }
+    }
+    pthread_mutex_unlock(&s->lock);
+    return NULL;
+}
+
+// 检查行间距为ld的rows x cols矩阵是否完整地位于共享内存中
+static int service_extent_ok(const ServiceConnection *conn, long long offset, int rows, int cols, int ld) {
+    if (offset < 0 || offset > conn->arena_bytes || offset % sizeof(int) != 0 || rows < 0 || cols < 0 || ld < cols) {
+        return 0;
+    }
+    if (rows == 0 || cols == 0) {
+        return 1;
+    }
+    // 先限定offset再与剩余空间比较，避免偏移量很大时溢出
+    long long elems = (long long)(rows - 1) * ld + cols;
+    return elems <= (conn->arena_bytes - offset) / (long long)sizeof(int);
+}
+
+// 检查客户端传来的共享内存：实际大小不小于声明的大小，并且（Linux上）已封住缩小
+static int service_arena_ok(int fd, long long arena_bytes) {
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (long long)st.st_size < arena_bytes) {
+        return 0;
+    }
+#ifdef __linux__
+    int seals = fcntl(fd, F_GET_SEALS);
+    if (seals < 0 || !(seals & F_SEAL_SHRINK)) {
+        return 0;
+    }
+#endif
+    return 1;
+}
+
+static void service_fill_stats(ServiceState *s, MMServiceStats *stats) {
+    memset(stats, 0, sizeof(*stats));
+    stats->requests = s->requests;
+    stats->rejected = s->rejected;
+    stats->batches = s->batches;
+    stats->queue_depth = s->queue_count;
+    stats->max_queue_depth = s->max_queue_depth;
+    stats->in_flight = s->in_flight;
+    stats->workers = s->num_workers;
+    stats->connections = s->connections;
+    if (s->batches > 0) {
+        stats->mean_batch_size = (double)s->batched_requests / s->batches;
+    }
+    if (s->requests > 0) {
+        stats->mean_queue_us = s->total_queue_us / s->requests;
+        stats->mean_compute_us = s->total_compute_us / s->requests;
+        stats->mean_latency_us = s->total_latency_us / s->requests;
+    }
+    stats->p50_latency_us = service_latency_percentile(s, 0.50);
+    stats->p99_latency_us = service_latency_percentile(s, 0.99);
+}
+
+// 非阻塞地读取连接上已到达的数据，追加到conn->pending中。
+// 请求完整时返回1，还不完整时返回0，对端断开或出错时返回-1。
+// I/O线程只有一个，客户端只发来半个请求时不能在这里等待，否则其他连接都会被阻塞
+static int service_recv_request(ServiceConnection *conn) {
+    char control[CMSG_SPACE(sizeof(int))];
+    struct iovec iov = {(char*)&conn->pending + conn->received, sizeof(conn->pending) - conn->received};
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    ssize_t n;
+    do {
+        n = recvmsg(conn->fd, &msg, MSG_DONTWAIT);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return 0;
+    }
+    if (n <= 0) {
+        return -1;
+    }
+
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    if (cmsg != NULL && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+        int fd;
+        memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+        if (conn->pending_fd >= 0) {
+            close(fd); // 一个请求最多附带一个文件描述符
+        } else {
+            conn->pending_fd = fd;
+        }
+    }
+    conn->received += n;
+    return conn->received == sizeof(conn->pending);
+}
+
+// 处理一个连接上已到达的数据，收齐一个请求后执行；连接应被关闭时返回-1
+static int service_handle_request(ServiceState *s, ServiceConnection *conn) {
+    int status = service_recv_request(conn);
+    if (status <= 0) {
+        return status;
+    }
+    MMServiceRequest req = conn->pending;
+    int passed_fd = conn->pending_fd;
+    conn->received = 0;
+    conn->pending_fd = -1;
+
+    MMServiceReply reply = {0, 0.0, 0.0};
+    switch (req.type) {
+    case MM_SVC_HELLO:
+        if (passed_fd < 0 || conn->arena != NULL || req.arena_bytes <= 0 ||
+            !service_arena_ok(passed_fd, req.arena_bytes)) {
+            reply.status = -1;
+        } else {
+            void *arena = mmap(NULL, req.arena_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, passed_fd, 0);
+            if (arena == MAP_FAILED) {
+                reply.status = -1;
+            } else {
+                conn->arena = (char*)arena;
+                conn->arena_bytes = req.arena_bytes;
+            }
+        }
+        if (passed_fd >= 0) close(passed_fd);
+        return svc_send_all(conn->fd, &reply, sizeof(reply));
+
+    case MM_SVC_GEMM: {
+        if (passed_fd >= 0) close(passed_fd);
+        int valid = conn->arena != NULL &&
+                    service_extent_ok(conn, req.a_offset, req.M, req.K, req.lda) &&
+                    service_extent_ok(conn, req.b_offset, req.K, req.N, req.ldb) &&
+                    service_extent_ok(conn, req.c_offset, req.M, req.N, req.ldc);
+        pthread_mutex_lock(&s->lock);
+        if (!valid || s->queue_count >= MM_SVC_QUEUE_CAPACITY) {
+            s->rejected++;
+            pthread_mutex_unlock(&s->lock);
+            reply.status = -1;
+            return svc_send_all(conn->fd, &reply, sizeof(reply));
+        }
+        ServiceJob *job = (ServiceJob*)malloc(sizeof(ServiceJob));
+        job->req = req;
+        job->conn = conn;
+        job->received_us = svc_now_us();
+        s->queue[(s->queue_head + s->queue_count) % MM_SVC_QUEUE_CAPACITY] = job;
+        s->queue_count++;
+        s->queued_work += (long long)req.M * req.N * req.K;
+        if (s->queue_count > s->max_queue_depth) {
+            s->max_queue_depth = s->queue_count;
+        }
+        conn->in_flight++;
+        pthread_cond_signal(&s->queue_cond);
+        pthread_mutex_unlock(&s->lock);
+        return 0;
+    }
+
+    case MM_SVC_STATS: {
+        if (passed_fd >= 0) close(passed_fd);
+        MMServiceStats stats;
+        pthread_mutex_lock(&s->lock);
+        service_fill_stats(s, &stats);
+        pthread_mutex_unlock(&s->lock);
+        if (svc_send_all(conn->fd, &reply, sizeof(reply)) != 0) {
+            return -1;
+        }
+        return svc_send_all(conn->fd, &stats, sizeof(stats));
+    }
+
+    case MM_SVC_SHUTDOWN:
+        if (passed_fd >= 0) close(passed_fd);
+        pthread_mutex_lock(&s->lock);
+        s->stop = 1;
+        pthread_mutex_unlock(&s->lock);
+        svc_send_all(conn->fd, &reply, sizeof(reply));
+        return 0;
+
+    default:
+        if (passed_fd >= 0) close(passed_fd);
+        reply.status = -1;
+        return svc_send_all(conn->fd, &reply, sizeof(reply));
+    }
+}
+
+// 在前台运行服务，直到收到关闭请求。num_workers <= 0 时使用 min(核心数, 8)，
+// batch_window_us为小请求的批处理等待时间（0表示不等待）。成功返回0，失败返回-1
+int matrix_service_run(const char *socket_path, int num_workers, int batch_window_us) {
+    if (socket_path == NULL) {
+        socket_path = matrix_service_default_path();
+    }
+    if (num_workers <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        num_workers = cpus > 0 ? (int)cpus : 1;
+    }
+    if (num_workers > MM_SVC_MAX_WORKERS) num_workers = MM_SVC_MAX_WORKERS;
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(addr.sun_path)) {
+        printf("Socket path too long: %s\n", socket_path);
+        return -1;
+    }
+    strcpy(addr.sun_path, socket_path);
+
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        perror("socket");
+        return -1;
+    }
+    unlink(socket_path);
+    if (bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(listen_fd, MM_SVC_MAX_CLIENTS) != 0) {
+        perror("bind");
+        close(listen_fd);
+        return -1;
+    }
+
+    ServiceState *s = (ServiceState*)calloc(1, sizeof(ServiceState));
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_cond_init(&s->queue_cond, NULL);
+    pthread_cond_init(&s->work_cond, NULL);
+    pthread_cond_init(&s->done_cond, NULL);
+    s->num_workers = num_workers;
+    s->batch_window_us = batch_window_us;
+
+    pthread_t dispatcher;
+    pthread_t workers[MM_SVC_MAX_WORKERS];
+    pthread_create(&dispatcher, NULL, service_dispatcher, s);
+    for (int w = 0; w < num_workers; w++) {
+        pthread_create(&workers[w], NULL, service_worker, s);
+    }
+
+    // I/O线程：接受连接、读取请求（回复由完成请求的工作线程发送）。套接字按非阻塞方式读取，
+    // 请求分几次到达时每个连接各自缓存已收到的部分，一个慢客户端不会阻塞其他连接
+    struct pollfd fds[MM_SVC_MAX_CLIENTS + 1];
+    ServiceConnection *conns[MM_SVC_MAX_CLIENTS + 1];
+    int nfds = 1;
+    fds[0].fd = listen_fd;
+    fds[0].events = POLLIN;
+
+    for (;;) {
+        pthread_mutex_lock(&s->lock);
+        int stop = s->stop;
+        pthread_mutex_unlock(&s->lock);
+        if (stop) {
+            break;
+        }
+
+        if (poll(fds, nfds, 200) < 0) {
+            if (errno == EINTR) continue;
+            perror("poll");
+            break;
+        }
+
+        for (int i = nfds - 1; i >= 1; i--) {
+            if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR))) {
+                continue;
+            }
+            if (service_handle_request(s, conns[i]) == 0) {
+                continue;
+            }
+            // 对端断开：还有未完成的请求时由最后完成的工作线程释放连接
+            pthread_mutex_lock(&s->lock);
+            int release = conns[i]->in_flight == 0;
+            conns[i]->closing = 1;
+            s->connections--;
+            pthread_mutex_unlock(&s->lock);
+            if (release) {
+                service_release_connection(conns[i]);
+            }
+            fds[i] = fds[nfds - 1];
+            conns[i] = conns[nfds - 1];
+            nfds--;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            int fd = accept(listen_fd, NULL, NULL);
+            if (fd >= 0 && nfds > MM_SVC_MAX_CLIENTS) {
+                close(fd); // 连接数已满
+            } else if (fd >= 0) {
+                ServiceConnection *conn = (ServiceConnection*)calloc(1, sizeof(ServiceConnection));
+                conn->fd = fd;
+                conn->pending_fd = -1;
+                conns[nfds] = conn;
+                fds[nfds].fd = fd;
+                fds[nfds].events = POLLIN;
+                fds[nfds].revents = 0;
+                nfds++;
+                pthread_mutex_lock(&s->lock);
+                s->connections++;
+                pthread_mutex_unlock(&s->lock);
+            }
+        }
+    }
+
+    pthread_mutex_lock(&s->lock);
+    s->stop = 1;
+    pthread_cond_broadcast(&s->queue_cond);
+    pthread_cond_broadcast(&s->work_cond);
+    pthread_cond_broadcast(&s->done_cond);
+    pthread_mutex_unlock(&s->lock);
+    pthread_join(dispatcher, NULL);
+    for (int w = 0; w < num_workers; w++) {
+        pthread_join(workers[w], NULL);
+    }
+
+    // 仍在排队的请求不再计算，关闭连接后客户端会收到错误
+    while (s->queue_count > 0) {
+        free(s->queue[s->queue_head]);
+        s->queue_head = (s->queue_head + 1) % MM_SVC_QUEUE_CAPACITY;
+        s->queue_count--;
+    }
+    for (int i = 1; i < nfds; i++) {
+        service_release_connection(conns[i]);
+    }
+    close(listen_fd);
+    unlink(socket_path);
+    pthread_mutex_destroy(&s->lock);
+    pthread_cond_destroy(&s->queue_cond);
+    pthread_cond_destroy(&s->work_cond);
+    pthread_cond_destroy(&s->done_cond);
+    free(s);
+    return 0;
+}
+
+// ==================== 客户端 ====================
+
+typedef struct {
+    int fd;
+    char *arena;
+    long long arena_bytes;
+    long long used;           // 已分配的字节数（按64字节对齐递增）
+    double last_queue_us;     // 最近一次乘法在守护进程中的排队时间和计算时间
+    double last_compute_us;
+} MMServiceClient;
+
+// 创建共享内存：Linux上使用memfd并封住缩小（守护进程要求），其他系统使用删除了名字的临时文件
+static int svc_create_shared_fd(long long bytes) {
+#ifdef __linux__
+    int fd = memfd_create("matrix_service", MFD_ALLOW_SEALING);
+#else
+    char name[] = "/tmp/matrix_service_XXXXXX";
+    int fd = mkstemp(name);
+    if (fd >= 0) unlink(name);
+#endif
+    if (fd >= 0 && ftruncate(fd, bytes) != 0) {
+        close(fd);
+        fd = -1;
+    }
+#ifdef __linux__
+    if (fd >= 0 && fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_SEAL) != 0) {
+        close(fd);
+        fd = -1;
+    }
+#endif
+    return fd;
+}
+
+// 连接服务并建立arena_bytes字节的共享内存。socket_path为NULL时使用默认路径；失败返回NULL
+MMServiceClient* matrix_service_connect(const char *socket_path, long long arena_bytes) {
+    if (socket_path == NULL) {
+        socket_path = matrix_service_default_path();
+    }
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(addr.sun_path) || arena_bytes <= 0) {
+        return NULL;
+    }
+    strcpy(addr.sun_path, socket_path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return NULL;
+    }
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return NULL;
+    }
+
+    int shm_fd = svc_create_shared_fd(arena_bytes);
+    void *arena = shm_fd >= 0 ? mmap(NULL, arena_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0) : MAP_FAILED;
+    if (arena == MAP_FAILED) {
+        if (shm_fd >= 0) close(shm_fd);
+        close(fd);
+        return NULL;
+    }
+
+    // HELLO：通过SCM_RIGHTS传递共享内存的文件描述符
+    MMServiceRequest req;
+    memset(&req, 0, sizeof(req));
+    req.type = MM_SVC_HELLO;
+    req.arena_bytes = arena_bytes;
+    char control[CMSG_SPACE(sizeof(int))];
+    memset(control, 0, sizeof(control));
+    struct iovec iov = {&req, sizeof(req)};
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &shm_fd, sizeof(int));
+
+    MMServiceReply reply;
+    ssize_t sent;
+    do {
+        sent = sendmsg(fd, &msg, MSG_NOSIGNAL);
+    } while (sent < 0 && errno == EINTR);
+    close(shm_fd);
+    if (sent != (ssize_t)sizeof(req) || svc_recv_all(fd, &reply, sizeof(reply)) != 0 || reply.status != 0) {
+        munmap(arena, arena_bytes);
+        close(fd);
+        return NULL;
+    }
+
+    MMServiceClient *client = (MMServiceClient*)calloc(1, sizeof(MMServiceClient));
+    client->fd = fd;
+    client->arena = (char*)arena;
+    client->arena_bytes = arena_bytes;
+    return client;
+}
+
+// 从共享内存中分配bytes字节（64字节对齐），空间不足时返回NULL
+void* matrix_service_alloc(MMServiceClient *client, long long bytes) {
+    long long offset = (client->used + 63) / 64 * 64;
+    if (bytes < 0 || offset + bytes > client->arena_bytes) {
+        return NULL;
+    }
+    client->used = offset + bytes;
+    return client->arena + offset;
+}
+
+// 释放共享内存中的全部分配
+void matrix_service_reset(MMServiceClient *client) {
+    client->used = 0;
+}
+
+static long long svc_offset(const MMServiceClient *client, const void *ptr) {
+    const char *p = (const char*)ptr;
+    if (p < client->arena || p > client->arena + client->arena_bytes) {
+        return -1;
+    }
+    return p - client->arena;
+}
+
+// C[M x N] = A[M x K] x B[K x N]（int32）。A、B、C必须位于该连接的共享内存中；成功返回0，失败返回-1
+int matrix_service_multiply(MMServiceClient *client, int M, int N, int K,
+                            const int *A, int lda, const int *B, int ldb, int *C, int ldc) {
+    MMServiceRequest req;
+    memset(&req, 0, sizeof(req));
+    req.type = MM_SVC_GEMM;
+    req.M = M;
+    req.N = N;
+    req.K = K;
+    req.a_offset = svc_offset(client, A);
+    req.b_offset = svc_offset(client, B);
+    req.c_offset = svc_offset(client, C);
+    req.lda = lda;
+    req.ldb = ldb;
+    req.ldc = ldc;
+    if (req.a_offset < 0 || req.b_offset < 0 || req.c_offset < 0) {
+        return -1;
+    }
+
+    MMServiceReply reply;
+    if (svc_send_all(client->fd, &req, sizeof(req)) != 0 || svc_recv_all(client->fd, &reply, sizeof(reply)) != 0) {
+        return -1;
+    }
+    client->last_queue_us = reply.queue_us;
+    client->last_compute_us = reply.compute_us;
+    return reply.status;
+}
+
+// 读取服务指标；成功返回0
+int matrix_service_stats(MMServiceClient *client, MMServiceStats *stats) {
+    MMServiceRequest req;
+    memset(&req, 0, sizeof(req));
+    req.type = MM_SVC_STATS;
+    MMServiceReply reply;
+    if (svc_send_all(client->fd, &req, sizeof(req)) != 0 || svc_recv_all(client->fd, &reply, sizeof(reply)) != 0) {
+        return -1;
+    }
+    return svc_recv_all(client->fd, stats, sizeof(*stats));
+}
+
+// 请求服务关闭（正在计算的请求会完成，仍在排队的请求被丢弃）；成功返回0
+int matrix_service_shutdown(MMServiceClient *client) {
+    MMServiceRequest req;
+    memset(&req, 0, sizeof(req));
+    req.type = MM_SVC_SHUTDOWN;
+    MMServiceReply reply;
+    if (svc_send_all(client->fd, &req, sizeof(req)) != 0 || svc_recv_all(client->fd, &reply, sizeof(reply)) != 0) {
+        return -1;
+    }
+    return reply.status;
+}
+
+void matrix_service_disconnect(MMServiceClient *client) {
+    if (client) {
+        munmap(client->arena, client->arena_bytes);
+        close(client->fd);
+        free(client);
+    }
+}
+
+#ifdef STANDALONE_TEST
+// 负载生成器：fork出守护进程和多个客户端进程，每个客户端连续提交小矩阵乘法请求。
+// 对比两种方式：每个进程各自创建线程计算（线程数 = 客户端数 x 核心数）与所有进程共用服务的线程池。
+//   ./test_service [客户端数] [每个客户端的请求数] [矩阵大小]
+//   ./test_service serve [套接字路径] [工作线程数] [批处理窗口(微秒)]   只运行守护进程
+
+typedef struct {
+    int *A, *B, *C;
+    int M, N, K;
+    int row_start, row_end;
+} LocalTask;
+
+static void* local_thread(void *arg) {
+    LocalTask *t = (LocalTask*)arg;
+    mm_gemm_i32(t->row_end - t->row_start, t->N, t->K, t->A + (size_t)t->row_start * t->K, t->K,
+                t->B, t->N, t->C + (size_t)t->row_start * t->N, t->N, 0);
+    return NULL;
+}
+
+// 对比基准：每次乘法各自创建num_threads个线程（多个进程同时这样做时线程数超过核心数）
+static void local_multiply(int n, int *A, int *B, int *C, int num_threads) {
+    pthread_t threads[MM_SVC_MAX_WORKERS];
+    LocalTask tasks[MM_SVC_MAX_WORKERS];
+    for (int t = 0; t < num_threads; t++) {
+        tasks[t] = (LocalTask){A, B, C, n, n, n, n * t / num_threads, n * (t + 1) / num_threads};
+        pthread_create(&threads[t], NULL, local_thread, &tasks[t]);
+    }
+    for (int t = 0; t < num_threads; t++) {
+        pthread_join(threads[t], NULL);
+    }
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// 运行一轮负载：每个客户端进程把各请求的延迟（微秒）写入共享的latencies，返回总时间（秒）
+static double run_load(int use_service, const char *path, int clients, int requests, int n,
+                       int num_threads, double *latencies, int *errors) {
+    double start = svc_now_us();
+    for (int c = 0; c < clients; c++) {
+        if (fork() != 0) {
+            continue;
+        }
+        size_t elems = (size_t)n * n;
+        MMServiceClient *client = NULL;
+        int *A, *B, *C;
+        if (use_service) {
+            client = matrix_service_connect(path, (long long)(3 * elems * sizeof(int) + 256));
+            if (client == NULL) _exit(1);
+            A = (int*)matrix_service_alloc(client, elems * sizeof(int));
+            B = (int*)matrix_service_alloc(client, elems * sizeof(int));
+            C = (int*)matrix_service_alloc(client, elems * sizeof(int));
+        } else {
+            A = (int*)malloc(elems * sizeof(int));
+            B = (int*)malloc(elems * sizeof(int));
+            C = (int*)malloc(elems * sizeof(int));
+        }
+        for (size_t i = 0; i < elems; i++) {
+            A[i] = (int)((i * 7 + c) % 13) - 6;
+            B[i] = (int)((i * 5 + c) % 11) - 5;
+        }
+
+        int failed = 0;
+        for (int r = 0; r < requests; r++) {
+            double t0 = svc_now_us();
+            if (use_service) {
+                failed |= matrix_service_multiply(client, n, n, n, A, n, B, n, C, n) != 0;
+            } else {
+                local_multiply(n, A, B, C, num_threads);
+            }
+            latencies[(size_t)c * requests + r] = svc_now_us() - t0;
+        }
+
+        // 验证最后一次的结果（抽查几行）
+        for (int i = 0; i < n; i += (n > 7 ? n / 7 : 1)) {
+            for (int j = 0; j < n; j++) {
+                int sum = 0;
+                for (int k = 0; k < n; k++) sum += A[(size_t)i * n + k] * B[(size_t)k * n + j];
+                failed |= sum != C[(size_t)i * n + j];
+            }
+        }
+        if (use_service) {
+            matrix_service_disconnect(client);
+        }
+        _exit(failed ? 1 : 0);
+    }
+
+    *errors = 0;
+    for (int c = 0; c < clients; c++) {
+        int status;
+        wait(&status);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) (*errors)++;
+    }
+    return (svc_now_us() - start) * 1e-6;
+}
+
+static void print_load(const char *name, double elapsed, double *latencies, int count, int errors) {
+    qsort(latencies, count, sizeof(double), compare_double);
+    double sum = 0;
+    for (int i = 0; i < count; i++) sum += latencies[i];
+    printf("%-22s %10.3f %12.0f %10.1f %10.1f %10.1f %8s\n", name, elapsed, count / elapsed, sum / count,
+           latencies[count / 2], latencies[(int)(count * 0.99)], errors == 0 ? "正确" : "错误");
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1 && strcmp(argv[1], "serve") == 0) {
+        const char *path = argc > 2 ? argv[2] : matrix_service_default_path();
+        int workers = argc > 3 ? atoi(argv[3]) : 0;
+        int window = argc > 4 ? atoi(argv[4]) : 200;
+        printf("矩阵乘法服务: %s\n", path);
+        return matrix_service_run(path, workers, window) == 0 ? 0 : 1;
+    }
+
+    int clients = argc > 1 ? atoi(argv[1]) : 8;
+    int requests = argc > 2 ? atoi(argv[2]) : 200;
+    int n = argc > 3 ? atoi(argv[3]) : 64;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int num_threads = cpus > MM_SVC_MAX_WORKERS ? MM_SVC_MAX_WORKERS : (cpus > 0 ? (int)cpus : 1);
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/matrix_service_test_%d.sock", (int)getpid());
+
+    printf("负载生成: %d个客户端进程，每个%d次 %dx%d 乘法，%d个核心\n", clients, requests, n, n, (int)cpus);
+
+    // 各客户端的延迟写入共享内存
+    int count = clients * requests;
+    double *latencies = (double*)mmap(NULL, count * sizeof(double), PROT_READ | PROT_WRITE,
+                                      MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    int errors;
+
+    printf("\n%-22s %10s %12s %10s %10s %10s %8s\n", "方式", "总时间(秒)", "吞吐量(次/秒)",
+           "平均(微秒)", "p50(微秒)", "p99(微秒)", "结果");
+
+    double elapsed = run_load(0, path, clients, requests, n, num_threads, latencies, &errors);
+    print_load("各进程自建线程", elapsed, latencies, count, errors);
+
+    for (int window = 0; window <= 200; window += 200) {
+        pid_t daemon = fork();
+        if (daemon == 0) {
+            _exit(matrix_service_run(path, num_threads, window) == 0 ? 0 : 1);
+        }
+        MMServiceClient *control = NULL;
+        for (int retry = 0; retry < 200 && control == NULL; retry++) {
+            control = matrix_service_connect(path, 4096);
+            if (control == NULL) usleep(10000);
+        }
+        if (control == NULL) {
+            printf("无法连接服务\n");
+            kill(daemon, SIGTERM);
+            return 1;
+        }
+
+        elapsed = run_load(1, path, clients, requests, n, num_threads, latencies, &errors);
+        char name[64];
+        snprintf(name, sizeof(name), "共享服务(窗口%d微秒)", window);
+        print_load(name, elapsed, latencies, count, errors);
+
+        MMServiceStats stats;
+        if (matrix_service_stats(control, &stats) == 0) {
+            printf("  服务指标: %lld个请求 %lld批 平均批大小 %.2f 最大排队深度 %d 平均排队 %.1f 微秒 "
+                   "平均计算 %.1f 微秒 延迟p50/p99 <= %.0f / %.0f 微秒\n",
+                   stats.requests, stats.batches, stats.mean_batch_size, stats.max_queue_depth,
+                   stats.mean_queue_us, stats.mean_compute_us, stats.p50_latency_us, stats.p99_latency_us);
+        }
+        matrix_service_shutdown(control);
+        matrix_service_disconnect(control);
+        waitpid(daemon, NULL, 0);
+    }
+
+    munmap(latencies, count * sizeof(double));
+    return 0;
+}
+#endif
@@ -2,116 +2,143 @@
 #include <stdlib.h>
 #include <time.h>
 #include <string.h>
+#include <stdint.h>
 #include <immintrin.h>  // Intel intrinsics for AVX/SSE
+#include "matrix_platform.h"
+#include "matrix_layout.h"
 
 // 检查系统是否支持AVX指令集
 int check_avx_support() {
-    int cpuInfo[4];
-    __cpuid(cpuInfo, 1);
-    return (cpuInfo[2] & (1 << 28)) != 0;  // Check AVX bit
+    return mm_cpu_has_avx();
 }
 
 // 使用SSE指令集的矩阵乘法（处理4个float/int元素）
-void matrixmultiply_sse(int N, int **matrixA, int **matrixB, int **matrixC) {
+void matrixmultiply_sse_ex(int N, int **matrixA, int **matrixB, int **matrixC, int flags) {
     int i, j, k;
-    
-    // 初始化结果矩阵
-    for (i = 0; i < N; i++) {
-        for (j = 0; j < N; j++) {
-            matrixC[i][j] = 0;
-        }
-    }
+    int accumulate = flags & MM_ACCUMULATE;
     
     // 确保N是4的倍数，否则处理剩余元素
     int N_simd = (N / 4) * 4;
     
     for (i = 0; i < N; i++) {
+        // 流式存储要求16字节对齐，行首未对齐时退回普通存储
+        int stream = (flags & MM_STREAM) && ((uintptr_t)matrixC[i] & 15) == 0;
+        
         for (k = 0; k < N; k++) {
             // 广播matrixA[i][k]到所有4个位置
             __m128i a_broadcast = _mm_set1_epi32(matrixA[i][k]);
             
+            // k == 0 时C尚未写入，直接覆盖；k == N-1 时写出最终结果
+            int first = (k == 0) && !accumulate;
+            int last = (k == N - 1) && stream;
+            
             // 使用SIMD处理4个元素
             for (j = 0; j < N_simd; j += 4) {
                 // 加载matrixB的4个元素
                 __m128i b_vec = _mm_loadu_si128((__m128i*)&matrixB[k][j]);
                 
-                // 加载matrixC的4个元素
-                __m128i c_vec = _mm_loadu_si128((__m128i*)&matrixC[i][j]);
-                
                 // 执行乘法：a_broadcast * b_vec
                 __m128i prod = _mm_mullo_epi32(a_broadcast, b_vec);
                 
-                // 执行加法：c_vec + prod
-                __m128i result = _mm_add_epi32(c_vec, prod);
+                // 执行加法：c_vec + prod（第一次写入时不需要读取C）
+                __m128i result = first ? prod :
+                    _mm_add_epi32(_mm_loadu_si128((__m128i*)&matrixC[i][j]), prod);
                 
                 // 存储结果
-                _mm_storeu_si128((__m128i*)&matrixC[i][j], result);
+                if (last) {
+                    _mm_stream_si128((__m128i*)&matrixC[i][j], result);
+                } else {
+                    _mm_storeu_si128((__m128i*)&matrixC[i][j], result);
+                }
             }
             
             // 处理剩余的元素（非4的倍数部分）
             for (j = N_simd; j < N; j++) {
-                matrixC[i][j] += matrixA[i][k] * matrixB[k][j];
+                if (first) {
+                    matrixC[i][j] = matrixA[i][k] * matrixB[k][j];
+                } else {
+                    matrixC[i][j] += matrixA[i][k] * matrixB[k][j];
+                }
             }
         }
     }
+    
+    // 确保流式存储对其他线程可见
+    if (flags & MM_STREAM) {
+        _mm_sfence();
+    }
+}
+
+void matrixmultiply_sse(int N, int **matrixA, int **matrixB, int **matrixC) {
+    matrixmultiply_sse_ex(N, matrixA, matrixB, matrixC, MM_OVERWRITE);
 }
 
 // 使用AVX2指令集的矩阵乘法（处理8个int元素）
-void matrixmultiply_avx2(int N, int **matrixA, int **matrixB, int **matrixC) {
+void matrixmultiply_avx2_ex(int N, int **matrixA, int **matrixB, int **matrixC, int flags) {
     int i, j, k;
-    
-    // 初始化结果矩阵
-    for (i = 0; i < N; i++) {
-        for (j = 0; j < N; j++) {
-            matrixC[i][j] = 0;
-        }
-    }
+    int accumulate = flags & MM_ACCUMULATE;
     
     // 确保N是8的倍数，否则处理剩余元素
     int N_simd = (N / 8) * 8;
     
     for (i = 0; i < N; i++) {
+        // 流式存储要求32字节对齐，行首未对齐时退回普通存储
+        int stream = (flags & MM_STREAM) && ((uintptr_t)matrixC[i] & 31) == 0;
+        
         for (k = 0; k < N; k++) {
             // 广播matrixA[i][k]到所有8个位置
             __m256i a_broadcast = _mm256_set1_epi32(matrixA[i][k]);
             
+            // k == 0 时C尚未写入，直接覆盖；k == N-1 时写出最终结果
+            int first = (k == 0) && !accumulate;
+            int last = (k == N - 1) && stream;
+            
             // 使用SIMD处理8个元素
             for (j = 0; j < N_simd; j += 8) {
                 // 加载matrixB的8个元素
                 __m256i b_vec = _mm256_loadu_si256((__m256i*)&matrixB[k][j]);
                 
-                // 加载matrixC的8个元素
-                __m256i c_vec = _mm256_loadu_si256((__m256i*)&matrixC[i][j]);
-                
                 // 执行乘法：a_broadcast * b_vec
                 __m256i prod = _mm256_mullo_epi32(a_broadcast, b_vec);
                 
-                // 执行加法：c_vec + prod
-                __m256i result = _mm256_add_epi32(c_vec, prod);
+                // 执行加法：c_vec + prod（第一次写入时不需要读取C）
+                __m256i result = first ? prod :
+                    _mm256_add_epi32(_mm256_loadu_si256((__m256i*)&matrixC[i][j]), prod);
                 
                 // 存储结果
-                _mm256_storeu_si256((__m256i*)&matrixC[i][j], result);
+                if (last) {
+                    _mm256_stream_si256((__m256i*)&matrixC[i][j], result);
+                } else {
+                    _mm256_storeu_si256((__m256i*)&matrixC[i][j], result);
+                }
             }
             
             // 处理剩余的元素（非8的倍数部分）
             for (j = N_simd; j < N; j++) {
-                matrixC[i][j] += matrixA[i][k] * matrixB[k][j];
+                if (first) {
+                    matrixC[i][j] = matrixA[i][k] * matrixB[k][j];
+                } else {
+                    matrixC[i][j] += matrixA[i][k] * matrixB[k][j];
+                }
             }
         }
     }
+    
+    // 确保流式存储对其他线程可见
+    if (flags & MM_STREAM) {
+        _mm_sfence();
+    }
+}
+
+void matrixmultiply_avx2(int N, int **matrixA, int **matrixB, int **matrixC) {
+    matrixmultiply_avx2_ex(N, matrixA, matrixB, matrixC, MM_OVERWRITE);
 }
 
 // 组合SIMD和分块的优化版本
-void matrixmultiply_simd_blocked(int N, int **matrixA, int **matrixB, int **matrixC) {
+void matrixmultiply_simd_blocked_ex(int N, int **matrixA, int **matrixB, int **matrixC, int flags) {
     int i, j, k, ii, jj, kk;
     const int BLOCK_SIZE = 64;
-    
-    // 初始化结果矩阵
-    for (i = 0; i < N; i++) {
-        for (j = 0; j < N; j++) {
-            matrixC[i][j] = 0;
-        }
-    }
+    int accumulate = flags & MM_ACCUMULATE;
     
     // 分块矩阵乘法 + SIMD优化
     for (kk = 0; kk < N; kk += BLOCK_SIZE) {
@@ -119,39 +146,59 @@ void matrixmultiply_simd_blocked(int N, int **matrixA, int **matrixB, int **matr
             for (jj = 0; jj < N; jj += BLOCK_SIZE) {
                 // 在每个块内使用SIMD优化
                 for (k = kk; k < kk + BLOCK_SIZE && k < N; k++) {
+                    // k == 0 是C块的第一次写入，k == N-1 是最后一次写入
+                    int first = (k == 0) && !accumulate;
+                    int last = (k == N - 1) && (flags & MM_STREAM);
+                    
                     for (i = ii; i < ii + BLOCK_SIZE && i < N; i++) {
                         // 广播matrixA[i][k]
                         __m256i a_broadcast = _mm256_set1_epi32(matrixA[i][k]);
                         
                         int j_end = (jj + BLOCK_SIZE < N) ? jj + BLOCK_SIZE : N;
                         int j_simd = jj + ((j_end - jj) / 8) * 8;
+                        int stream = last && ((uintptr_t)matrixC[i] & 31) == 0;
                         
                         // SIMD处理
                         for (j = jj; j < j_simd; j += 8) {
                             __m256i b_vec = _mm256_loadu_si256((__m256i*)&matrixB[k][j]);
-                            __m256i c_vec = _mm256_loadu_si256((__m256i*)&matrixC[i][j]);
                             __m256i prod = _mm256_mullo_epi32(a_broadcast, b_vec);
-                            __m256i result = _mm256_add_epi32(c_vec, prod);
-                            _mm256_storeu_si256((__m256i*)&matrixC[i][j], result);
+                            __m256i result = first ? prod :
+                                _mm256_add_epi32(_mm256_loadu_si256((__m256i*)&matrixC[i][j]), prod);
+                            if (stream) {
+                                _mm256_stream_si256((__m256i*)&matrixC[i][j], result);
+                            } else {
+                                _mm256_storeu_si256((__m256i*)&matrixC[i][j], result);
+                            }
                         }
                         
                         // 处理剩余元素
                         for (j = j_simd; j < j_end; j++) {
-                            matrixC[i][j] += matrixA[i][k] * matrixB[k][j];
+                            if (first) {
+                                matrixC[i][j] = matrixA[i][k] * matrixB[k][j];
+                            } else {
+                                matrixC[i][j] += matrixA[i][k] * matrixB[k][j];
+                            }
                         }
                     }
                 }
             }
         }
     }
+    
+    // 确保流式存储对其他线程可见
+    if (flags & MM_STREAM) {
+        _mm_sfence();
+    }
+}
+
+void matrixmultiply_simd_blocked(int N, int **matrixA, int **matrixB, int **matrixC) {
+    matrixmultiply_simd_blocked_ex(N, matrixA, matrixB, matrixC, MM_OVERWRITE);
 }
 
 // 通用SIMD接口函数
 void matrixmultiply_simd(int N, int **matrixA, int **matrixB, int **matrixC) {
     // 检查AVX2支持
-    int cpuInfo[4];
-    __cpuid(cpuInfo, 7);
-    int has_avx2 = (cpuInfo[1] & (1 << 5)) != 0;
+    int has_avx2 = mm_cpu_has_avx2();
     
     if (has_avx2) {
         printf("Using AVX2 instruction set optimization\n");
@@ -164,19 +211,19 @@ void matrixmultiply_simd(int N, int **matrixA, int **matrixB, int **matrixC) {
 
 // 辅助函数
 int** create_matrix(int N) {
-    // 使用对齐内存分配以优化SIMD访问
-    int **matrix = (int**)malloc(N * sizeof(int*));
-    for (int i = 0; i < N; i++) {
-        matrix[i] = (int*)_aligned_malloc(N * sizeof(int), 32); // 32字节对齐
-    }
-    return matrix;
+    return mm_alloc_matrix(N, N);
 }
 
 void free_matrix(int **matrix, int N) {
-    for (int i = 0; i < N; i++) {
-        _aligned_free(matrix[i]);
-    }
-    free(matrix);
+    mm_free_matrix(matrix);
+}
+
+void matrix_set_padding(int enabled) {
+    mm_set_padding(enabled);
+}
+
+int matrix_leading_dim(int **matrix, int N) {
+    return mm_matrix_leading_dim(matrix, N);
 }
 
 void init_test_matrices(int N, int **matrixA, int **matrixB) {
@@ -0,0 +1,273 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <string.h>
+#include <immintrin.h>
+#include "matrix_platform.h"
+#include "matrix_layout.h"
+#include "matrix_transpose.h"
+#include "matrix_kernel.h"
+
+// 跨步(strided)矩阵乘法接口，供NumPy零拷贝绑定（matrix_numpy.py）使用。
+// 矩阵不再要求是create_matrix分配的行指针数组：元素(i, j)位于
+//   base + i * row_stride + j * col_stride   （单位为元素，可以为负）
+// 因此任意C连续或带步长的NumPy数组都可以直接传入，无需复制。
+// 计算 C (+)= A[M x K] x B[K x N]，支持int32和float32。
+
+#define PANEL_NR MM_KERNEL_NR   // 面板宽度（列数），与共享行内核一致
+#define PANEL_KC MM_KERNEL_KC   // k方向的分块大小，使面板块驻留在L2 cache中
+
+// 元素类型
+#define MM_INT32   0
+#define MM_FLOAT32 1
+
+// 把跨步存储的B打包为连续的列面板：第p个面板的第k行位于 (p * K + k) * PANEL_NR 处，
+// 最后一个面板不足PANEL_NR列时用0填充。int32和float32都是4字节，按位复制即可
+static int* pack_B_panels(int K, int N, const int *B, long long b_rs, long long b_cs) {
+    int num_panels = (N + PANEL_NR - 1) / PANEL_NR;
+    int *packed = (int*)mm_aligned_malloc((size_t)num_panels * K * PANEL_NR * sizeof(int), 32);
+
+    for (int p = 0; p < num_panels; p++) {
+        int jj = p * PANEL_NR;
+        int width = (N - jj < PANEL_NR) ? N - jj : PANEL_NR;
+
+        int *panel = packed + (size_t)p * K * PANEL_NR;
+
+        // 只有列步长为正的转置视图走分块转置，其余布局（包括列步长为0或负数）逐个收集
+        int transposed = (b_rs == 1 && b_cs > 1);
+        if (transposed) {
+            // B是行主序矩阵的转置视图（如NumPy的B.T）：面板就是B^T中width行的分块转置
+            mm_transpose(width, K, B + jj * b_cs, b_cs, panel, PANEL_NR, 1);
+        }
+        for (int k = 0; k < K; k++) {
+            int *dst = panel + (size_t)k * PANEL_NR;
+            const int *src = B + k * b_rs + jj * b_cs;
+
+            if (b_cs == 1) {
+                memcpy(dst, src, width * sizeof(int));
+            } else if (!transposed) {
+                for (int j = 0; j < width; j++) {
+                    dst[j] = src[j * b_cs];
+                }
+            }
+            for (int j = width; j < PANEL_NR; j++) {
+                dst[j] = 0;
+            }
+        }
+    }
+
+    return packed;
+}
+
+// 线程参数结构体
+typedef struct {
+    int M, N, K;
+    int dtype;
+    const int *A;
+    long long a_rs, a_cs;
+    const int *packedB;
+    int *C;
+    long long c_rs, c_cs;
+    int start_row;
+    int end_row;
+    int flags;
+} StridedThreadParams;
+
+MM_THREAD_FUNC strided_thread_function(void* arg) {
+    StridedThreadParams* params = (StridedThreadParams*)arg;
+    int N = params->N, K = params->K;
+    int num_panels = (N + PANEL_NR - 1) / PANEL_NR;
+    int accumulate = params->flags & MM_ACCUMULATE;
+    int tmp[PANEL_NR];
+
+    // K == 0 时也要执行一轮，以便在覆盖模式下把C清零
+    int kk = 0;
+    do {
+        int kk_end = (kk + PANEL_KC < K) ? kk + PANEL_KC : K;
+        int first = (kk == 0) && !accumulate;
+
+        for (int p = 0; p < num_panels; p++) {
+            int jj = p * PANEL_NR;
+            int ncols = (N - jj < PANEL_NR) ? N - jj : PANEL_NR;
+            const int *panel = params->packedB + (size_t)p * K * PANEL_NR;
+
+            for (int i = params->start_row; i < params->end_row; i++) {
+                const int *a_row = params->A + i * params->a_rs;
+                int *c_row = params->C + i * params->c_rs + jj * params->c_cs;
+
+                // C的列不连续时，先收集到连续的临时行中计算，再写回
+                int *dst = (params->c_cs == 1) ? c_row : tmp;
+                if (dst == tmp && !first) {
+                    for (int j = 0; j < ncols; j++) {
+                        tmp[j] = c_row[j * params->c_cs];
+                    }
+                }
+
+                const int *a_blk = a_row + kk * params->a_cs;
+                const int *b_blk = panel + (size_t)kk * PANEL_NR;
+                if (params->dtype == MM_FLOAT32) {
+                    mm_row_kernel_f32((const float*)a_blk, params->a_cs, (const float*)b_blk, PANEL_NR,
+                                      kk_end - kk, (float*)dst, ncols, first);
+                } else {
+                    mm_row_kernel_i32(a_blk, params->a_cs, b_blk, PANEL_NR, kk_end - kk, dst, ncols, first, 0);
+                }
+
+                if (dst == tmp) {
+                    for (int j = 0; j < ncols; j++) {
+                        c_row[j * params->c_cs] = tmp[j];
+                    }
+                }
+            }
+        }
+
+        kk += PANEL_KC;
+    } while (kk < K);
+
+    return MM_THREAD_RETURN;
+}
+
+// 通用跨步接口。dtype为MM_INT32或MM_FLOAT32，num_threads <= 0时自动选择线程数。
+// 从Python通过ctypes.CDLL调用时，调用期间GIL会被释放，多个Python线程可以并发调用
+void matrixmultiply_strided(int M, int N, int K, int dtype,
+                            const void *A, long long a_rs, long long a_cs,
+                            const void *B, long long b_rs, long long b_cs,
+                            void *C, long long c_rs, long long c_cs,
+                            int flags, int num_threads) {
+    if (M <= 0 || N <= 0) {
+        return;
+    }
+
+    if (num_threads <= 0) {
+        // 获取系统CPU核心数
+        num_threads = mm_cpu_count();
+        if (num_threads > 8) num_threads = 8; // 限制线程数
+    }
+    if (num_threads > M) num_threads = M;
+
+    int *packedB = pack_B_panels(K, N, (const int*)B, b_rs, b_cs);
+
+    mm_thread_t* threads = (mm_thread_t*)malloc(num_threads * sizeof(mm_thread_t));
+    StridedThreadParams* params = (StridedThreadParams*)malloc(num_threads * sizeof(StridedThreadParams));
+
+    int rows_per_thread = M / num_threads;
+    int remaining_rows = M % num_threads;
+
+    for (int t = 0; t < num_threads; t++) {
+        params[t].M = M;
+        params[t].N = N;
+        params[t].K = K;
+        params[t].dtype = dtype;
+        params[t].A = (const int*)A;
+        params[t].a_rs = a_rs;
+        params[t].a_cs = a_cs;
+        params[t].packedB = packedB;
+        params[t].C = (int*)C;
+        params[t].c_rs = c_rs;
+        params[t].c_cs = c_cs;
+        params[t].start_row = t * rows_per_thread;
+        params[t].end_row = (t + 1) * rows_per_thread;
+        params[t].flags = flags;
+
+        // 最后一个线程处理剩余的行
+        if (t == num_threads - 1) {
+            params[t].end_row += remaining_rows;
+        }
+    }
+
+    if (num_threads == 1) {
+        // 单线程时直接在调用线程中计算，避免创建线程的开销
+        strided_thread_function(&params[0]);
+    } else {
+        for (int t = 0; t < num_threads; t++) {
+            mm_thread_create(&threads[t], strided_thread_function, &params[t]);
+        }
+
+        mm_thread_join_all(threads, num_threads);
+    }
+
+    free(threads);
+    free(params);
+    mm_aligned_free(packedB);
+}
+
+// 转置：dst（cols x rows，行步长dst_rs）= src（rows x cols，行步长src_rs）的转置。
+// 两者的列步长都必须为1；int32和float32都是4字节，按位复制即可。num_threads <= 0时自动选择线程数
+void transpose_strided(int rows, int cols, const void *src, long long src_rs,
+                       void *dst, long long dst_rs, int num_threads) {
+    mm_transpose(rows, cols, (const int*)src, src_rs, (int*)dst, dst_rs, num_threads);
+}
+
+// 原地转置N x N方阵（行步长rs，列步长为1）
+void transpose_inplace_strided(int N, void *data, long long rs, int num_threads) {
+    mm_transpose_inplace(N, (int*)data, rs, num_threads);
+}
+
+#ifdef STANDALONE_TEST
+int main() {
+    int N = 1024; // 测试矩阵大小
+    printf("测试跨步接口矩阵乘法，矩阵大小: %dx%d\n", N, N);
+
+    // 连续存储的矩阵，行步长为N
+    int *A = (int*)malloc((size_t)N * N * sizeof(int));
+    int *B = (int*)malloc((size_t)N * N * sizeof(int));
+    int *C = (int*)malloc((size_t)N * N * sizeof(int));
+    for (int i = 0; i < N; i++) {
+        for (int j = 0; j < N; j++) {
+            A[i * N + j] = i + j;
+            B[i * N + j] = i * j + 1;
+        }
+    }
+
+    printf("\n测试int32连续存储:\n");
+    clock_t start = clock();
+    matrixmultiply_strided(N, N, N, MM_INT32, A, N, 1, B, N, 1, C, N, 1, MM_OVERWRITE, 0);
+    clock_t end = clock();
+    printf("执行时间: %.4f 秒\n", ((double)(end - start)) / CLOCKS_PER_SEC);
+
+    // 把B按列主序解释（即B的转置），验证任意步长的正确性
+    printf("\n测试int32转置视图（列步长为N）:\n");
+    start = clock();
+    matrixmultiply_strided(N, N, N, MM_INT32, A, N, 1, B, 1, N, C, N, 1, MM_OVERWRITE, 0);
+    end = clock();
+    printf("执行时间: %.4f 秒\n", ((double)(end - start)) / CLOCKS_PER_SEC);
+
+    int errors = 0;
+    for (int i = 0; i < N && errors < 10; i += 97) {
+        for (int j = 0; j < N; j += 89) {
+            int sum = 0;
+            for (int k = 0; k < N; k++) {
+                sum += A[i * N + k] * B[j * N + k];
+            }
+            if (sum != C[i * N + j]) errors++;
+        }
+    }
+    printf("抽样验证: %s\n", errors == 0 ? "正确" : "错误");
+
+    // 转置原语与朴素双重循环对比
+    printf("\n测试转置:\n");
+    start = clock();
+    for (int i = 0; i < N; i++) {
+        for (int j = 0; j < N; j++) {
+            C[j * N + i] = B[i * N + j];
+        }
+    }
+    double naive_time = ((double)(clock() - start)) / CLOCKS_PER_SEC;
+
+    start = clock();
+    transpose_strided(N, N, B, N, C, N, 0);
+    double tiled_time = ((double)(clock() - start)) / CLOCKS_PER_SEC;
+
+    start = clock();
+    transpose_inplace_strided(N, C, N, 0);
+    double inplace_time = ((double)(clock() - start)) / CLOCKS_PER_SEC;
+
+    printf("朴素转置: %.4f 秒, 分块SIMD转置: %.4f 秒, 原地转置: %.4f 秒（转置两次后%s）\n",
+           naive_time, tiled_time, inplace_time, memcmp(B, C, (size_t)N * N * sizeof(int)) == 0 ? "正确" : "错误");
+
+    free(A);
+    free(B);
+    free(C);
+
+    return 0;
+}
+#endif
@@ -0,0 +1,525 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+NumPy零拷贝绑定
+直接把NumPy数组（或任何支持缓冲区协议的对象）的内存地址和步长传给C库中的
+matrixmultiply_strided，不经过create_matrix，也不做逐元素复制。
+
+- 支持int32和float32，C连续或任意步长（包括转置视图、切片、负步长）
+- 另外提供分块SIMD多线程转置（transpose / transpose_inplace）
+- HalfPrecisionLibrary：fp16 / bf16存储、float32累加的矩阵乘法及批量格式转换
+- MatrixServiceClient：本机矩阵乘法服务的客户端，操作数分配在与守护进程共享的内存中（仅POSIX）
+- 通过ctypes.CDLL调用，C函数执行期间GIL被释放，多个Python线程可以并发驱动同一个库
+- 可以通过out参数写入调用者提供的输出数组
+"""
+
+import os
+import ctypes
+import numpy as np
+from ctypes import c_int, c_longlong, c_void_p
+
+# 与matrix_layout.h（写入模式）和matrix_multiply_strided.c（元素类型）中的定义保持一致
+MM_OVERWRITE = 0
+MM_ACCUMULATE = 1
+MM_INT32 = 0
+MM_FLOAT32 = 1
+
+_DTYPES = {
+    np.dtype(np.int32): MM_INT32,
+    np.dtype(np.float32): MM_FLOAT32,
+}
+
+
+class StridedMatrixLibrary:
+    def __init__(self, path=None):
+        """
+        加载跨步接口库
+
+        Args:
+            path (str): 库文件路径，默认在当前目录下查找matrix_strided.dll/.so
+        """
+        if path is None:
+            for name in ('matrix_strided.dll', 'matrix_strided.so'):
+                if os.path.exists(name):
+                    path = os.path.abspath(name)
+                    break
+            else:
+                raise FileNotFoundError("未找到matrix_strided库，请先执行 make matrix_strided.dll")
+
+        # 使用CDLL（而不是PyDLL），ctypes会在调用期间释放GIL
+        self.dll = ctypes.CDLL(path)
+        self.dll.matrixmultiply_strided.argtypes = [
+            c_int, c_int, c_int, c_int,
+            c_void_p, c_longlong, c_longlong,
+            c_void_p, c_longlong, c_longlong,
+            c_void_p, c_longlong, c_longlong,
+            c_int, c_int
+        ]
+        self.dll.matrixmultiply_strided.restype = None
+        self.dll.transpose_strided.argtypes = [c_int, c_int, c_void_p, c_longlong, c_void_p, c_longlong, c_int]
+        self.dll.transpose_strided.restype = None
+        self.dll.transpose_inplace_strided.argtypes = [c_int, c_void_p, c_longlong, c_int]
+        self.dll.transpose_inplace_strided.restype = None
+
+    @staticmethod
+    def _as_matrix(obj, name):
+        """把输入转换为二维数组视图（对ndarray和缓冲区协议对象不复制）"""
+        arr = np.asarray(obj)
+        if arr.ndim != 2:
+            raise ValueError(f"{name} 必须是二维矩阵，实际维数为 {arr.ndim}")
+        if arr.dtype not in _DTYPES:
+            raise TypeError(f"{name} 的元素类型必须是int32或float32，实际为 {arr.dtype}")
+        if any(s % arr.itemsize for s in arr.strides):
+            raise ValueError(f"{name} 的步长不是元素大小的整数倍")
+        return arr
+
+    @staticmethod
+    def _strides(arr):
+        """以元素为单位的行步长和列步长"""
+        return arr.strides[0] // arr.itemsize, arr.strides[1] // arr.itemsize
+
+    def matmul(self, A, B, out=None, accumulate=False, num_threads=0):
+        """
+        计算 out = A @ B（accumulate=True 时为 out += A @ B）
+
+        Args:
+            A, B: 二维int32/float32数组或缓冲区对象，元素类型必须一致
+            out: 可选的输出数组，形状(M, N)，类型与输入一致，可以带步长
+            accumulate (bool): 是否累加到out上
+            num_threads (int): C库内部使用的线程数，0表示自动；
+                               多个Python线程并发调用时建议设为1
+
+        Returns:
+            输出数组
+        """
+        A = self._as_matrix(A, 'A')
+        B = self._as_matrix(B, 'B')
+        if A.dtype != B.dtype:
+            raise TypeError(f"A和B的元素类型不一致: {A.dtype} vs {B.dtype}")
+
+        M, K = A.shape
+        K2, N = B.shape
+        if K != K2:
+            raise ValueError(f"矩阵形状不匹配: {A.shape} x {B.shape}")
+
+        if out is None:
+            if accumulate:
+                raise ValueError("accumulate=True 时必须提供out")
+            out = np.empty((M, N), dtype=A.dtype)
+        else:
+            if not isinstance(out, np.ndarray):
+                raise TypeError("out 必须是NumPy数组")
+            if out.shape != (M, N) or out.dtype != A.dtype:
+                raise ValueError(f"out 的形状/类型应为 {(M, N)}/{A.dtype}，实际为 {out.shape}/{out.dtype}")
+            if not out.flags.writeable:
+                raise ValueError("out 不可写")
+            if any(s % out.itemsize for s in out.strides):
+                raise ValueError("out 的步长不是元素大小的整数倍")
+            if np.shares_memory(out, A) or np.shares_memory(out, B):
+                raise ValueError("out 不能与输入共享内存")
+
+        if M == 0 or N == 0:
+            return out
+
+        a_rs, a_cs = self._strides(A)
+        b_rs, b_cs = self._strides(B)
+        c_rs, c_cs = self._strides(out)
+        flags = MM_ACCUMULATE if accumulate else MM_OVERWRITE
+
+        # ctypes.data 是元素[0, 0]的地址，配合（可能为负的）步长即可寻址所有元素
+        self.dll.matrixmultiply_strided(
+            M, N, K, _DTYPES[A.dtype],
+            A.ctypes.data, a_rs, a_cs,
+            B.ctypes.data, b_rs, b_cs,
+            out.ctypes.data, c_rs, c_cs,
+            flags, num_threads
+        )
+        return out
+
+    def transpose(self, A, out=None, num_threads=0):
+        """
+        计算 out = A.T 并按行连续写出（分块 + AVX2 8x8寄存器转置 + 多线程）
+
+        Args:
+            A: 二维int32/float32数组，列步长必须为1（行步长可以大于列数）
+            out: 可选的输出数组，形状(N, M)，列步长为1
+            num_threads (int): C库内部使用的线程数，0表示自动
+
+        Returns:
+            输出数组
+        """
+        A = self._as_matrix(A, 'A')
+        M, N = A.shape
+        if out is None:
+            out = np.empty((N, M), dtype=A.dtype)
+        elif out.shape != (N, M) or out.dtype != A.dtype:
+            raise ValueError(f"out 的形状/类型应为 {(N, M)}/{A.dtype}，实际为 {out.shape}/{out.dtype}")
+        elif np.shares_memory(out, A):
+            raise ValueError("out 不能与输入共享内存，原地转置请使用transpose_inplace")
+        for arr, name in ((A, 'A'), (out, 'out')):
+            if arr.size and arr.strides[1] != arr.itemsize:
+                raise ValueError(f"{name} 的列步长必须为1（可先用np.ascontiguousarray复制）")
+        if M and N:
+            self.dll.transpose_strided(M, N, A.ctypes.data, self._strides(A)[0],
+                                       out.ctypes.data, self._strides(out)[0], num_threads)
+        return out
+
+    def transpose_inplace(self, A, num_threads=0):
+        """原地转置方阵A（列步长必须为1），返回A"""
+        A = self._as_matrix(A, 'A')
+        if A.shape[0] != A.shape[1]:
+            raise ValueError(f"原地转置要求方阵，实际形状为 {A.shape}")
+        if not A.flags.writeable:
+            raise ValueError("A 不可写")
+        if A.size and A.strides[1] != A.itemsize:
+            raise ValueError("A 的列步长必须为1")
+        if A.size:
+            self.dll.transpose_inplace_strided(A.shape[0], A.ctypes.data, self._strides(A)[0], num_threads)
+        return A
+
+
+# 与matrix_multiply_conv.c中的定义保持一致
+MM_NCHW = 0
+MM_NHWC = 1
+MM_CONV_IM2COL = 0
+MM_CONV_IMPLICIT = 1
+
+
+class ConvShape(ctypes.Structure):
+    _fields_ = [(name, c_int) for name in (
+        'batch', 'in_channels', 'height', 'width',
+        'out_channels', 'kernel_h', 'kernel_w',
+        'stride_h', 'stride_w', 'pad_h', 'pad_w',
+        'dilation_h', 'dilation_w', 'layout')]
+
+
+class ConvLibrary:
+    def __init__(self, path=None):
+        """
+        加载卷积库
+
+        Args:
+            path (str): 库文件路径，默认在当前目录下查找matrix_conv.dll/.so
+        """
+        if path is None:
+            for name in ('matrix_conv.dll', 'matrix_conv.so'):
+                if os.path.exists(name):
+                    path = os.path.abspath(name)
+                    break
+            else:
+                raise FileNotFoundError("未找到matrix_conv库，请先执行 make libs")
+
+        self.dll = ctypes.CDLL(path)
+        self.dll.conv2d.argtypes = [ctypes.POINTER(ConvShape), c_void_p, c_void_p, c_void_p, c_int, c_int]
+        self.dll.conv2d.restype = c_int
+        self.dll.conv2d_output_dims.argtypes = [ctypes.POINTER(ConvShape), ctypes.POINTER(c_int),
+                                                ctypes.POINTER(c_int)]
+        self.dll.conv2d_output_dims.restype = None
+
+    def conv2d(self, x, w, stride=1, padding=0, dilation=1, layout='NCHW', implicit=True, num_threads=0):
+        """
+        int32二维卷积，不生成完整的im2col缓冲区
+
+        Args:
+            x: 输入，NCHW为(N, C, H, W)，NHWC为(N, H, W, C)
+            w: 权重，NCHW为(K, C, R, S)，NHWC为(K, R, S, C)
+            stride, padding, dilation: 整数或(高, 宽)二元组
+            layout (str): 'NCHW' 或 'NHWC'
+            implicit (bool): True使用隐式GEMM，False使用分块im2col
+
+        Returns:
+            输出，NCHW为(N, K, P, Q)，NHWC为(N, P, Q, K)
+        """
+        pair = lambda v: (v, v) if isinstance(v, int) else tuple(v)
+        x = np.ascontiguousarray(x, dtype=np.int32)
+        w = np.ascontiguousarray(w, dtype=np.int32)
+        if x.ndim != 4 or w.ndim != 4:
+            raise ValueError("输入和权重必须是四维数组")
+
+        if layout == 'NCHW':
+            n, c, h, width = x.shape
+            k, wc, r, s = w.shape
+        elif layout == 'NHWC':
+            n, h, width, c = x.shape
+            k, r, s, wc = w.shape
+        else:
+            raise ValueError(f"不支持的布局: {layout}")
+        if c != wc:
+            raise ValueError(f"输入通道数{c}与权重通道数{wc}不一致")
+
+        if min(pair(stride)) <= 0 or min(pair(dilation)) <= 0:
+            raise ValueError(f"步长{stride}和膨胀{dilation}必须为正数")
+
+        shape = ConvShape(n, c, h, width, k, r, s, *pair(stride), *pair(padding), *pair(dilation),
+                          MM_NCHW if layout == 'NCHW' else MM_NHWC)
+        p, q = c_int(), c_int()
+        self.dll.conv2d_output_dims(ctypes.byref(shape), ctypes.byref(p), ctypes.byref(q))
+        if p.value <= 0 or q.value <= 0:
+            raise ValueError("卷积核（含膨胀）大于填充后的输入")
+
+        out_shape = (n, k, p.value, q.value) if layout == 'NCHW' else (n, p.value, q.value, k)
+        out = np.empty(out_shape, dtype=np.int32)
+        if self.dll.conv2d(ctypes.byref(shape), x.ctypes.data, w.ctypes.data, out.ctypes.data,
+                           MM_CONV_IMPLICIT if implicit else MM_CONV_IM2COL, num_threads) != 0:
+            raise ValueError("卷积参数无效")
+        return out
+
+
+# 与matrix_multiply_half.c中的定义保持一致
+MM_FP16 = 0
+MM_BF16 = 1
+_HALF_FORMATS = {'fp16': MM_FP16, 'bf16': MM_BF16}
+
+
+class HalfPrecisionLibrary:
+    def __init__(self, path=None):
+        """
+        加载16位存储（fp16 / bf16）、float32累加的矩阵乘法库
+
+        Args:
+            path (str): 库文件路径，默认在当前目录下查找matrix_half.dll/.so
+        """
+        if path is None:
+            for name in ('matrix_half.dll', 'matrix_half.so'):
+                if os.path.exists(name):
+                    path = os.path.abspath(name)
+                    break
+            else:
+                raise FileNotFoundError("未找到matrix_half库，请先执行 make libs")
+
+        self.dll = ctypes.CDLL(path)
+        self.dll.half_from_float.argtypes = [c_void_p, c_void_p, c_longlong, c_int]
+        self.dll.half_from_float.restype = None
+        self.dll.half_to_float.argtypes = [c_void_p, c_void_p, c_longlong, c_int]
+        self.dll.half_to_float.restype = None
+        self.dll.matrixmultiply_half.argtypes = [
+            c_int, c_int, c_int, c_int,
+            c_void_p, c_longlong, c_void_p, c_longlong,
+            c_void_p, c_longlong, c_int, c_int
+        ]
+        self.dll.matrixmultiply_half.restype = c_int
+
+    @staticmethod
+    def _format(fmt):
+        if fmt not in _HALF_FORMATS:
+            raise ValueError(f"不支持的16位格式: {fmt}（应为 'fp16' 或 'bf16'）")
+        return _HALF_FORMATS[fmt]
+
+    def to_half(self, x, fmt='bf16'):
+        """float32数组 -> 16位格式（就近舍入到偶数），结果为同形状的uint16数组（按位存储）"""
+        x = np.ascontiguousarray(x, dtype=np.float32)
+        out = np.empty(x.shape, dtype=np.uint16)
+        self.dll.half_from_float(x.ctypes.data, out.ctypes.data, x.size, self._format(fmt))
+        return out
+
+    def to_float(self, h, fmt='bf16'):
+        """16位格式（uint16按位存储，fp16也可以直接传入np.float16数组）-> float32"""
+        h = np.ascontiguousarray(h)
+        if h.dtype == np.float16:
+            h = h.view(np.uint16)
+        if h.dtype != np.uint16:
+            raise TypeError(f"16位数据应为uint16或float16数组，实际为 {h.dtype}")
+        out = np.empty(h.shape, dtype=np.float32)
+        self.dll.half_to_float(h.ctypes.data, out.ctypes.data, h.size, self._format(fmt))
+        return out
+
+    def matmul(self, A, B, fmt='bf16', out=None, accumulate=False, num_threads=0):
+        """
+        计算 out = A @ B（accumulate=True 时为 out += A @ B），A、B为16位格式，out为float32
+
+        Args:
+            A, B: 二维uint16（按位存储的fp16 / bf16）或float16数组，列步长必须为1
+            fmt (str): 'fp16' 或 'bf16'
+            out: 可选的float32输出数组，形状(M, N)，列步长为1
+        """
+        mats = []
+        for arr, name in ((A, 'A'), (B, 'B')):
+            arr = np.asarray(arr)
+            if arr.dtype == np.float16:
+                arr = arr.view(np.uint16)
+            if arr.ndim != 2 or arr.dtype != np.uint16:
+                raise TypeError(f"{name} 必须是二维uint16/float16数组")
+            if arr.size and arr.strides[1] != arr.itemsize:
+                arr = np.ascontiguousarray(arr)
+            mats.append(arr)
+        A, B = mats
+        M, K = A.shape
+        K2, N = B.shape
+        if K != K2:
+            raise ValueError(f"矩阵形状不匹配: {A.shape} x {B.shape}")
+        if out is None:
+            if accumulate:
+                raise ValueError("accumulate=True 时必须提供out")
+            out = np.empty((M, N), dtype=np.float32)
+        elif out.shape != (M, N) or out.dtype != np.float32 or (out.size and out.strides[1] != 4):
+            raise ValueError(f"out 应为形状 {(M, N)}、列步长为1的float32数组")
+
+        self.dll.matrixmultiply_half(M, N, K, self._format(fmt),
+                                     A.ctypes.data, A.strides[0] // 2, B.ctypes.data, B.strides[0] // 2,
+                                     out.ctypes.data, out.strides[0] // 4,
+                                     MM_ACCUMULATE if accumulate else MM_OVERWRITE, num_threads)
+        return out
+
+
+class MMServiceStats(ctypes.Structure):
+    """与matrix_multiply_service.c中的MMServiceStats保持一致"""
+    _fields_ = [
+        ('requests', c_longlong), ('rejected', c_longlong), ('batches', c_longlong),
+        ('queue_depth', c_int), ('max_queue_depth', c_int), ('in_flight', c_int),
+        ('workers', c_int), ('connections', c_int),
+        ('mean_batch_size', ctypes.c_double), ('mean_queue_us', ctypes.c_double),
+        ('mean_compute_us', ctypes.c_double), ('mean_latency_us', ctypes.c_double),
+        ('p50_latency_us', ctypes.c_double), ('p99_latency_us', ctypes.c_double),
+    ]
+
+
+class MatrixServiceClient:
+    def __init__(self, socket_path=None, arena_bytes=64 << 20, path=None):
+        """
+        连接本机矩阵乘法服务（先运行 ./test_service serve 启动守护进程）
+
+        Args:
+            socket_path (str): 服务的套接字路径，默认为环境变量MATRIX_SERVICE_SOCKET或/tmp/matrix_service.sock
+            arena_bytes (int): 与守护进程共享的内存大小，所有操作数都从这里分配
+            path (str): 库文件路径，默认在当前目录下查找matrix_service.so
+        """
+        if path is None:
+            if not os.path.exists('matrix_service.so'):
+                raise FileNotFoundError("未找到matrix_service库，请先执行 make libs（需要POSIX环境）")
+            path = os.path.abspath('matrix_service.so')
+
+        self.dll = ctypes.CDLL(path)
+        self.dll.matrix_service_connect.argtypes = [ctypes.c_char_p, c_longlong]
+        self.dll.matrix_service_connect.restype = c_void_p
+        self.dll.matrix_service_alloc.argtypes = [c_void_p, c_longlong]
+        self.dll.matrix_service_alloc.restype = c_void_p
+        self.dll.matrix_service_reset.argtypes = [c_void_p]
+        self.dll.matrix_service_reset.restype = None
+        self.dll.matrix_service_multiply.argtypes = [
+            c_void_p, c_int, c_int, c_int,
+            c_void_p, c_int, c_void_p, c_int, c_void_p, c_int
+        ]
+        self.dll.matrix_service_multiply.restype = c_int
+        self.dll.matrix_service_stats.argtypes = [c_void_p, ctypes.POINTER(MMServiceStats)]
+        self.dll.matrix_service_stats.restype = c_int
+        self.dll.matrix_service_shutdown.argtypes = [c_void_p]
+        self.dll.matrix_service_shutdown.restype = c_int
+        self.dll.matrix_service_disconnect.argtypes = [c_void_p]
+        self.dll.matrix_service_disconnect.restype = None
+
+        self.client = self.dll.matrix_service_connect(
+            socket_path.encode() if socket_path else None, arena_bytes)
+        if not self.client:
+            raise ConnectionError(f"无法连接矩阵乘法服务: {socket_path or '默认路径'}")
+
+    def empty(self, shape):
+        """在共享内存中分配int32数组；守护进程直接读写这块内存，不需要复制"""
+        rows, cols = shape
+        ptr = self.dll.matrix_service_alloc(self.client, rows * cols * 4)
+        if not ptr:
+            raise MemoryError("共享内存空间不足，请增大arena_bytes或调用reset()")
+        return np.ctypeslib.as_array(ctypes.cast(ptr, ctypes.POINTER(c_int)), shape=(rows, cols))
+
+    def reset(self):
+        """释放共享内存中的全部数组（之前empty()返回的数组不能再使用）"""
+        self.dll.matrix_service_reset(self.client)
+
+    def matmul(self, A, B, out):
+        """计算 out = A @ B，A、B、out都必须由empty()分配（或是其列步长为1的切片）"""
+        M, K = A.shape
+        K2, N = B.shape
+        if K != K2 or out.shape != (M, N):
+            raise ValueError(f"矩阵形状不匹配: {A.shape} x {B.shape} -> {out.shape}")
+        for arr, name in ((A, 'A'), (B, 'B'), (out, 'out')):
+            if arr.dtype != np.int32 or (arr.size and arr.strides[1] != 4):
+                raise ValueError(f"{name} 应为列步长为1的int32数组")
+        status = self.dll.matrix_service_multiply(self.client, M, N, K,
+                                                  A.ctypes.data, A.strides[0] // 4,
+                                                  B.ctypes.data, B.strides[0] // 4,
+                                                  out.ctypes.data, out.strides[0] // 4)
+        if status != 0:
+            raise RuntimeError("服务拒绝了请求（操作数不在共享内存中或队列已满）")
+        return out
+
+    def stats(self):
+        """读取服务指标（排队深度、批大小、排队 / 计算时间、延迟分位数）"""
+        stats = MMServiceStats()
+        if self.dll.matrix_service_stats(self.client, ctypes.byref(stats)) != 0:
+            raise ConnectionError("读取服务指标失败")
+        return {name: getattr(stats, name) for name, _ in MMServiceStats._fields_}
+
+    def shutdown(self):
+        """请求守护进程退出"""
+        return self.dll.matrix_service_shutdown(self.client)
+
+    def close(self):
+        if self.client:
+            self.dll.matrix_service_disconnect(self.client)
+            self.client = None
+
+
+_default_library = None
+
+
+def matmul(A, B, out=None, accumulate=False, num_threads=0):
+    """使用默认库计算矩阵乘法，参数同 StridedMatrixLibrary.matmul"""
+    global _default_library
+    if _default_library is None:
+        _default_library = StridedMatrixLibrary()
+    return _default_library.matmul(A, B, out=out, accumulate=accumulate, num_threads=num_threads)
+
+
+if __name__ == "__main__":
+    import time
+    from concurrent.futures import ThreadPoolExecutor
+
+    N = 512
+    print(f"测试NumPy零拷贝绑定，矩阵大小: {N}x{N}")
+
+    A = np.random.randint(-100, 100, (N, N), dtype=np.int32)
+    B = np.random.randint(-100, 100, (N, N), dtype=np.int32)
+
+    start_time = time.time()
+    C = matmul(A, B)
+    print(f"int32执行时间: {time.time() - start_time:.4f} 秒, 正确: {np.array_equal(C, A @ B)}")
+
+    # 转置视图和切片视图无需复制
+    C = matmul(A.T, B[::2, ::2].repeat(2, axis=0))
+    print(f"带步长视图正确: {np.array_equal(C, A.T @ B[::2, ::2].repeat(2, axis=0))}")
+
+    # 行步长为1、列步长为负（反向的转置视图）或为0（列广播）的B
+    B_rev = B.T[:, ::-1]
+    B_bcast = np.broadcast_to(B.T[:, :1], (N, N))
+    ok = np.array_equal(matmul(A, B_rev), A @ B_rev) and np.array_equal(matmul(A, B_bcast), A @ B_bcast)
+    print(f"负步长/广播视图正确: {ok}")
+
+    # 写入调用者提供的输出数组
+    out = np.zeros((N, N), dtype=np.int32)
+    matmul(A, B, out=out)
+    matmul(A, B, out=out, accumulate=True)
+    print(f"累加到out正确: {np.array_equal(out, 2 * (A @ B))}")
+
+    # 转置原语：非原地（含非方阵和行步长大于列数的切片）与原地
+    T = np.random.randint(-100, 100, (N + 3, N - 5), dtype=np.int32)
+    lib = StridedMatrixLibrary()
+    ok = np.array_equal(lib.transpose(T), T.T) and np.array_equal(lib.transpose(T[:, 7:]), T[:, 7:].T)
+    S = A.copy()
+    lib.transpose_inplace(S)
+    print(f"转置正确: {ok and np.array_equal(S, A.T)}")
+
+    Af = np.random.rand(N, N).astype(np.float32)
+    Bf = np.random.rand(N, N).astype(np.float32)
+    print(f"float32正确: {np.allclose(matmul(Af, Bf), Af @ Bf, rtol=1e-4)}")
+
+    # GIL在C函数执行期间被释放，多个Python线程可以并发计算
+    batch = [(np.random.randint(-100, 100, (N, N), dtype=np.int32), B) for _ in range(8)]
+    start_time = time.time()
+    for a, b in batch:
+        matmul(a, b, num_threads=1)
+    serial_time = time.time() - start_time
+
+    start_time = time.time()
+    with ThreadPoolExecutor(max_workers=os.cpu_count()) as pool:
+        list(pool.map(lambda ab: matmul(ab[0], ab[1], num_threads=1), batch))
+    threaded_time = time.time() - start_time
+    print(f"8次乘法: 串行 {serial_time:.4f} 秒, {os.cpu_count()}个Python线程并发 {threaded_time:.4f} 秒")
@@ -0,0 +1,133 @@
+// 平台适配层：线程、互斥锁、CPU核心数、对齐内存分配和CPU指令集检测
+// Windows (MinGW-w64) 下使用Windows线程API，Linux等POSIX系统下使用pthread，
+// 使各个版本的源文件在两个平台上都能编译为动态链接库（.dll / .so）。
+#ifndef MATRIX_PLATFORM_H
+#define MATRIX_PLATFORM_H
+
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <process.h>
+#include <malloc.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#include <mm_malloc.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+// ==================== 线程 ====================
+// 线程函数的写法：
+//   MM_THREAD_FUNC my_thread(void* arg) { ...; return MM_THREAD_RETURN; }
+
+#ifdef _WIN32
+typedef HANDLE mm_thread_t;
+#define MM_THREAD_FUNC unsigned __stdcall
+#define MM_THREAD_RETURN 0
+typedef unsigned (__stdcall *mm_thread_fn)(void*);
+#else
+typedef pthread_t mm_thread_t;
+#define MM_THREAD_FUNC void*
+#define MM_THREAD_RETURN NULL
+typedef void* (*mm_thread_fn)(void*);
+#endif
+
+// 创建线程，成功返回0
+static inline int mm_thread_create(mm_thread_t *thread, mm_thread_fn fn, void *arg) {
+#ifdef _WIN32
+    *thread = (HANDLE)_beginthreadex(NULL, 0, fn, arg, 0, NULL);
+    return *thread ? 0 : -1;
+#else
+    return pthread_create(thread, NULL, fn, arg);
+#endif
+}
+
+// 等待所有线程结束并释放线程资源
+static inline void mm_thread_join_all(mm_thread_t *threads, int count) {
+#ifdef _WIN32
+    WaitForMultipleObjects(count, threads, TRUE, INFINITE);
+    for (int t = 0; t < count; t++) {
+        CloseHandle(threads[t]);
+    }
+#else
+    for (int t = 0; t < count; t++) {
+        pthread_join(threads[t], NULL);
+    }
+#endif
+}
+
+// 互斥锁：可以静态初始化（static mm_mutex_t lock = MM_MUTEX_INIT;），用于保护进程级的共享状态
+#ifdef _WIN32
+typedef SRWLOCK mm_mutex_t;
+#define MM_MUTEX_INIT SRWLOCK_INIT
+static inline void mm_mutex_lock(mm_mutex_t *mutex) { AcquireSRWLockExclusive(mutex); }
+static inline void mm_mutex_unlock(mm_mutex_t *mutex) { ReleaseSRWLockExclusive(mutex); }
+#else
+typedef pthread_mutex_t mm_mutex_t;
+#define MM_MUTEX_INIT PTHREAD_MUTEX_INITIALIZER
+static inline void mm_mutex_lock(mm_mutex_t *mutex) { pthread_mutex_lock(mutex); }
+static inline void mm_mutex_unlock(mm_mutex_t *mutex) { pthread_mutex_unlock(mutex); }
+#endif
+
+// 系统逻辑CPU核心数
+static inline int mm_cpu_count(void) {
+#ifdef _WIN32
+    SYSTEM_INFO sysinfo;
+    GetSystemInfo(&sysinfo);
+    return (int)sysinfo.dwNumberOfProcessors;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#endif
+}
+
+// ==================== 对齐内存 ====================
+
+static inline void* mm_aligned_malloc(size_t size, size_t alignment) {
+#ifdef _WIN32
+    return _aligned_malloc(size, alignment);
+#else
+    return _mm_malloc(size ? size : alignment, alignment);
+#endif
+}
+
+static inline void mm_aligned_free(void *ptr) {
+#ifdef _WIN32
+    _aligned_free(ptr);
+#else
+    _mm_free(ptr);
+#endif
+}
+
+// ==================== CPU指令集检测 ====================
+
+static inline void mm_cpuid(int leaf, int subleaf, unsigned int regs[4]) {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuidex(info, leaf, subleaf);
+    for (int i = 0; i < 4; i++) regs[i] = (unsigned int)info[i];
+#else
+    regs[0] = regs[1] = regs[2] = regs[3] = 0;
+    __get_cpuid_count(leaf, subleaf, &regs[0], &regs[1], &regs[2], &regs[3]);
+#endif
+}
+
+static inline int mm_cpu_has_avx(void) {
+    unsigned int regs[4];
+    mm_cpuid(1, 0, regs);
+    return (regs[2] & (1u << 28)) != 0;  // CPUID.1:ECX.AVX[bit 28]
+}
+
+static inline int mm_cpu_has_avx2(void) {
+    unsigned int regs[4];
+    mm_cpuid(7, 0, regs);
+    return (regs[1] & (1u << 5)) != 0;   // CPUID.7.0:EBX.AVX2[bit 5]
+}
+
+#endif // MATRIX_PLATFORM_H
@@ -0,0 +1,179 @@
+// 执行时间线追踪：记录每个线程带时间戳的事件（分块计算、打包、线程创建、等待），
+// 导出为Chrome trace / Perfetto可以直接打开的JSON（chrome://tracing 或 ui.perfetto.dev），
+// 用来查看各线程的利用率和空闲间隙：静态行划分造成的负载不均、最后一个线程多处理的剩余行、
+// 线程启动前的串行准备工作等。
+//
+//   mm_trace_start   - 清空缓冲区并开启追踪（只能在没有工作线程运行时调用）
+//   mm_trace_acquire - 被追踪的调用开始时占用缓冲区，返回调用线程的编号0；已被其他调用占用时返回-1
+//   mm_trace_release - 调用结束时释放acquire占用的缓冲区
+//   mm_trace_begin   - 开启时返回当前时间戳，关闭时返回0（事件开始时调用）
+//   mm_trace_event   - 记录一个从begin返回的时间戳到现在的完整事件（最多两个命名的整数参数）
+//   mm_trace_stop    - 关闭追踪，把所有线程的事件写入JSON文件并释放缓冲区
+//
+// 缓冲区按编号分配（0为调用线程，工作线程为1, 2, ...），每个编号只由一个线程写入，记录事件不需要加锁。
+// 同一时间只有一个调用能占用这些编号：并发调用的第二个调用者从acquire得到-1，
+// 把-1作为它和它的工作线程的编号，事件直接被忽略，不会与第一个调用争用同一个缓冲区。
+// 缓冲区在线程第一次记录时分配，写满后丢弃新事件并计数。追踪关闭时每个事件点只多一次分支判断。
+// 使用clock_gettime的文件需要在包含任何头文件之前定义 _POSIX_C_SOURCE。
+#ifndef MATRIX_TRACE_H
+#define MATRIX_TRACE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "matrix_platform.h"
+
+#define MM_TRACE_MAX_THREADS 65          // 调用线程 + 最多64个工作线程
+#define MM_TRACE_CAPACITY    (1 << 16)   // 每个线程最多记录的事件数
+
+typedef struct {
+    const char *name;   // 事件名（字符串常量）
+    double start_us;    // 相对追踪开始时间的微秒数
+    double dur_us;
+    const char *arg0_name, *arg1_name;   // 事件参数名，NULL表示没有该参数
+    int arg0, arg1;
+} MMTraceEvent;
+
+typedef struct {
+    MMTraceEvent *events;
+    int count;
+    int dropped;
+} MMTraceBuffer;
+
+static int mm_trace_enabled = 0;
+static int mm_trace_busy = 0;   // 是否有调用正在占用缓冲区
+static mm_mutex_t mm_trace_lock = MM_MUTEX_INIT;
+static double mm_trace_epoch = 0.0;
+static MMTraceBuffer mm_trace_buffers[MM_TRACE_MAX_THREADS];
+
+// 单调时钟（微秒）
+static inline double mm_trace_clock(void) {
+#ifdef _WIN32
+    LARGE_INTEGER freq, counter;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart * 1e6 / freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec * 1e-3;
+#endif
+}
+
+static inline int mm_trace_acquire(void) {
+    if (!mm_trace_enabled) {
+        return -1;
+    }
+    mm_mutex_lock(&mm_trace_lock);
+    int tid = mm_trace_busy ? -1 : 0;
+    mm_trace_busy = 1;
+    mm_mutex_unlock(&mm_trace_lock);
+    return tid;
+}
+
+// tid为acquire的返回值，只有占用成功(0)时才释放
+static inline void mm_trace_release(int tid) {
+    if (tid != 0) {
+        return;
+    }
+    mm_mutex_lock(&mm_trace_lock);
+    mm_trace_busy = 0;
+    mm_mutex_unlock(&mm_trace_lock);
+}
+
+static inline double mm_trace_begin(void) {
+    return mm_trace_enabled ? mm_trace_clock() : 0.0;
+}
+
+static inline void mm_trace_event(int tid, const char *name, double begin,
+                                  const char *arg0_name, int arg0, const char *arg1_name, int arg1) {
+    if (!mm_trace_enabled || tid < 0 || tid >= MM_TRACE_MAX_THREADS) {
+        return;
+    }
+    double now = mm_trace_clock();
+    MMTraceBuffer *buffer = &mm_trace_buffers[tid];
+    if (buffer->events == NULL) {
+        buffer->events = (MMTraceEvent*)malloc(MM_TRACE_CAPACITY * sizeof(MMTraceEvent));
+        if (buffer->events == NULL) {
+            buffer->dropped++;
+            return;
+        }
+    }
+    if (buffer->count >= MM_TRACE_CAPACITY) {
+        buffer->dropped++;
+        return;
+    }
+    MMTraceEvent *event = &buffer->events[buffer->count++];
+    event->name = name;
+    event->start_us = begin - mm_trace_epoch;
+    event->dur_us = now - begin;
+    event->arg0_name = arg0_name;
+    event->arg1_name = arg1_name;
+    event->arg0 = arg0;
+    event->arg1 = arg1;
+}
+
+static inline void mm_trace_start(void) {
+    for (int t = 0; t < MM_TRACE_MAX_THREADS; t++) {
+        mm_trace_buffers[t].count = 0;
+        mm_trace_buffers[t].dropped = 0;
+    }
+    mm_trace_epoch = mm_trace_clock();
+    mm_trace_enabled = 1;
+}
+
+// 释放所有线程的事件缓冲区（下次开启追踪后重新分配）
+static inline void mm_trace_free_buffers(void) {
+    for (int t = 0; t < MM_TRACE_MAX_THREADS; t++) {
+        free(mm_trace_buffers[t].events);
+        mm_trace_buffers[t].events = NULL;
+        mm_trace_buffers[t].count = 0;
+        mm_trace_buffers[t].dropped = 0;
+    }
+}
+
+// 关闭追踪并写出JSON，然后释放缓冲区；path为NULL时只关闭。返回写出的事件数，文件无法打开时返回-1
+static inline int mm_trace_stop(const char *path) {
+    mm_trace_enabled = 0;
+    FILE *f = (path != NULL) ? fopen(path, "w") : NULL;
+    if (f == NULL) {
+        mm_trace_free_buffers();
+        return path == NULL ? 0 : -1;
+    }
+
+    int written = 0;
+    int dropped = 0;
+    fprintf(f, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    for (int t = 0; t < MM_TRACE_MAX_THREADS; t++) {
+        MMTraceBuffer *buffer = &mm_trace_buffers[t];
+        if (buffer->count == 0 && buffer->dropped == 0) {
+            continue;
+        }
+        // 线程名元数据：Perfetto按它标注每一行
+        fprintf(f, "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, "
+                   "\"args\": {\"name\": \"%s %d\"}}",
+                written > 0 ? ",\n" : "", t, t == 0 ? "caller" : "worker", t);
+        written++;
+        for (int e = 0; e < buffer->count; e++) {
+            MMTraceEvent *event = &buffer->events[e];
+            fprintf(f, ",\n{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f",
+                    event->name, t, event->start_us, event->dur_us);
+            if (event->arg0_name != NULL) {
+                fprintf(f, ", \"args\": {\"%s\": %d", event->arg0_name, event->arg0);
+                if (event->arg1_name != NULL) {
+                    fprintf(f, ", \"%s\": %d", event->arg1_name, event->arg1);
+                }
+                fprintf(f, "}");
+            }
+            fprintf(f, "}");
+            written++;
+        }
+        dropped += buffer->dropped;
+    }
+    fprintf(f, "\n], \"otherData\": {\"dropped_events\": %d}}\n", dropped);
+    fclose(f);
+    mm_trace_free_buffers();
+    return written;
+}
+
+#endif
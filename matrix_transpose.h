@@ -0,0 +1,268 @@
+// 矩阵转置原语：按cache块分块，块内用AVX2寄存器完成8x8转置，多个线程分担不同的块。
+//
+// 朴素的双重循环转置每写一个元素就跨过目标矩阵的一整行，几乎每次写入都缺失cache；
+// 这里把矩阵切成 MM_TRANSPOSE_TILE x MM_TRANSPOSE_TILE 的块，一个块的源和目标都能放进L1/L2，
+// 块内每次读入8行x8列、在寄存器中转置后按行写出，读写都是连续的32字节。
+//
+//   mm_transpose         - 非原地：dst[j][i] = src[i][j]，src为rows x cols，dst为cols x rows
+//   mm_transpose_inplace - 原地转置N x N方阵：对角块原地转置，其余块成对交换
+//   mm_transpose_matrix  - 为mm_alloc_matrix分配的矩阵新建一个转置后的矩阵
+//
+// 矩阵用"首地址 + 行间距（元素个数）"描述，行指针数组（mm_alloc_matrix）用matrix[0]和相邻行之差即可；
+// num_threads <= 0 时自动选择线程数，较小的矩阵直接在调用线程中完成。
+#ifndef MATRIX_TRANSPOSE_H
+#define MATRIX_TRANSPOSE_H
+
+#include <stdlib.h>
+#include <string.h>
+#include "matrix_platform.h"
+#include "matrix_layout.h"
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#define MM_TRANSPOSE_TILE     64         // cache块大小：源、目标各16KB
+#define MM_TRANSPOSE_PARALLEL (1 << 16)  // 元素个数少于它时不创建线程
+
+// 8x8块：dst[c][r] = src[r][c]
+static inline void mm_transpose_8x8(const int *src, long long src_ld, int *dst, long long dst_ld) {
+#ifdef __AVX2__
+    __m256i r0 = _mm256_loadu_si256((const __m256i*)(src + 0 * src_ld));
+    __m256i r1 = _mm256_loadu_si256((const __m256i*)(src + 1 * src_ld));
+    __m256i r2 = _mm256_loadu_si256((const __m256i*)(src + 2 * src_ld));
+    __m256i r3 = _mm256_loadu_si256((const __m256i*)(src + 3 * src_ld));
+    __m256i r4 = _mm256_loadu_si256((const __m256i*)(src + 4 * src_ld));
+    __m256i r5 = _mm256_loadu_si256((const __m256i*)(src + 5 * src_ld));
+    __m256i r6 = _mm256_loadu_si256((const __m256i*)(src + 6 * src_ld));
+    __m256i r7 = _mm256_loadu_si256((const __m256i*)(src + 7 * src_ld));
+
+    // 第一步：相邻两行按32位交错
+    __m256i t0 = _mm256_unpacklo_epi32(r0, r1);
+    __m256i t1 = _mm256_unpackhi_epi32(r0, r1);
+    __m256i t2 = _mm256_unpacklo_epi32(r2, r3);
+    __m256i t3 = _mm256_unpackhi_epi32(r2, r3);
+    __m256i t4 = _mm256_unpacklo_epi32(r4, r5);
+    __m256i t5 = _mm256_unpackhi_epi32(r4, r5);
+    __m256i t6 = _mm256_unpacklo_epi32(r6, r7);
+    __m256i t7 = _mm256_unpackhi_epi32(r6, r7);
+
+    // 第二步：按64位交错，每个128位通道中得到4x4块的一列
+    r0 = _mm256_unpacklo_epi64(t0, t2);
+    r1 = _mm256_unpackhi_epi64(t0, t2);
+    r2 = _mm256_unpacklo_epi64(t1, t3);
+    r3 = _mm256_unpackhi_epi64(t1, t3);
+    r4 = _mm256_unpacklo_epi64(t4, t6);
+    r5 = _mm256_unpackhi_epi64(t4, t6);
+    r6 = _mm256_unpacklo_epi64(t5, t7);
+    r7 = _mm256_unpackhi_epi64(t5, t7);
+
+    // 第三步：交换128位通道，拼出完整的列
+    _mm256_storeu_si256((__m256i*)(dst + 0 * dst_ld), _mm256_permute2x128_si256(r0, r4, 0x20));
+    _mm256_storeu_si256((__m256i*)(dst + 1 * dst_ld), _mm256_permute2x128_si256(r1, r5, 0x20));
+    _mm256_storeu_si256((__m256i*)(dst + 2 * dst_ld), _mm256_permute2x128_si256(r2, r6, 0x20));
+    _mm256_storeu_si256((__m256i*)(dst + 3 * dst_ld), _mm256_permute2x128_si256(r3, r7, 0x20));
+    _mm256_storeu_si256((__m256i*)(dst + 4 * dst_ld), _mm256_permute2x128_si256(r0, r4, 0x31));
+    _mm256_storeu_si256((__m256i*)(dst + 5 * dst_ld), _mm256_permute2x128_si256(r1, r5, 0x31));
+    _mm256_storeu_si256((__m256i*)(dst + 6 * dst_ld), _mm256_permute2x128_si256(r2, r6, 0x31));
+    _mm256_storeu_si256((__m256i*)(dst + 7 * dst_ld), _mm256_permute2x128_si256(r3, r7, 0x31));
+#else
+    for (int r = 0; r < 8; r++) {
+        for (int c = 0; c < 8; c++) {
+            dst[c * dst_ld + r] = src[r * src_ld + c];
+        }
+    }
+#endif
+}
+
+// 转置一个rows x cols（不超过一个cache块）的子矩阵，不足8的边缘逐个元素处理
+static inline void mm_transpose_tile(int rows, int cols, const int *src, long long src_ld,
+                                     int *dst, long long dst_ld) {
+    int rows8 = rows / 8 * 8;
+    int cols8 = cols / 8 * 8;
+
+    for (int i = 0; i < rows8; i += 8) {
+        for (int j = 0; j < cols8; j += 8) {
+            mm_transpose_8x8(src + i * src_ld + j, src_ld, dst + j * dst_ld + i, dst_ld);
+        }
+        for (int j = cols8; j < cols; j++) {
+            for (int r = i; r < i + 8; r++) {
+                dst[j * dst_ld + r] = src[r * src_ld + j];
+            }
+        }
+    }
+    for (int i = rows8; i < rows; i++) {
+        for (int j = 0; j < cols; j++) {
+            dst[j * dst_ld + i] = src[i * src_ld + j];
+        }
+    }
+}
+
+// 原地转置方阵中的一个对角8x8块
+static inline void mm_transpose_8x8_inplace(int *block, long long ld) {
+#ifdef __AVX2__
+    // 8行全部读入寄存器之后才开始写出，可以直接写回原位置
+    mm_transpose_8x8(block, ld, block, ld);
+#else
+    for (int r = 0; r < 8; r++) {
+        for (int c = r + 1; c < 8; c++) {
+            int t = block[r * ld + c];
+            block[r * ld + c] = block[c * ld + r];
+            block[c * ld + r] = t;
+        }
+    }
+#endif
+}
+
+// 交换并转置两个8x8块：a = b^T, b = a^T
+static inline void mm_transpose_swap_8x8(int *a, int *b, long long ld) {
+    int ta[64];
+    mm_transpose_8x8(a, ld, ta, 8);
+    mm_transpose_8x8(b, ld, a, ld);
+    for (int r = 0; r < 8; r++) {
+        memcpy(b + r * ld, ta + r * 8, 8 * sizeof(int));
+    }
+}
+
+// 原地处理方阵中的块对：(ti, tj)与(tj, ti)交换并转置；ti == tj 时原地转置对角块
+static inline void mm_transpose_tile_pair(int N, int *data, long long ld, int ti, int tj) {
+    int i_end = (ti + MM_TRANSPOSE_TILE < N) ? ti + MM_TRANSPOSE_TILE : N;
+    int j_end = (tj + MM_TRANSPOSE_TILE < N) ? tj + MM_TRANSPOSE_TILE : N;
+
+    for (int i = ti; i < i_end; i += 8) {
+        // 对角块只处理上三角部分的8x8块
+        int j_start = (ti == tj) ? i : tj;
+        for (int j = j_start; j < j_end; j += 8) {
+            int *a = data + i * ld + j;
+            int *b = data + j * ld + i;
+            if (i + 8 <= i_end && j + 8 <= j_end) {
+                if (i == j) {
+                    mm_transpose_8x8_inplace(a, ld);
+                } else {
+                    mm_transpose_swap_8x8(a, b, ld);
+                }
+                continue;
+            }
+            // 边缘不足8x8：逐个元素交换上三角与下三角
+            int ie = (i + 8 < i_end) ? i + 8 : i_end;
+            int je = (j + 8 < j_end) ? j + 8 : j_end;
+            for (int r = i; r < ie; r++) {
+                for (int c = (i == j) ? r + 1 : j; c < je; c++) {
+                    int t = data[r * ld + c];
+                    data[r * ld + c] = data[c * ld + r];
+                    data[c * ld + r] = t;
+                }
+            }
+        }
+    }
+}
+
+// 转置线程参数结构体
+typedef struct {
+    int rows;
+    int cols;
+    const int *src;
+    long long src_ld;
+    int *dst;
+    long long dst_ld;
+    int inplace;
+    int thread_id;
+    int num_threads;
+} MMTransposeParams;
+
+// 按块行分配：非原地时每个线程负责连续的一段块行；
+// 原地时第ti个块行包含的块对数量随ti递减，按 ti = thread_id, thread_id + num_threads, ... 轮流分配
+static MM_THREAD_FUNC mm_transpose_thread(void *arg) {
+    MMTransposeParams *params = (MMTransposeParams*)arg;
+    int tiles = (params->rows + MM_TRANSPOSE_TILE - 1) / MM_TRANSPOSE_TILE;
+
+    if (params->inplace) {
+        for (int t = params->thread_id; t < tiles; t += params->num_threads) {
+            int ti = t * MM_TRANSPOSE_TILE;
+            for (int tj = ti; tj < params->rows; tj += MM_TRANSPOSE_TILE) {
+                mm_transpose_tile_pair(params->rows, params->dst, params->dst_ld, ti, tj);
+            }
+        }
+        return MM_THREAD_RETURN;
+    }
+
+    int per_thread = tiles / params->num_threads;
+    int remaining = tiles % params->num_threads;
+    int t_start = params->thread_id * per_thread;
+    int t_end = t_start + per_thread + (params->thread_id == params->num_threads - 1 ? remaining : 0);
+
+    for (int t = t_start; t < t_end; t++) {
+        int i = t * MM_TRANSPOSE_TILE;
+        int h = (params->rows - i < MM_TRANSPOSE_TILE) ? params->rows - i : MM_TRANSPOSE_TILE;
+        for (int j = 0; j < params->cols; j += MM_TRANSPOSE_TILE) {
+            int w = (params->cols - j < MM_TRANSPOSE_TILE) ? params->cols - j : MM_TRANSPOSE_TILE;
+            mm_transpose_tile(h, w, params->src + i * params->src_ld + j, params->src_ld,
+                              params->dst + j * params->dst_ld + i, params->dst_ld);
+        }
+    }
+    return MM_THREAD_RETURN;
+}
+
+static inline void mm_transpose_run(MMTransposeParams *base, int num_threads) {
+    int tiles = (base->rows + MM_TRANSPOSE_TILE - 1) / MM_TRANSPOSE_TILE;
+
+    if (num_threads <= 0) {
+        // 获取系统CPU核心数
+        num_threads = mm_cpu_count();
+        if (num_threads > 8) num_threads = 8; // 限制线程数
+        if ((long long)base->rows * base->cols < MM_TRANSPOSE_PARALLEL) num_threads = 1;
+    }
+    if (num_threads > tiles) num_threads = tiles;
+    if (num_threads < 1) num_threads = 1;
+
+    if (num_threads == 1) {
+        base->thread_id = 0;
+        base->num_threads = 1;
+        mm_transpose_thread(base);
+        return;
+    }
+
+    mm_thread_t* threads = (mm_thread_t*)malloc(num_threads * sizeof(mm_thread_t));
+    MMTransposeParams* params = (MMTransposeParams*)malloc(num_threads * sizeof(MMTransposeParams));
+    for (int t = 0; t < num_threads; t++) {
+        params[t] = *base;
+        params[t].thread_id = t;
+        params[t].num_threads = num_threads;
+        mm_thread_create(&threads[t], mm_transpose_thread, &params[t]);
+    }
+    mm_thread_join_all(threads, num_threads);
+    free(threads);
+    free(params);
+}
+
+// 非原地转置：dst（cols x rows，行间距dst_ld）= src（rows x cols，行间距src_ld）的转置
+static inline void mm_transpose(int rows, int cols, const int *src, long long src_ld,
+                                int *dst, long long dst_ld, int num_threads) {
+    if (rows <= 0 || cols <= 0) {
+        return;
+    }
+    MMTransposeParams base = {rows, cols, src, src_ld, dst, dst_ld, 0, 0, 1};
+    mm_transpose_run(&base, num_threads);
+}
+
+// 原地转置N x N方阵（行间距ld）
+static inline void mm_transpose_inplace(int N, int *data, long long ld, int num_threads) {
+    if (N <= 1) {
+        return;
+    }
+    MMTransposeParams base = {N, N, data, ld, data, ld, 1, 0, 1};
+    mm_transpose_run(&base, num_threads);
+}
+
+// 行指针数组（mm_alloc_matrix分配）的行间距
+static inline long long mm_matrix_ld(int **matrix, int rows) {
+    return rows > 1 ? (long long)(matrix[1] - matrix[0]) : 0;
+}
+
+// 新建src（rows x cols，由mm_alloc_matrix分配）的转置矩阵（cols x rows），用mm_free_matrix释放
+static inline int** mm_transpose_matrix(int rows, int cols, int **src, int num_threads) {
+    int **dst = mm_alloc_matrix(cols, rows);
+    mm_transpose(rows, cols, src[0], mm_matrix_ld(src, rows), dst[0], mm_matrix_ld(dst, cols), num_threads);
+    return dst;
+}
+
+#endif // MATRIX_TRANSPOSE_H
@@ -0,0 +1,198 @@
+// 结果校验（Freivalds算法）：用O(N²)的代价检查C是否等于A*B，不需要完整的参考乘积。
+//
+// 随机取向量r，比较 A(Br) 与 Cr：若C = A*B两者必然相等；若C ≠ A*B，一次随机向量检测不出的概率不超过1/2
+// （int32按2^32取模运算，最坏情况是误差恰好为2^31的倍数；SIMD尾部、线程竞争等实际错误产生的误差
+// 通常是任意值，漏检概率约为2^-32）。重复reps次（每次独立的随机向量）漏检概率不超过2^-reps，
+// mm_verify_reps 根据目标漏检率给出重复次数。
+//
+//   mm_verify_reps      - 达到目标漏检率需要的重复次数
+//   mm_verify_freivalds - 检查 C（M x N）== A（M x K）* B（K x N），通过返回1，发现不一致返回0
+//
+// 所有重复共用两遍扫描：第一遍同时计算 Y = B*R 和 W = C*R，第二遍计算 Z = A*Y，
+// 每个矩阵只读一次，每行在L1中与reps个随机向量做AVX2点积；各遍按行分给多个线程。
+// 运算按无符号32位进行，与int32矩阵乘法溢出时的回绕结果一致。
+#ifndef MATRIX_VERIFY_H
+#define MATRIX_VERIFY_H
+
+#include <stdlib.h>
+#include <time.h>
+#include "matrix_platform.h"
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#define MM_VERIFY_MAX_REPS 64          // 漏检率不超过2^-64
+#define MM_VERIFY_PARALLEL (1 << 18)   // 三个矩阵的元素总数少于它时不创建线程
+
+// 达到目标漏检率target（0 < target < 1）需要的重复次数：每次漏检概率不超过1/2
+static inline int mm_verify_reps(double target) {
+    int reps = 1;
+    double p = 0.5;
+    while (p > target && reps < MM_VERIFY_MAX_REPS) {
+        p *= 0.5;
+        reps++;
+    }
+    return reps;
+}
+
+// 行与随机向量的点积（按2^32取模）
+static inline unsigned mm_verify_dot(const int *row, const unsigned *v, int n) {
+    int j = 0;
+    unsigned sum = 0;
+#ifdef __AVX2__
+    __m256i acc0 = _mm256_setzero_si256();
+    __m256i acc1 = _mm256_setzero_si256();
+    for (; j + 16 <= n; j += 16) {
+        acc0 = _mm256_add_epi32(acc0, _mm256_mullo_epi32(_mm256_loadu_si256((const __m256i*)&row[j]),
+                                                         _mm256_loadu_si256((const __m256i*)&v[j])));
+        acc1 = _mm256_add_epi32(acc1, _mm256_mullo_epi32(_mm256_loadu_si256((const __m256i*)&row[j + 8]),
+                                                         _mm256_loadu_si256((const __m256i*)&v[j + 8])));
+    }
+    if (j + 8 <= n) {
+        acc0 = _mm256_add_epi32(acc0, _mm256_mullo_epi32(_mm256_loadu_si256((const __m256i*)&row[j]),
+                                                         _mm256_loadu_si256((const __m256i*)&v[j])));
+        j += 8;
+    }
+    acc0 = _mm256_add_epi32(acc0, acc1);
+    __m128i s = _mm_add_epi32(_mm256_castsi256_si128(acc0), _mm256_extracti128_si256(acc0, 1));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1));
+    sum = (unsigned)_mm_cvtsi128_si32(s);
+#endif
+    for (; j < n; j++) {
+        sum += (unsigned)row[j] * v[j];
+    }
+    return sum;
+}
+
+// 一个矩阵的若干行与reps个向量相乘：out[r * rows + i] = mat[i] · vecs[r]
+typedef struct {
+    const int *mat;
+    long long ld;
+    int rows;                // 矩阵行数（out中每个向量的长度）
+    int n;                   // 矩阵列数（随机向量的长度）
+    const unsigned *vecs;    // reps个长度为n的向量
+    unsigned *out;
+} MMVerifyJob;
+
+// 校验线程参数：每遍最多两个矩阵（第一遍为B和C），每个线程处理各矩阵中自己的一段行
+typedef struct {
+    MMVerifyJob jobs[2];
+    int job_count;
+    int reps;
+    int thread_id;
+    int num_threads;
+} MMVerifyParams;
+
+static MM_THREAD_FUNC mm_verify_thread(void *arg) {
+    MMVerifyParams *params = (MMVerifyParams*)arg;
+
+    for (int jb = 0; jb < params->job_count; jb++) {
+        const MMVerifyJob *job = &params->jobs[jb];
+        int per_thread = job->rows / params->num_threads;
+        int remaining = job->rows % params->num_threads;
+        int start_row = params->thread_id * per_thread;
+        int end_row = start_row + per_thread + (params->thread_id == params->num_threads - 1 ? remaining : 0);
+
+        for (int i = start_row; i < end_row; i++) {
+            const int *row = job->mat + i * job->ld;
+            for (int r = 0; r < params->reps; r++) {
+                job->out[(long long)r * job->rows + i] = mm_verify_dot(row, job->vecs + (long long)r * job->n, job->n);
+            }
+        }
+    }
+    return MM_THREAD_RETURN;
+}
+
+static inline void mm_verify_run(MMVerifyParams *base, int num_threads) {
+    if (num_threads == 1) {
+        base->thread_id = 0;
+        base->num_threads = 1;
+        mm_verify_thread(base);
+        return;
+    }
+
+    mm_thread_t* threads = (mm_thread_t*)malloc(num_threads * sizeof(mm_thread_t));
+    MMVerifyParams* params = (MMVerifyParams*)malloc(num_threads * sizeof(MMVerifyParams));
+    for (int t = 0; t < num_threads; t++) {
+        params[t] = *base;
+        params[t].thread_id = t;
+        params[t].num_threads = num_threads;
+        mm_thread_create(&threads[t], mm_verify_thread, &params[t]);
+    }
+    mm_thread_join_all(threads, num_threads);
+    free(threads);
+    free(params);
+}
+
+// 检查 C（M x N，行间距ldc）== A（M x K，行间距lda）* B（K x N，行间距ldb）。
+// reps为随机向量个数（<= 0 时为1，最多MM_VERIFY_MAX_REPS），seed为0时每次调用取不同的随机种子，
+// num_threads <= 0 时自动选择线程数。通过返回1，发现不一致返回0
+static inline int mm_verify_freivalds(int M, int N, int K, const int *A, long long lda,
+                                      const int *B, long long ldb, const int *C, long long ldc,
+                                      int reps, unsigned long long seed, int num_threads) {
+    static unsigned long long mm_verify_counter = 0;
+
+    if (M <= 0 || N <= 0) {
+        return 1;
+    }
+    if (reps <= 0) reps = 1;
+    if (reps > MM_VERIFY_MAX_REPS) reps = MM_VERIFY_MAX_REPS;
+
+    if (num_threads <= 0) {
+        num_threads = mm_cpu_count();
+        if (num_threads > 8) num_threads = 8; // 限制线程数
+        if ((long long)M * N + (long long)M * K + (long long)K * N < MM_VERIFY_PARALLEL) num_threads = 1;
+    }
+    if (num_threads > M) num_threads = M;
+    if (num_threads < 1) num_threads = 1;
+
+    unsigned *R = (unsigned*)malloc((size_t)reps * N * sizeof(unsigned));
+    unsigned *Y = (unsigned*)malloc((size_t)reps * (K > 0 ? K : 1) * sizeof(unsigned));
+    unsigned *W = (unsigned*)malloc((size_t)reps * M * sizeof(unsigned));
+    unsigned *Z = (unsigned*)malloc((size_t)reps * M * sizeof(unsigned));
+
+    // splitmix64生成随机向量
+    if (seed == 0) {
+        seed = (unsigned long long)time(NULL) ^ ((unsigned long long)(size_t)C << 16) ^ (++mm_verify_counter * 0x9E3779B97F4A7C15ULL);
+    }
+    for (long long idx = 0; idx < (long long)reps * N; idx++) {
+        unsigned long long z = (seed += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        R[idx] = (unsigned)(z ^ (z >> 31));
+    }
+
+    // 第一遍：Y = B*R，W = C*R
+    MMVerifyParams base;
+    base.jobs[0] = (MMVerifyJob){B, ldb, K, N, R, Y};
+    base.jobs[1] = (MMVerifyJob){C, ldc, M, N, R, W};
+    base.job_count = 2;
+    base.reps = reps;
+    mm_verify_run(&base, num_threads);
+
+    // 第二遍：Z = A*Y
+    if (K > 0) {
+        base.jobs[0] = (MMVerifyJob){A, lda, M, K, Y, Z};
+        base.job_count = 1;
+        mm_verify_run(&base, num_threads);
+    } else {
+        for (long long idx = 0; idx < (long long)reps * M; idx++) Z[idx] = 0;
+    }
+
+    int ok = 1;
+    for (long long idx = 0; idx < (long long)reps * M; idx++) {
+        if (Z[idx] != W[idx]) {
+            ok = 0;
+            break;
+        }
+    }
+
+    free(R);
+    free(Y);
+    free(W);
+    free(Z);
+    return ok;
+}
+
+#endif // MATRIX_VERIFY_H
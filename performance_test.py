@@ -5,6 +5,7 @@
 统一测试所有优化版本的性能，并进行对比分析
 """
 
+import glob
 import os
 import sys
 import time
@@ -13,7 +14,7 @@ import numpy as np
 import subprocess
 import matplotlib.pyplot as plt
 import pandas as pd
-from ctypes import c_int, c_void_p, POINTER, Structure
+from ctypes import c_int, c_longlong, c_void_p, POINTER, Structure
 
 # 设置matplotlib字体
 import platform
@@ -26,6 +27,136 @@ else:
     plt.rcParams['font.family'] = 'DejaVu Sans'
 plt.rcParams['axes.unicode_minus'] = False
 
+# 动态链接库后缀：Windows下为.dll，Linux等系统下为.so
+LIB_EXT = 'dll' if platform.system() == 'Windows' else 'so'
+LINK_LIBS = [] if platform.system() == 'Windows' else ['-lpthread', '-lm']
+
+# 各C语言版本对应的矩阵乘法函数
+C_KERNELS = {
+    'basic': 'matrixmultiply_basic',
+    'multithread': 'matrixmultiply_multithread',
+    'blocked': 'matrixmultiply_blocked_adaptive',
+    'simd': 'matrixmultiply_simd',
+    'optimized': 'matrixmultiply_ultimate',
+    'auto': 'matrixmultiply_auto'
+}
+
+# 构建变体相对普通构建的提升超过该比例时，认为值得部署
+DEPLOY_GAIN_THRESHOLD = 0.05
+
+# 行间距填充扫描：在2的幂附近（N-1、N、N+1）比较的版本，以及默认的2的幂大小
+PADDING_SWEEP_KERNELS = {
+    'basic': ('basic', 'matrixmultiply_basic'),
+    'transpose': ('optimized', 'matrixmultiply_transpose'),
+    'blocked': ('blocked', 'matrixmultiply_blocked')
+}
+PADDING_SWEEP_SIZES = '256,512,1024'
+
+# 写入模式检查：各库的 *_ex 接口，与matrix_layout.h中的MM_OVERWRITE / MM_ACCUMULATE / MM_STREAM一致
+WRITE_MODE_KERNELS = {
+    'basic': ['matrixmultiply_basic_ex'],
+    'blocked': ['matrixmultiply_blocked_ex', 'matrixmultiply_blocked_optimized_ex', 'matrixmultiply_blocked_adaptive_ex'],
+    'simd': ['matrixmultiply_sse_ex', 'matrixmultiply_avx2_ex', 'matrixmultiply_simd_blocked_ex'],
+    'optimized': ['matrixmultiply_unrolled_ex', 'matrixmultiply_transpose_ex', 'matrixmultiply_prefetch_ex',
+                  'matrixmultiply_ultimate_ex'],
+}
+WRITE_MODES = {'覆盖': 0, '累加': 1, '流式存储': 2, '累加+流式存储': 3}
+WRITE_MODE_SIZES = '1,7,64,67,130,256'
+
+# Roofline探针参数：带宽探针的缓冲区需远大于末级cache，计算探针每个线程的迭代次数
+ROOFLINE_BUFFER_MB = 512
+ROOFLINE_PROBE_ITERATIONS = 30000000
+ROOFLINE_DEFAULT_LLC_BYTES = 8 * 1024 ** 2   # 无法读取末级cache大小时（如Windows）使用的估计值
+
+
+def best_time(func, repeats=3):
+    """运行func多次，返回最短执行时间（秒）"""
+    best = None
+    for _ in range(repeats):
+        start_time = time.perf_counter()
+        func()
+        elapsed_time = time.perf_counter() - start_time
+        best = elapsed_time if best is None else min(best, elapsed_time)
+    return best
+
+
+def adaptive_block_size(N):
+    """与matrixmultiply_blocked_adaptive中的块大小选择规则一致"""
+    if N <= 512:
+        return 32
+    if N <= 1024:
+        return 64
+    if N <= 2048:
+        return 128
+    return 256
+
+
+def last_level_cache_bytes():
+    """末级cache大小：Linux下读取sysfs中级别最高的cache，读取失败时使用ROOFLINE_DEFAULT_LLC_BYTES"""
+    best_level, best_size = 0, 0
+    for index in glob.glob('/sys/devices/system/cpu/cpu0/cache/index*'):
+        try:
+            with open(os.path.join(index, 'level')) as f:
+                level = int(f.read())
+            with open(os.path.join(index, 'size')) as f:
+                text = f.read().strip()
+        except (OSError, ValueError):
+            continue
+        unit = {'K': 1024, 'M': 1024 ** 2, 'G': 1024 ** 3}.get(text[-1:].upper(), 1)
+        size = int(text[:-1] if unit > 1 else text) * unit
+        if (level, size) > (best_level, best_size):
+            best_level, best_size = level, size
+    return best_size or ROOFLINE_DEFAULT_LLC_BYTES
+
+
+def naive_traffic_bytes(N, llc_bytes):
+    """
+    未分块版本（basic、multithread的i-j-k循环，SIMD版本的i-k-j循环）：
+    A的一行和C的一行可以留在cache中；B能整个留在末级cache时只从内存读一次，
+    否则计算C的每一行都要把B完整读一遍
+    """
+    if 4 * N ** 2 <= llc_bytes:
+        return 4 * 3 * N ** 2
+    return 4 * (N ** 3 + 2 * N ** 2)
+
+
+def blocked_traffic_bytes(N, block_size, llc_bytes):
+    """
+    kk-ii-jj分块版本：A块在jj循环中复用，每个(kk, ii, jj)读一次B块，C块在每个kk上读写一次。
+    三个矩阵都能留在末级cache时每个只传输一次；只有B能留在cache时B只读一次，A读一次，C每个kk读写一次
+    """
+    if 4 * 3 * N ** 2 <= llc_bytes:
+        return 4 * 3 * N ** 2
+    if 4 * N ** 2 <= llc_bytes:
+        return 4 * (2 * N ** 2 + 2 * N ** 3 // block_size)
+    return 4 * (3 * N ** 3 // block_size + N ** 2)
+
+
+# Roofline中的各个版本：矩阵乘法函数、使用的线程数、数据传输量模型（参数为N和末级cache字节数）
+ROOFLINE_KERNELS = {
+    'basic': ('matrixmultiply_basic', lambda cpus, N: 1, naive_traffic_bytes),
+    'multithread': ('matrixmultiply_multithread', lambda cpus, N: min(cpus, 16, N), naive_traffic_bytes),
+    'blocked': ('matrixmultiply_blocked_adaptive', lambda cpus, N: 1,
+                lambda N, llc: blocked_traffic_bytes(N, adaptive_block_size(N), llc)),
+    'simd': ('matrixmultiply_simd', lambda cpus, N: 1, naive_traffic_bytes),
+    'optimized': ('matrixmultiply_ultimate', lambda cpus, N: min(cpus, 8, N),
+                  lambda N, llc: blocked_traffic_bytes(N, 64, llc))
+}
+
+# 自动选择入口的执行计划（与matrix_multiply_auto.c中的MMAutoPlan一致）
+AUTO_ALGO_NAMES = ['scalar', 'simd', 'packed']
+AUTO_SHAPES = [(8, 8, 8), (32, 32, 32), (64, 64, 64), (128, 128, 128), (256, 256, 256),
+               (2048, 16, 2048), (4, 4096, 64), (512, 512, 2048)]
+
+# Freivalds结果校验的重复次数（漏检率分别不超过2^-1、2^-10、2^-20），以及注入错误的检测试验次数
+VERIFY_REPS = [1, 10, 20]
+VERIFY_TRIALS = 200
+
+
+class MMAutoPlan(Structure):
+    _fields_ = [('algo', c_int), ('threads', c_int), ('kc', c_int), ('predicted_seconds', ctypes.c_double)]
+
+
 class MatrixMultiplyTester:
     def __init__(self, test_size=1024):
         """
@@ -44,7 +175,15 @@ class MatrixMultiplyTester:
             'multithread': ['-O2', '-fopenmp'],
             'blocked': ['-O2', '-march=native'],
             'simd': ['-O2', '-march=native', '-mavx2'],
-            'optimized': ['-O2', '-march=native', '-mavx2', '-fopenmp']
+            'optimized': ['-O2', '-march=native', '-mavx2', '-fopenmp'],
+            'strided': ['-O2', '-march=native', '-mavx2', '-mfma'],
+            'roofline': ['-O2', '-march=native', '-mavx2', '-mfma'],
+            'conv': ['-O2', '-march=native', '-mavx2'],
+            'modp': ['-O2', '-march=native', '-mavx2'],
+            'bitpacked': ['-O2', '-march=native', '-mavx2', '-mpopcnt'],
+            'semiring': ['-O2', '-march=native', '-mavx2'],
+            'half': ['-O2', '-march=native', '-mavx2', '-mfma', '-mf16c'],
+            'auto': ['-O2', '-march=native', '-mavx2', '-mfma']
         }
         
         print(f"初始化矩阵乘法性能测试器")
@@ -60,7 +199,15 @@ class MatrixMultiplyTester:
             'multithread': 'matrix_multiply_multithread.c', 
             'blocked': 'matrix_multiply_blocked.c',
             'simd': 'matrix_multiply_simd.c',
-            'optimized': 'matrix_multiply_optimized.c'
+            'optimized': 'matrix_multiply_optimized.c',
+            'strided': 'matrix_multiply_strided.c',
+            'roofline': 'matrix_multiply_roofline.c',
+            'conv': 'matrix_multiply_conv.c',
+            'modp': 'matrix_multiply_modp.c',
+            'bitpacked': 'matrix_multiply_bitpacked.c',
+            'semiring': 'matrix_multiply_semiring.c',
+            'half': 'matrix_multiply_half.c',
+            'auto': 'matrix_multiply_auto.c'
         }
         
         for name, c_file in c_files.items():
@@ -68,10 +215,10 @@ class MatrixMultiplyTester:
                 print(f"警告: {c_file} 不存在，跳过编译")
                 continue
                 
-            dll_name = f"matrix_{name}.dll"
+            dll_name = f"matrix_{name}.{LIB_EXT}"
             compile_cmd = [
                 'gcc', '-shared', '-fPIC', c_file, '-o', dll_name
-            ] + self.compile_flags.get(name, ['-O2'])
+            ] + self.compile_flags.get(name, ['-O2']) + LINK_LIBS
             
             print(f"编译 {name}: {' '.join(compile_cmd)}")
             
@@ -87,6 +234,16 @@ class MatrixMultiplyTester:
             except Exception as e:
                 print(f"✗ {name} 编译异常: {e}")
     
+    def load_libraries(self, lib_dir, names=None):
+        """从指定目录加载已编译好的库（不重新编译），用于构建变体的训练和对比"""
+        for name in (names or C_KERNELS):
+            path = os.path.abspath(os.path.join(lib_dir, f"matrix_{name}.{LIB_EXT}"))
+            if not os.path.exists(path):
+                print(f"警告: {path} 不存在，跳过")
+                continue
+            self.dlls[name] = ctypes.CDLL(path)
+            self._setup_function_signatures(name)
+    
     def _setup_function_signatures(self, name):
         """设置函数签名"""
         if name not in self.dlls:
@@ -95,16 +252,8 @@ class MatrixMultiplyTester:
         dll = self.dlls[name]
         
         # 设置矩阵乘法函数签名
-        func_names = {
-            'basic': 'matrixmultiply_basic',
-            'multithread': 'matrixmultiply_multithread',
-            'blocked': 'matrixmultiply_blocked_adaptive',
-            'simd': 'matrixmultiply_simd',
-            'optimized': 'matrixmultiply_ultimate'
-        }
-        
-        if name in func_names:
-            func = getattr(dll, func_names[name])
+        if name in C_KERNELS:
+            func = getattr(dll, C_KERNELS[name])
             func.argtypes = [c_int, POINTER(POINTER(c_int)), 
                            POINTER(POINTER(c_int)), POINTER(POINTER(c_int))]
             func.restype = None
@@ -118,6 +267,120 @@ class MatrixMultiplyTester:
             dll.free_matrix.argtypes = [POINTER(POINTER(c_int)), c_int]
             dll.free_matrix.restype = None
             
+        # 行间距填充开关
+        if hasattr(dll, 'matrix_set_padding'):
+            dll.matrix_set_padding.argtypes = [c_int]
+            dll.matrix_set_padding.restype = None
+            dll.matrix_leading_dim.argtypes = [POINTER(POINTER(c_int)), c_int]
+            dll.matrix_leading_dim.restype = c_int
+            for func_name in ('matrixmultiply_transpose', 'matrixmultiply_blocked'):
+                if hasattr(dll, func_name):
+                    getattr(dll, func_name).argtypes = [c_int, POINTER(POINTER(c_int)),
+                                                        POINTER(POINTER(c_int)), POINTER(POINTER(c_int))]
+                    getattr(dll, func_name).restype = None
+            
+        # 预打包操作数接口（仅综合优化版本提供）
+        if hasattr(dll, 'matrix_pack_B'):
+            dll.matrix_pack_B.argtypes = [c_int, POINTER(POINTER(c_int)), c_int]
+            dll.matrix_pack_B.restype = c_void_p
+            dll.matrixmultiply_ultimate_packed.argtypes = [c_int, POINTER(POINTER(c_int)), c_void_p,
+                                                           POINTER(POINTER(c_int)), c_int]
+            dll.matrixmultiply_ultimate_packed.restype = c_int
+            dll.matrix_packed_free.argtypes = [c_void_p]
+            dll.matrix_packed_free.restype = None
+            
+        # Roofline微基准探针
+        if hasattr(dll, 'roofline_probe_int32'):
+            dll.roofline_default_threads.argtypes = []
+            dll.roofline_default_threads.restype = c_int
+            dll.roofline_probe_int32.argtypes = [c_int, c_longlong]
+            dll.roofline_probe_int32.restype = c_longlong
+            dll.roofline_probe_float32.argtypes = [c_int, c_longlong]
+            dll.roofline_probe_float32.restype = c_longlong
+            dll.roofline_buffer_alloc.argtypes = [c_longlong]
+            dll.roofline_buffer_alloc.restype = c_void_p
+            dll.roofline_buffer_free.argtypes = [c_void_p]
+            dll.roofline_buffer_free.restype = None
+            dll.roofline_probe_bandwidth.argtypes = [c_int, c_void_p, c_longlong, c_int]
+            dll.roofline_probe_bandwidth.restype = c_longlong
+            
+        # 位压缩0/1矩阵
+        if hasattr(dll, 'bitmatrix_multiply'):
+            dll.bitmatrix_from_int.argtypes = [c_int, c_int, POINTER(POINTER(c_int))]
+            dll.bitmatrix_from_int.restype = c_void_p
+            dll.bitmatrix_create.argtypes = [c_int, c_int]
+            dll.bitmatrix_create.restype = c_void_p
+            dll.bitmatrix_free.argtypes = [c_void_p]
+            dll.bitmatrix_free.restype = None
+            dll.bitmatrix_multiply.argtypes = [c_void_p, c_void_p, c_void_p, c_int, c_int]
+            dll.bitmatrix_multiply.restype = c_int
+            dll.bitmatrix_compare_int.argtypes = [c_void_p, POINTER(POINTER(c_int)), c_int]
+            dll.bitmatrix_compare_int.restype = c_int
+            dll.init_binary_matrix.argtypes = [c_int, POINTER(POINTER(c_int)), c_int, ctypes.c_uint]
+            dll.init_binary_matrix.restype = None
+            
+        # 半环矩阵乘法与全源最短路径
+        if hasattr(dll, 'matrixmultiply_semiring'):
+            for func_name in ('matrixmultiply_semiring', 'matrixmultiply_semiring_naive',
+                              'apsp_repeated_squaring', 'apsp_floyd_warshall'):
+                getattr(dll, func_name).argtypes = [c_int, POINTER(POINTER(c_int)), POINTER(POINTER(c_int)),
+                                                    POINTER(POINTER(c_int)), c_int]
+                getattr(dll, func_name).restype = c_int
+            dll.apsp_repeated_squaring.argtypes = [c_int, POINTER(POINTER(c_int)), POINTER(POINTER(c_int)), c_int]
+            dll.apsp_floyd_warshall.argtypes = [c_int, POINTER(POINTER(c_int)), POINTER(POINTER(c_int)), c_int]
+            dll.init_graph_matrix.argtypes = [c_int, POINTER(POINTER(c_int)), c_int, c_int, c_int, ctypes.c_uint]
+            dll.init_graph_matrix.restype = None
+            
+        # 增量重新计算与低秩更新（综合优化版本）
+        if hasattr(dll, 'matrix_incremental_create'):
+            dll.matrix_incremental_create.argtypes = [c_int, POINTER(POINTER(c_int)), POINTER(POINTER(c_int)),
+                                                      POINTER(POINTER(c_int))]
+            dll.matrix_incremental_create.restype = c_void_p
+            dll.matrix_incremental_mark.argtypes = [c_void_p, c_int, c_int, c_int]
+            dll.matrix_incremental_mark.restype = None
+            dll.matrix_incremental_update.argtypes = [c_void_p]
+            dll.matrix_incremental_update.restype = c_int
+            dll.matrix_incremental_free.argtypes = [c_void_p]
+            dll.matrix_incremental_free.restype = None
+            dll.matrixmultiply_rank_update.argtypes = [c_int, c_int, POINTER(POINTER(c_int)),
+                                                       POINTER(POINTER(c_int)), POINTER(POINTER(c_int))]
+            dll.matrixmultiply_rank_update.restype = None
+            
+        # 执行时间线追踪（综合优化版本）
+        if hasattr(dll, 'matrix_trace_start'):
+            dll.matrix_trace_start.argtypes = []
+            dll.matrix_trace_start.restype = None
+            dll.matrix_trace_stop.argtypes = [ctypes.c_char_p]
+            dll.matrix_trace_stop.restype = c_int
+            
+        # Freivalds结果校验（综合优化版本）
+        if hasattr(dll, 'matrix_verify_freivalds'):
+            dll.matrix_verify_freivalds.argtypes = [c_int, POINTER(POINTER(c_int)), POINTER(POINTER(c_int)),
+                                                    POINTER(POINTER(c_int)), c_int]
+            dll.matrix_verify_freivalds.restype = c_int
+            dll.matrix_verify_reps.argtypes = [ctypes.c_double]
+            dll.matrix_verify_reps.restype = c_int
+            dll.matrixmultiply_ultimate_verified.argtypes = [c_int, POINTER(POINTER(c_int)), POINTER(POINTER(c_int)),
+                                                             POINTER(POINTER(c_int)), c_int]
+            dll.matrixmultiply_ultimate_verified.restype = c_int
+            
+        # 自动选择入口：代价模型、执行计划和按计划执行
+        if hasattr(dll, 'matrix_auto_plan'):
+            dll.matrix_auto_calibrate.argtypes = [c_int]
+            dll.matrix_auto_calibrate.restype = c_int
+            dll.matrix_auto_plan.argtypes = [c_int, c_int, c_int, c_int, POINTER(MMAutoPlan)]
+            dll.matrix_auto_plan.restype = c_int
+            dll.matrix_auto_predict.argtypes = [c_int, c_int, c_int, c_int, c_int, c_int]
+            dll.matrix_auto_predict.restype = ctypes.c_double
+            dll.matrixmultiply_auto_run.argtypes = [POINTER(MMAutoPlan), c_int, c_int, c_int, c_int,
+                                                    c_void_p, c_longlong, c_void_p, c_longlong,
+                                                    c_void_p, c_longlong, c_int]
+            dll.matrixmultiply_auto_run.restype = None
+            dll.matrixmultiply_auto_ex.argtypes = [c_int, c_int, c_int, c_int,
+                                                   c_void_p, c_longlong, c_void_p, c_longlong,
+                                                   c_void_p, c_longlong, c_int]
+            dll.matrixmultiply_auto_ex.restype = None
+            
         if hasattr(dll, 'init_test_matrices'):
             dll.init_test_matrices.argtypes = [c_int, POINTER(POINTER(c_int)), 
                                              POINTER(POINTER(c_int))]
@@ -239,6 +502,114 @@ class MatrixMultiplyTester:
         dll.free_matrix(matrixB, N)
         dll.free_matrix(matrixC, N)
     
+    def time_c_version(self, name, func_name, repeats=3):
+        """多次运行C语言版本，返回最短执行时间（秒）"""
+        dll = self.dlls[name]
+        N = self.test_size
+        matrixA, matrixB, matrixC = self.create_test_matrices_c(dll)
+        func = getattr(dll, func_name)
+        
+        elapsed_time = best_time(lambda: func(N, matrixA, matrixB, matrixC), repeats)
+        
+        dll.free_matrix(matrixA, N)
+        dll.free_matrix(matrixB, N)
+        dll.free_matrix(matrixC, N)
+        return elapsed_time
+    
+    def test_packed_version(self, repeats=3):
+        """测试预打包B版本：打包开销单独计时，乘法时间取多次调用的平均值"""
+        if 'optimized' not in self.dlls:
+            print("跳过 optimized_packed：DLL未加载")
+            return
+            
+        print("\n测试 optimized_packed 版本...")
+        
+        dll = self.dlls['optimized']
+        N = self.test_size
+        matrixA, matrixB, matrixC = self.create_test_matrices_c(dll)
+        
+        # 打包只做一次
+        start_time = time.time()
+        packedB = dll.matrix_pack_B(N, matrixB, 1)
+        pack_time = time.time() - start_time
+        
+        # 模拟B固定、A不断变化的场景，多次复用同一个打包句柄
+        start_time = time.time()
+        for _ in range(repeats):
+            dll.matrixmultiply_ultimate_packed(N, matrixA, packedB, matrixC, 0)
+        elapsed_time = (time.time() - start_time) / repeats
+        
+        # 与终极优化版本的结果比较；再用int16范围内的小矩阵（N不是64的倍数）覆盖缩窄面板和掩码尾部
+        reference = dll.create_matrix(N)
+        dll.matrixmultiply_ultimate(N, matrixA, matrixB, reference)
+        correct = bool(np.array_equal(_c_matrix_view(matrixC, N), _c_matrix_view(reference, N)))
+        dll.free_matrix(reference, N)
+        correct = correct and self._check_packed_narrow(dll)
+        
+        self.results['optimized_packed'] = {
+            'time': elapsed_time,
+            'estimated_time': elapsed_time,
+            'pack_time': pack_time,
+            'correct': correct,
+            'matrix_size': N,
+            'description': 'C语言预打包B实现（不含打包时间）'
+        }
+        
+        print(f"optimized_packed 打包时间: {pack_time:.4f} 秒")
+        print(f"optimized_packed 版本执行时间: {elapsed_time:.4f} 秒 (平均{repeats}次)，"
+              f"与终极优化版本{'一致' if correct else '不一致'}")
+        
+        dll.matrix_packed_free(packedB)
+        dll.free_matrix(matrixA, N)
+        dll.free_matrix(matrixB, N)
+        dll.free_matrix(matrixC, N)
+    
+    @staticmethod
+    def _check_packed_narrow(dll, N=100):
+        """B的元素都在int16范围内时打包为int16面板，检查预打包版本与终极优化版本的结果一致"""
+        rng = np.random.default_rng(N)
+        mats = [dll.create_matrix(N) for _ in range(4)]
+        matrixA, matrixB, reference, actual = mats
+        _c_matrix_view(matrixA, N)[:] = rng.integers(-1000, 1000, (N, N), dtype=np.int32)
+        _c_matrix_view(matrixB, N)[:] = rng.integers(-1000, 1000, (N, N), dtype=np.int32)
+        dll.matrixmultiply_ultimate(N, matrixA, matrixB, reference)
+        packedB = dll.matrix_pack_B(N, matrixB, 1)
+        status = dll.matrixmultiply_ultimate_packed(N, matrixA, packedB, actual, 0)
+        ok = status == 0 and bool(np.array_equal(_c_matrix_view(actual, N), _c_matrix_view(reference, N)))
+        dll.matrix_packed_free(packedB)
+        for m in mats:
+            dll.free_matrix(m, N)
+        return ok
+    
+    def test_numpy_binding(self):
+        """测试NumPy零拷贝绑定：NumPy数组直接传给C库，不经过create_matrix"""
+        if 'strided' not in self.dlls:
+            print("跳过 numpy_binding：DLL未加载")
+            return
+            
+        print("\n测试 numpy_binding 版本...")
+        
+        from matrix_numpy import StridedMatrixLibrary
+        lib = StridedMatrixLibrary(self.dlls['strided']._name)
+        
+        N = self.test_size
+        matrixA = np.random.randint(0, 100, (N, N), dtype=np.int32)
+        matrixB = np.random.randint(0, 100, (N, N), dtype=np.int32)
+        matrixC = np.empty((N, N), dtype=np.int32)
+        
+        start_time = time.time()
+        lib.matmul(matrixA, matrixB, out=matrixC)
+        elapsed_time = time.time() - start_time
+        
+        self.results['numpy_binding'] = {
+            'time': elapsed_time,
+            'estimated_time': elapsed_time,
+            'matrix_size': N,
+            'description': 'NumPy数组零拷贝调用C跨步接口'
+        }
+        
+        print(f"numpy_binding 版本执行时间: {elapsed_time:.4f} 秒")
+    
     def run_all_tests(self):
         """运行所有测试"""
         print("=" * 60)
@@ -253,19 +624,195 @@ class MatrixMultiplyTester:
         self.test_python_numpy()
         
         # 测试C语言版本
-        c_tests = {
-            'basic': 'matrixmultiply_basic',
-            'multithread': 'matrixmultiply_multithread',
-            'blocked': 'matrixmultiply_blocked_adaptive',
-            'simd': 'matrixmultiply_simd',
-            'optimized': 'matrixmultiply_ultimate'
-        }
-        
-        for name, func_name in c_tests.items():
+        for name, func_name in C_KERNELS.items():
             try:
                 self.test_c_version(name, func_name)
             except Exception as e:
                 print(f"测试 {name} 时出错: {e}")
+        
+        try:
+            self.test_packed_version()
+        except Exception as e:
+            print(f"测试 optimized_packed 时出错: {e}")
+        
+        try:
+            self.test_numpy_binding()
+        except Exception as e:
+            print(f"测试 numpy_binding 时出错: {e}")
+    
+    def measure_machine_roof(self, num_threads, repeats=3):
+        """
+        用Roofline探针测量num_threads个线程下的峰值运算吞吐量和内存读带宽。
+        
+        Returns:
+            dict: int32峰值(ops/s)、float32峰值(flops/s)、内存带宽(bytes/s)
+        """
+        dll = self.dlls['roofline']
+        
+        def best_rate(probe):
+            best = 0.0
+            for _ in range(repeats):
+                start_time = time.perf_counter()
+                work = probe()
+                elapsed_time = time.perf_counter() - start_time
+                best = max(best, work / elapsed_time)
+            return best
+        
+        buffer_bytes = ROOFLINE_BUFFER_MB * 1024 * 1024
+        buffer = dll.roofline_buffer_alloc(buffer_bytes)
+        if not buffer:
+            raise MemoryError(f"无法分配{ROOFLINE_BUFFER_MB}MB带宽探针缓冲区")
+        try:
+            bandwidth = best_rate(lambda: dll.roofline_probe_bandwidth(num_threads, buffer, buffer_bytes, 2))
+        finally:
+            dll.roofline_buffer_free(buffer)
+        
+        return {
+            'int32': best_rate(lambda: dll.roofline_probe_int32(num_threads, ROOFLINE_PROBE_ITERATIONS)),
+            'float32': best_rate(lambda: dll.roofline_probe_float32(num_threads, ROOFLINE_PROBE_ITERATIONS)),
+            'bandwidth': bandwidth
+        }
+    
+    def run_roofline(self, repeats=3):
+        """
+        Roofline分析：测量本机的峰值吞吐量和内存带宽，计算每个版本的算术强度
+        （运算次数 / 数据传输量）和实际达到的运算速率，生成数据、报告和图表
+        """
+        if 'roofline' not in self.dlls:
+            print("跳过Roofline分析：roofline库未加载")
+            return None
+        
+        N = self.test_size
+        cpus = self.dlls['roofline'].roofline_default_threads()
+        llc_bytes = last_level_cache_bytes()
+        thread_counts = sorted({1, cpus} | {threads(cpus, N) for _, threads, _ in ROOFLINE_KERNELS.values()})
+        
+        print("\n" + "=" * 60)
+        print("Roofline分析：测量本机峰值")
+        print("=" * 60)
+        roofs = {}
+        for threads in thread_counts:
+            roofs[threads] = self.measure_machine_roof(threads, repeats)
+            print(f"{threads:2d}线程: int32峰值 {roofs[threads]['int32'] / 1e9:8.2f} GOPS, "
+                  f"float32峰值 {roofs[threads]['float32'] / 1e9:8.2f} GFLOPS, "
+                  f"内存读带宽 {roofs[threads]['bandwidth'] / 1e9:6.2f} GB/s")
+        
+        rows = []
+        for name, (func_name, threads_of, traffic_of) in ROOFLINE_KERNELS.items():
+            if name not in self.dlls:
+                continue
+            threads = threads_of(cpus, N)
+            elapsed_time = self.time_c_version(name, func_name, repeats)
+            ops = 2 * N ** 3
+            intensity = ops / traffic_of(N, llc_bytes)
+            achieved = ops / elapsed_time
+            roof = roofs[threads]
+            memory_roof = intensity * roof['bandwidth']
+            attainable = min(roof['int32'], memory_roof)
+            # 实际速率不可能超过屋顶：超过说明数据传输量模型低估了cache复用。
+            # 仍然报告原始比例（会大于100%），并单独标记出来
+            ratio = achieved / attainable
+            above_roof = ratio > 1.0
+            if above_roof:
+                print(f"警告: {name} 实际速率 {achieved / 1e9:.3f} GOPS 超过屋顶 {attainable / 1e9:.3f} GOPS "
+                      f"({ratio * 100:.1f}%)，数据传输量模型低估了cache复用")
+            rows.append({
+                '实现版本': name,
+                '线程数': threads,
+                '执行时间(秒)': round(elapsed_time, 4),
+                '算术强度(ops/byte)': round(intensity, 3),
+                '实际速率(GOPS)': round(achieved / 1e9, 3),
+                '屋顶(GOPS)': round(attainable / 1e9, 3),
+                '达到屋顶比例': f"{ratio * 100:.1f}%",
+                '超出屋顶': '是' if above_roof else '否',
+                '瓶颈': '内存带宽' if memory_roof < roof['int32'] else '计算'
+            })
+        
+        df = pd.DataFrame(rows)
+        print("\n" + "=" * 60)
+        print(f"Roofline分析结果（矩阵大小 {N}x{N}）")
+        print("=" * 60)
+        print(df.to_string(index=False))
+        
+        os.makedirs('results', exist_ok=True)
+        csv_path = os.path.join('results', 'roofline.csv')
+        df.to_csv(csv_path, index=False, encoding='utf-8-sig')
+        
+        self._plot_roofline(df, roofs, cpus)
+        self._write_roofline_report(df, roofs, cpus, llc_bytes)
+        print(f"\nRoofline数据已保存到 {csv_path}")
+        return df
+    
+    def _plot_roofline(self, df, roofs, cpus):
+        """绘制Roofline图：屋顶线为 min(峰值, 算术强度 x 带宽)，每个版本是图中的一个点"""
+        intensity = np.logspace(-2, 3, 200)
+        fig, ax = plt.subplots(figsize=(10, 7))
+        
+        line_styles = {1: '--', cpus: '-'}
+        for threads in sorted({1, cpus}):
+            roof = roofs[threads]
+            label = f'{threads} thread' + ('s' if threads > 1 else '')
+            ax.loglog(intensity, np.minimum(roof['int32'], intensity * roof['bandwidth']) / 1e9,
+                      line_styles[threads], color='tab:blue', label=f'int32 roof ({label})')
+            ax.axhline(roof['float32'] / 1e9, linestyle=line_styles[threads], color='tab:gray',
+                       alpha=0.6, label=f'float32 FMA peak ({label})')
+        
+        for _, row in df.iterrows():
+            ax.loglog(row['算术强度(ops/byte)'], row['实际速率(GOPS)'], 'o', markersize=9)
+            ax.annotate(f"{row['实现版本']} ({row['线程数']}T)",
+                        (row['算术强度(ops/byte)'], row['实际速率(GOPS)']),
+                        textcoords='offset points', xytext=(6, 6), fontsize=10)
+        
+        ax.set_title(f'Roofline: Matrix Multiplication {self.test_size}x{self.test_size}',
+                     fontsize=14, fontweight='bold')
+        ax.set_xlabel('Arithmetic Intensity (ops/byte)', fontsize=12)
+        ax.set_ylabel('Performance (GOPS)', fontsize=12)
+        ax.grid(True, which='both', alpha=0.3)
+        ax.legend(fontsize=9, loc='lower right')
+        
+        os.makedirs('results', exist_ok=True)
+        png_path = os.path.join('results', 'roofline.png')
+        plt.savefig(png_path, dpi=300, bbox_inches='tight')
+        print(f"Roofline图已保存到 {png_path}")
+        plt.close('all')
+    
+    def _write_roofline_report(self, df, roofs, cpus, llc_bytes):
+        """生成Roofline报告"""
+        report = []
+        report.append("# 矩阵乘法Roofline分析报告\n\n")
+        report.append(f"测试时间: {time.strftime('%Y-%m-%d %H:%M:%S')}\n\n")
+        report.append(f"测试矩阵大小: {self.test_size}x{self.test_size}\n\n")
+        report.append(f"系统平台: {sys.platform}，逻辑CPU核心数: {cpus}，"
+                      f"末级cache: {llc_bytes / 1024 ** 2:.1f} MB\n\n")
+        
+        report.append("## 本机峰值\n\n")
+        report.append("| 线程数 | int32峰值(GOPS) | float32峰值(GFLOPS) | 内存读带宽(GB/s) | 屋脊点(ops/byte) |\n")
+        report.append("|---|---|---|---|---|\n")
+        for threads, roof in sorted(roofs.items()):
+            report.append(f"| {threads} | {roof['int32'] / 1e9:.2f} | {roof['float32'] / 1e9:.2f} | "
+                          f"{roof['bandwidth'] / 1e9:.2f} | {roof['int32'] / roof['bandwidth']:.2f} |\n")
+        
+        report.append("\n## 各版本位置\n\n")
+        report.append("| " + " | ".join(df.columns) + " |\n")
+        report.append("|" + "---|" * len(df.columns) + "\n")
+        for _, row in df.iterrows():
+            report.append("| " + " | ".join(str(v) for v in row) + " |\n")
+        
+        report.append("\n## 说明\n\n")
+        report.append("- 运算次数按 2 * N^3 计算（乘法和加法各一次）\n")
+        report.append("- int32峰值由 _mm256_mullo_epi32 + _mm256_add_epi32 探针测得，与SIMD版本内层循环的指令组合相同\n")
+        report.append("- 内存带宽为多线程顺序读取远大于末级cache的缓冲区测得的持续读带宽\n")
+        report.append("- 数据传输量为cache模型估计值：矩阵能整个留在末级cache中时只从内存传输一次；"
+                      "否则未分块版本计算C的每一行都要读一遍B，分块版本只有块能驻留在cache中\n")
+        report.append("- 屋顶 = min(int32峰值, 算术强度 x 内存带宽)，按各版本实际使用的线程数计算\n")
+        report.append("- 达到屋顶比例是实际速率与屋顶的原始比值，不做截断；实际速率不可能超过屋顶，"
+                      "比例大于100%时\"超出屋顶\"列标记为\"是\"，说明数据传输量模型低估了cache复用\n")
+        report.append("\n![Roofline](roofline.png)\n")
+        
+        report_path = os.path.join('results', 'roofline_report.md')
+        with open(report_path, 'w', encoding='utf-8') as f:
+            f.writelines(report)
+        print(f"Roofline报告已保存到 {report_path}")
     
     def analyze_results(self):
         """分析测试结果"""
@@ -412,6 +959,10 @@ class MatrixMultiplyTester:
                 report.append(f"### {name}\n")
                 report.append(f"- 描述: {result['description']}\n")
                 report.append(f"- 执行时间: {time_to_use:.4f} 秒\n")
+                if 'pack_time' in result:
+                    report.append(f"- 打包时间（一次性）: {result['pack_time']:.4f} 秒\n")
+                if 'correct' in result:
+                    report.append(f"- 结果与终极优化版本一致: {'是' if result['correct'] else '否'}\n")
                 report.append(f"- 加速倍数: {speedup:.2f}x\n")
                 report.append(f"- 矩阵大小: {result['matrix_size']}x{result['matrix_size']}\n\n")
         
@@ -421,7 +972,9 @@ class MatrixMultiplyTester:
         report.append("3. **分块优化版本**: 提高cache局部性，减少cache miss\n")
         report.append("4. **SIMD优化版本**: 使用AVX2/SSE指令集并行计算\n")
         report.append("5. **综合优化版本**: 结合多线程、分块、SIMD等多种优化技术\n")
-        report.append("6. **NumPy版本**: 使用高度优化的BLAS库\n\n")
+        report.append("   - **预打包版本**: B预先打包为面板布局并复用，打包开销单独统计\n")
+        report.append("6. **NumPy版本**: 使用高度优化的BLAS库\n")
+        report.append("7. **NumPy零拷贝绑定**: NumPy数组按地址和步长直接传给C库，调用期间释放GIL\n\n")
         
         report.append("## 结论\n")
         report.append("通过本次测试可以看出，不同优化技术对矩阵乘法性能的提升效果。\n")
@@ -437,20 +990,933 @@ class MatrixMultiplyTester:
         
         print(f"详细报告已保存到 {report_path}")
 
+def run_padding_sweep(base_sizes, repeats=3):
+    """
+    行间距填充扫描：在每个2的幂P附近测试 P-1、P、P+1 三个大小，
+    分别关闭和开启填充，比较每次乘加的平均耗时，显示cache组冲突带来的性能损失
+    """
+    sizes = sorted({n for p in base_sizes for n in (p - 1, p, p + 1)})
+    tester = MatrixMultiplyTester(sizes[-1])
+    tester.compile_c_libraries()
+    
+    rows = []
+    for kernel, (lib, func_name) in PADDING_SWEEP_KERNELS.items():
+        if lib not in tester.dlls:
+            print(f"跳过 {kernel}：{lib}库未加载")
+            continue
+        dll = tester.dlls[lib]
+        for padded in (0, 1):
+            dll.matrix_set_padding(padded)
+            for N in sizes:
+                tester.test_size = N
+                elapsed_time = tester.time_c_version(lib, func_name, repeats)
+                probe = dll.create_matrix(N)
+                ld = dll.matrix_leading_dim(probe, N)
+                dll.free_matrix(probe, N)
+                rows.append({
+                    '版本': kernel,
+                    '填充': '开启' if padded else '关闭',
+                    '矩阵大小': N,
+                    '行间距': ld,
+                    '执行时间(秒)': round(elapsed_time, 4),
+                    '每次乘加(ns)': elapsed_time / N ** 3 * 1e9
+                })
+                print(f"{kernel:10s} 填充{'开启' if padded else '关闭'} N={N:5d} ld={ld:5d} "
+                      f"{elapsed_time:.4f} 秒")
+        dll.matrix_set_padding(1)
+    
+    df = pd.DataFrame(rows)
+    
+    # 冲突损失：2的幂大小的每次乘加耗时相对于相邻两个大小平均值的倍数
+    penalties = []
+    for (kernel, padded), group in df.groupby(['版本', '填充'], sort=False):
+        per_op = dict(zip(group['矩阵大小'], group['每次乘加(ns)']))
+        for p in base_sizes:
+            neighbours = (per_op[p - 1] + per_op[p + 1]) / 2
+            penalties.append({'版本': kernel, '填充': padded, '2的幂大小': p,
+                              '冲突损失': round(per_op[p] / neighbours, 2)})
+    penalty_df = pd.DataFrame(penalties)
+    df['每次乘加(ns)'] = df['每次乘加(ns)'].round(3)
+    
+    print("\n" + "=" * 60)
+    print("2的幂大小的冲突损失（相对于N-1和N+1的平均每次乘加耗时）")
+    print("=" * 60)
+    print(penalty_df.to_string(index=False))
+    
+    os.makedirs('results', exist_ok=True)
+    csv_path = os.path.join('results', 'padding_sweep.csv')
+    df.to_csv(csv_path, index=False, encoding='utf-8-sig')
+    
+    # 每个版本一张子图：关闭/开启填充时每次乘加耗时随矩阵大小的变化
+    kernels = list(df['版本'].unique())
+    fig, axes = plt.subplots(1, len(kernels), figsize=(6 * len(kernels), 5), squeeze=False)
+    for ax, kernel in zip(axes[0], kernels):
+        for padded, style in (('关闭', 'o--'), ('开启', 's-')):
+            data = df[(df['版本'] == kernel) & (df['填充'] == padded)]
+            ax.plot(data['矩阵大小'], data['每次乘加(ns)'], style,
+                    label='padded' if padded == '开启' else 'unpadded')
+        ax.set_xscale('log', base=2)
+        ax.set_title(f'{kernel}: time per multiply-add', fontsize=12, fontweight='bold')
+        ax.set_xlabel('Matrix Size N', fontsize=11)
+        ax.set_ylabel('ns per multiply-add', fontsize=11)
+        ax.grid(True, alpha=0.3)
+        ax.legend()
+    plt.tight_layout()
+    png_path = os.path.join('results', 'padding_sweep.png')
+    plt.savefig(png_path, dpi=300, bbox_inches='tight')
+    plt.close('all')
+    
+    report_path = os.path.join('results', 'padding_sweep_report.md')
+    with open(report_path, 'w', encoding='utf-8') as f:
+        f.write("# 行间距填充扫描报告\n\n")
+        f.write(f"测试时间: {time.strftime('%Y-%m-%d %H:%M:%S')}\n\n")
+        f.write("冲突损失 = 2的幂大小N的每次乘加耗时 / N-1和N+1的平均每次乘加耗时，"
+                "接近1表示没有cache组冲突。\n\n")
+        for table in (penalty_df, df):
+            f.write("| " + " | ".join(table.columns) + " |\n")
+            f.write("|" + "---|" * len(table.columns) + "\n")
+            for _, row in table.iterrows():
+                f.write("| " + " | ".join(str(v) for v in row) + " |\n")
+            f.write("\n")
+        f.write("![Padding sweep](padding_sweep.png)\n")
+    
+    print(f"\n结果已保存到 {csv_path}、{report_path} 和 {png_path}")
+    return penalty_df
+
+
+def run_write_mode_check(sizes):
+    """
+    写入模式检查：每个 *_ex 接口在各个大小（含不是向量宽度倍数的N）下，
+    覆盖和流式存储的结果应为A*B，累加的结果应为C0 + A*B；关闭行间距填充时C的行不再对齐，也一并检查
+    """
+    tester = MatrixMultiplyTester(max(sizes))
+    tester.compile_c_libraries()
+    rng = np.random.default_rng(0)
+    
+    rows = []
+    for lib, func_names in WRITE_MODE_KERNELS.items():
+        if lib not in tester.dlls:
+            print(f"跳过 {lib}：DLL未加载")
+            continue
+        dll = tester.dlls[lib]
+        for func_name in func_names:
+            func = getattr(dll, func_name)
+            func.argtypes = [c_int, POINTER(POINTER(c_int)), POINTER(POINTER(c_int)), POINTER(POINTER(c_int)), c_int]
+            func.restype = None
+            for padded in (1, 0):
+                dll.matrix_set_padding(padded)
+                for N in sizes:
+                    mats = [dll.create_matrix(N) for _ in range(3)]
+                    A, B, C = (_c_matrix_view(m, N) for m in mats)
+                    A[:] = rng.integers(-100, 100, (N, N), dtype=np.int32)
+                    B[:] = rng.integers(-100, 100, (N, N), dtype=np.int32)
+                    product = (A.astype(np.int64) @ B.astype(np.int64)).astype(np.int32)
+                    failed = []
+                    for mode, flags in WRITE_MODES.items():
+                        C0 = rng.integers(-1000, 1000, (N, N), dtype=np.int32)
+                        C[:] = C0
+                        func(N, mats[0], mats[1], mats[2], flags)
+                        expected = C0 + product if flags & 1 else product
+                        if not np.array_equal(C, expected):
+                            failed.append(mode)
+                    for m in mats:
+                        dll.free_matrix(m, N)
+                    rows.append({'函数': func_name, '填充': '开启' if padded else '关闭', '矩阵大小': N,
+                                 '结果': '正确' if not failed else '错误: ' + '、'.join(failed)})
+            dll.matrix_set_padding(1)
+    
+    df = pd.DataFrame(rows)
+    errors = df[df['结果'] != '正确']
+    print(f"\n写入模式检查（{'、'.join(WRITE_MODES)}）: {len(df) - len(errors)}/{len(df)} 项正确")
+    if len(errors):
+        print(errors.to_string(index=False))
+    return df
+
+
+def run_bitpacked_benchmark(test_size, density=50, repeats=3):
+    """
+    位压缩0/1矩阵乘法与int版本的对比：int版本（AVX2和综合优化）计算整数乘积后再取非0/奇偶，
+    位压缩版本直接计算布尔半环（OR of AND）和GF(2)（XOR of AND）
+    """
+    N = test_size
+    tester = MatrixMultiplyTester(N)
+    tester.compile_c_libraries()
+    if 'bitpacked' not in tester.dlls:
+        print("跳过位压缩测试：bitpacked库未加载")
+        return None
+    bits = tester.dlls['bitpacked']
+    
+    matrixA = bits.create_matrix(N)
+    matrixB = bits.create_matrix(N)
+    matrixC = bits.create_matrix(N)
+    bits.init_binary_matrix(N, matrixA, density, 1)
+    bits.init_binary_matrix(N, matrixB, density, 2)
+    
+    rows = []
+    int_kernels = [('simd', 'matrixmultiply_avx2', 'int AVX2'),
+                   ('optimized', 'matrixmultiply_ultimate', 'int 综合优化')]
+    for lib, func_name, label in int_kernels:
+        if lib not in tester.dlls:
+            continue
+        func = getattr(tester.dlls[lib], func_name)
+        func.argtypes = [c_int, POINTER(POINTER(c_int)), POINTER(POINTER(c_int)), POINTER(POINTER(c_int))]
+        func.restype = None
+        elapsed_time = best_time(lambda: func(N, matrixA, matrixB, matrixC), repeats)
+        rows.append({'实现': label, '半环': '整数', '执行时间(秒)': elapsed_time,
+                     '操作数内存(MB)': 2 * N * N * 4 / 1048576})
+    
+    start_time = time.perf_counter()
+    A = bits.bitmatrix_from_int(N, N, matrixA)
+    B = bits.bitmatrix_from_int(N, N, matrixB)
+    convert_time = time.perf_counter() - start_time
+    C = bits.bitmatrix_create(N, N)
+    bit_bytes = 2 * N * (((N + 63) // 64 + 3) // 4 * 4) * 8
+    
+    methods = [(0, '位压缩 行组合'), (1, '位压缩 点积(popcount)'), (2, '位压缩 四俄罗斯人')]
+    for semiring, semiring_name in ((0, '布尔'), (1, 'GF(2)')):
+        for method, label in methods:
+            elapsed_time = best_time(lambda: bits.bitmatrix_multiply(A, B, C, semiring, method), repeats)
+            mismatches = bits.bitmatrix_compare_int(C, matrixC, semiring)
+            rows.append({'实现': label, '半环': semiring_name, '执行时间(秒)': elapsed_time,
+                         '操作数内存(MB)': bit_bytes / 1048576,
+                         '验证': '正确' if mismatches == 0 else f'{mismatches}处错误'})
+    
+    bits.bitmatrix_free(A)
+    bits.bitmatrix_free(B)
+    bits.bitmatrix_free(C)
+    bits.free_matrix(matrixA, N)
+    bits.free_matrix(matrixB, N)
+    bits.free_matrix(matrixC, N)
+    
+    df = pd.DataFrame(rows)
+    int_time = df[df['半环'] == '整数']['执行时间(秒)'].min()
+    df['相对int加速'] = (int_time / df['执行时间(秒)']).round(1)
+    df['执行时间(秒)'] = df['执行时间(秒)'].round(5)
+    df['操作数内存(MB)'] = df['操作数内存(MB)'].round(3)
+    
+    print("\n" + "=" * 60)
+    print(f"位压缩0/1矩阵乘法对比（矩阵大小 {N}x{N}，1的比例 {density}%，int转位压缩耗时 {convert_time:.4f} 秒）")
+    print("=" * 60)
+    print(df.to_string(index=False))
+    
+    os.makedirs('results', exist_ok=True)
+    csv_path = os.path.join('results', 'bitpacked.csv')
+    df.to_csv(csv_path, index=False, encoding='utf-8-sig')
+    print(f"\n结果已保存到 {csv_path}")
+    return df
+
+
+SEMIRING_INF = 0x3FFFFFFF              # 与matrix_multiply_semiring.c中的MM_INF一致
+SEMIRING_NAMES = {0: '(+, x)', 1: '(min, +)', 2: '(max, +)'}
+SEMIRING_CHECK_SIZES = [1, 7, 63, 65, 130]
+
+
+def _c_matrix_view(matrix, N):
+    """把create_matrix返回的行指针数组包装为N x N的NumPy视图（行间距可能大于N）"""
+    if N == 0:
+        return np.zeros((0, 0), dtype=np.int32)
+    ld = N if N == 1 else (ctypes.addressof(matrix[1].contents) - ctypes.addressof(matrix[0].contents)) // 4
+    flat = np.ctypeslib.as_array(matrix[0], shape=(N * ld,))
+    return np.lib.stride_tricks.as_strided(flat, shape=(N, N), strides=(ld * 4, 4))
+
+
+def _semiring_reference(A, B, semiring):
+    """NumPy参考实现：min-plus / max-plus 中绝对值不小于 INF / 2 的结果规范为 ±INF"""
+    A = A.astype(np.int64)
+    B = B.astype(np.int64)
+    if semiring == 0:
+        return (A @ B).astype(np.int32)
+    limit = SEMIRING_INF // 2
+    C = np.empty(A.shape, dtype=np.int64)
+    for i in range(A.shape[0]):
+        sums = A[i][:, None] + B
+        C[i] = sums.min(axis=0) if semiring == 1 else sums.max(axis=0)
+    if semiring == 1:
+        C[C >= limit] = SEMIRING_INF
+    else:
+        C[C <= -limit] = -SEMIRING_INF
+    return C.astype(np.int32)
+
+
+def run_semiring_benchmark(test_size, repeats=3):
+    """
+    半环矩阵乘法测试：先在奇数大小（面板尾部）和含负权、无穷的矩阵上与NumPy参考实现对比，
+    再比较标量三重循环与分块SIMD多线程版本，以及全源最短/最长路径的Floyd-Warshall与重复平方
+    """
+    N = test_size
+    tester = MatrixMultiplyTester(N)
+    tester.compile_c_libraries()
+    if 'semiring' not in tester.dlls:
+        print("跳过半环测试：semiring库未加载")
+        return None
+    lib = tester.dlls['semiring']
+    
+    print("\n正确性检查（含负权和无穷大）:")
+    rng = np.random.default_rng(0)
+    for n in SEMIRING_CHECK_SIZES:
+        matrices = [lib.create_matrix(n) for _ in range(3)]
+        A, B, C = (_c_matrix_view(m, n) for m in matrices)
+        results = []
+        for semiring in (0, 1, 2):
+            inf = SEMIRING_INF if semiring == 1 else -SEMIRING_INF
+            for view in (A, B):
+                view[:] = rng.integers(-1000, 1000, size=(n, n))
+                if semiring != 0:
+                    view[rng.random((n, n)) < 0.3] = inf
+            lib.matrixmultiply_semiring(n, matrices[0], matrices[1], matrices[2], semiring)
+            ok = np.array_equal(C, _semiring_reference(A, B, semiring))
+            results.append(f"{SEMIRING_NAMES[semiring]} {'正确' if ok else '错误'}")
+        print(f"  N={n}: " + ", ".join(results))
+        for m in matrices:
+            lib.free_matrix(m, n)
+    
+    matrixA = lib.create_matrix(N)
+    matrixB = lib.create_matrix(N)
+    matrixC = lib.create_matrix(N)
+    reference = lib.create_matrix(N)
+    viewC, viewRef = _c_matrix_view(matrixC, N), _c_matrix_view(reference, N)
+    rows = []
+    
+    # 单次乘法：稠密矩阵
+    for semiring in (0, 1, 2):
+        lib.init_graph_matrix(N, matrixA, 100, 1000, semiring, 1)
+        lib.init_graph_matrix(N, matrixB, 100, 1000, semiring, 2)
+        naive_time = best_time(lambda: lib.matrixmultiply_semiring_naive(N, matrixA, matrixB, reference, semiring),
+                               repeats)
+        simd_time = best_time(lambda: lib.matrixmultiply_semiring(N, matrixA, matrixB, matrixC, semiring), repeats)
+        ok = np.array_equal(viewC, viewRef)
+        for label, elapsed_time in (('标量三重循环', naive_time), ('分块SIMD多线程', simd_time)):
+            rows.append({'任务': f'{SEMIRING_NAMES[semiring]} 乘法', '实现': label,
+                         '执行时间(秒)': elapsed_time, 'GOPS': 2 * N ** 3 / elapsed_time / 1e9,
+                         '加速比': naive_time / elapsed_time, '验证': '正确' if ok else '错误'})
+    
+    # 全源最短路径（稀疏随机图）和最长路径（有向无环图）
+    for semiring, task in ((1, '全源最短路径'), (2, '全源最长路径(DAG)')):
+        lib.init_graph_matrix(N, matrixA, 5, 100, semiring, 3)
+        fw_time = best_time(lambda: lib.apsp_floyd_warshall(N, matrixA, reference, semiring), repeats)
+        squarings = lib.apsp_repeated_squaring(N, matrixA, matrixC, semiring)
+        rs_time = best_time(lambda: lib.apsp_repeated_squaring(N, matrixA, matrixC, semiring), repeats)
+        ok = np.array_equal(viewC, viewRef)
+        rows.append({'任务': task, '实现': 'Floyd-Warshall', '执行时间(秒)': fw_time,
+                     'GOPS': 2 * N ** 3 / fw_time / 1e9, '加速比': 1.0, '验证': '基准'})
+        rows.append({'任务': task, '实现': f'重复平方({squarings}次)', '执行时间(秒)': rs_time,
+                     'GOPS': 2 * N ** 3 * squarings / rs_time / 1e9, '加速比': fw_time / rs_time,
+                     '验证': '正确' if ok else '错误'})
+    
+    for matrix in (matrixA, matrixB, matrixC, reference):
+        lib.free_matrix(matrix, N)
+    
+    df = pd.DataFrame(rows)
+    df['执行时间(秒)'] = df['执行时间(秒)'].round(4)
+    df['GOPS'] = df['GOPS'].round(2)
+    df['加速比'] = df['加速比'].round(1)
+    
+    print("\n" + "=" * 60)
+    print(f"半环矩阵乘法对比（矩阵大小 {N}x{N}）")
+    print("=" * 60)
+    print(df.to_string(index=False))
+    
+    os.makedirs('results', exist_ok=True)
+    csv_path = os.path.join('results', 'semiring.csv')
+    df.to_csv(csv_path, index=False, encoding='utf-8-sig')
+    print(f"\n结果已保存到 {csv_path}")
+    return df
+
+
+def run_half_precision_benchmark(test_size, repeats=3):
+    """
+    16位浮点存储的精度与吞吐量：fp16 / bf16存储、float32累加的版本与float32版本（跨步接口）、
+    现有int版本（AVX2、综合优化）对比。浮点版本的误差相对于原始float32数据的float64乘积计算
+    """
+    from matrix_numpy import StridedMatrixLibrary, HalfPrecisionLibrary
+    
+    N = test_size
+    tester = MatrixMultiplyTester(N)
+    tester.compile_c_libraries()
+    if 'half' not in tester.dlls or 'strided' not in tester.dlls:
+        print("跳过16位浮点测试：half或strided库未加载")
+        return None
+    half = HalfPrecisionLibrary(tester.dlls['half']._name)
+    strided = StridedMatrixLibrary(tester.dlls['strided']._name)
+    
+    rows = []
+    flops = 2 * N ** 3
+    
+    # 现有int版本：结果是精确的（不溢出时）
+    int_kernels = [('simd', 'matrixmultiply_avx2', 'int AVX2'),
+                   ('optimized', 'matrixmultiply_ultimate', 'int 综合优化')]
+    for lib_name, func_name, label in int_kernels:
+        if lib_name not in tester.dlls:
+            continue
+        dll = tester.dlls[lib_name]
+        func = getattr(dll, func_name)
+        func.argtypes = [c_int, POINTER(POINTER(c_int)), POINTER(POINTER(c_int)), POINTER(POINTER(c_int))]
+        func.restype = None
+        matrices = [dll.create_matrix(N) for _ in range(3)]
+        dll.init_test_matrices(N, matrices[0], matrices[1])
+        elapsed_time = best_time(lambda: func(N, *matrices), repeats)
+        for matrix in matrices:
+            dll.free_matrix(matrix, N)
+        rows.append({'实现': label, '存储格式': 'int32', '操作数内存(MB)': 2 * N * N * 4 / 1048576,
+                     '执行时间(秒)': elapsed_time, 'GFLOPS': flops / elapsed_time / 1e9, '相对误差': 0.0})
+    
+    rng = np.random.default_rng(0)
+    A = rng.uniform(-1, 1, (N, N)).astype(np.float32)
+    B = rng.uniform(-1, 1, (N, N)).astype(np.float32)
+    reference = A.astype(np.float64) @ B.astype(np.float64)
+    ref_norm = np.linalg.norm(reference)
+    
+    C = np.empty((N, N), dtype=np.float32)
+    elapsed_time = best_time(lambda: strided.matmul(A, B, out=C), repeats)
+    rows.append({'实现': 'float32 FMA', '存储格式': 'float32', '操作数内存(MB)': 2 * N * N * 4 / 1048576,
+                 '执行时间(秒)': elapsed_time, 'GFLOPS': flops / elapsed_time / 1e9,
+                 '相对误差': np.linalg.norm(C - reference) / ref_norm})
+    
+    for fmt in ('fp16', 'bf16'):
+        start_time = time.perf_counter()
+        A16, B16 = half.to_half(A, fmt), half.to_half(B, fmt)
+        convert_time = time.perf_counter() - start_time
+        elapsed_time = best_time(lambda: half.matmul(A16, B16, fmt, out=C), repeats)
+        rows.append({'实现': f'{fmt}存储 + float32累加', '存储格式': fmt, '操作数内存(MB)': 2 * N * N * 2 / 1048576,
+                     '执行时间(秒)': elapsed_time, 'GFLOPS': flops / elapsed_time / 1e9,
+                     '相对误差': np.linalg.norm(C - reference) / ref_norm,
+                     '转换时间(秒)': convert_time})
+    
+    df = pd.DataFrame(rows)
+    df['执行时间(秒)'] = df['执行时间(秒)'].round(4)
+    df['GFLOPS'] = df['GFLOPS'].round(2)
+    df['操作数内存(MB)'] = df['操作数内存(MB)'].round(2)
+    
+    print("\n" + "=" * 60)
+    print(f"16位浮点存储：精度与吞吐量（矩阵大小 {N}x{N}）")
+    print("=" * 60)
+    print(df.to_string(index=False))
+    
+    os.makedirs('results', exist_ok=True)
+    csv_path = os.path.join('results', 'half_precision.csv')
+    df.to_csv(csv_path, index=False, encoding='utf-8-sig')
+    
+    report_path = os.path.join('results', 'half_precision_report.md')
+    with open(report_path, 'w', encoding='utf-8') as f:
+        f.write("# 16位浮点存储：精度与吞吐量\n\n")
+        f.write(f"矩阵大小: {N}x{N}。浮点输入为[-1, 1)内的均匀随机数，相对误差为 ||C - C_ref||_F / ||C_ref||_F，"
+                f"C_ref是原始float32数据的float64乘积；int版本的结果是精确的（int版本的GFLOPS按整数运算计）。\n\n")
+        f.write("| 实现 | 存储格式 | 操作数内存(MB) | 执行时间(秒) | GFLOPS | 相对误差 |\n")
+        f.write("|------|----------|----------------|--------------|--------|----------|\n")
+        for _, row in df.iterrows():
+            f.write(f"| {row['实现']} | {row['存储格式']} | {row['操作数内存(MB)']:.2f} | {row['执行时间(秒)']:.4f} | "
+                    f"{row['GFLOPS']:.2f} | {row['相对误差']:.2e} |\n")
+        f.write("\nfp16的尾数有10位，单个元素的舍入误差约为2^-11，但指数只有5位（最大65504）；"
+                "bf16与float32的指数范围相同，但尾数只有7位，误差约为2^-8。"
+                "两者都在打包时转换为float32，内层循环与float32版本相同，节省的是读取A、B的内存和带宽。\n")
+    print(f"\n结果已保存到 {csv_path} 和 {report_path}")
+    return df
+
+
+def run_auto_selection_benchmark(test_size, repeats=3):
+    """
+    自动选择入口：对不同形状比较代价模型选择的计划与每种固定计划（算法 x {1, 最大}线程）的实际时间，
+    检查自动选择是否接近最快的固定计划
+    """
+    tester = MatrixMultiplyTester(test_size)
+    tester.compile_c_libraries()
+    if 'auto' not in tester.dlls:
+        print("跳过自动选择测试：auto库未加载")
+        return None
+    dll = tester.dlls['auto']
+    
+    start_time = time.perf_counter()
+    dll.matrix_auto_calibrate(1)
+    print(f"\n校准耗时: {time.perf_counter() - start_time:.3f} 秒")
+    
+    max_threads = min(os.cpu_count() or 1, 8)
+    shapes = AUTO_SHAPES + [(test_size, test_size, test_size)]
+    rng = np.random.default_rng(0)
+    rows = []
+    for M, N, K in shapes:
+        A = rng.integers(-8, 8, (M, K), dtype=np.int32)
+        B = rng.integers(-8, 8, (K, N), dtype=np.int32)
+        C = np.empty((M, N), dtype=np.int32)
+        reference = A.astype(np.int64) @ B.astype(np.int64)
+        
+        def run(plan):
+            dll.matrixmultiply_auto_run(ctypes.byref(plan), M, N, K, 0, A.ctypes.data, K,
+                                        B.ctypes.data, N, C.ctypes.data, N, 0)
+        
+        fixed = {}
+        for algo, algo_name in enumerate(AUTO_ALGO_NAMES):
+            for threads in sorted({1, min(max_threads, M)}):
+                plan = MMAutoPlan(algo, threads, 256, 0.0)
+                fixed[f"{algo_name}/{threads}"] = best_time(lambda: run(plan), repeats)
+        
+        plan = MMAutoPlan()
+        dll.matrix_auto_plan(M, N, K, 0, ctypes.byref(plan))
+        auto_time = best_time(lambda: dll.matrixmultiply_auto_ex(M, N, K, 0, A.ctypes.data, K, B.ctypes.data, N,
+                                                                  C.ctypes.data, N, 0), repeats)
+        correct = np.array_equal(C, reference.astype(np.int32))
+        best_name = min(fixed, key=fixed.get)
+        
+        row = {'形状(MxNxK)': f"{M}x{N}x{K}",
+               '自动选择': f"{AUTO_ALGO_NAMES[plan.algo]}/{plan.threads} kc={plan.kc}",
+               '预测(秒)': plan.predicted_seconds, '自动(秒)': auto_time,
+               '最快固定计划': best_name, '最快(秒)': fixed[best_name],
+               '自动/最快': auto_time / fixed[best_name], '结果正确': correct}
+        for name, elapsed_time in fixed.items():
+            row[f"{name}(秒)"] = elapsed_time
+        rows.append(row)
+        print(f"{M}x{N}x{K}: 自动 {row['自动选择']} {auto_time:.6f}秒，最快 {best_name} {fixed[best_name]:.6f}秒")
+    
+    df = pd.DataFrame(rows)
+    
+    os.makedirs('results', exist_ok=True)
+    csv_path = os.path.join('results', 'auto_selection.csv')
+    df.to_csv(csv_path, index=False, encoding='utf-8-sig')
+    
+    report_path = os.path.join('results', 'auto_selection_report.md')
+    with open(report_path, 'w', encoding='utf-8') as f:
+        f.write("# 自动选择入口：代价模型的选择与固定计划对比\n\n")
+        f.write(f"int32矩阵，每个计划取{repeats}次中最短的时间。固定计划记为 算法/线程数，"
+                f"\"自动/最快\"接近1表示代价模型选中了（或接近）最快的计划。\n\n")
+        f.write("| 形状(MxNxK) | 自动选择 | 预测(秒) | 自动(秒) | 最快固定计划 | 最快(秒) | 自动/最快 | 结果正确 |\n")
+        f.write("|-------------|----------|----------|----------|--------------|----------|-----------|----------|\n")
+        for _, row in df.iterrows():
+            f.write(f"| {row['形状(MxNxK)']} | {row['自动选择']} | {row['预测(秒)']:.6f} | {row['自动(秒)']:.6f} | "
+                    f"{row['最快固定计划']} | {row['最快(秒)']:.6f} | {row['自动/最快']:.2f} | "
+                    f"{'是' if row['结果正确'] else '否'} |\n")
+        f.write("\n调试时可用环境变量 MATRIX_AUTO_ALGO、MATRIX_AUTO_THREADS、MATRIX_AUTO_KC 覆盖选择，"
+                "MATRIX_AUTO_VERBOSE=1 打印每次调用的计划。\n")
+    print(f"\n结果已保存到 {csv_path} 和 {report_path}")
+    return df
+
+
+def summarize_trace(path):
+    """
+    汇总Chrome trace JSON中每个工作线程的时间线：开始/结束时间、计算时间（rows事件）、
+    到join返回为止的等待时间，以及相对于整个调用的利用率
+    """
+    import json
+    with open(path, encoding='utf-8') as f:
+        events = [e for e in json.load(f)['traceEvents'] if e['ph'] == 'X']
+    
+    caller = [e for e in events if e['tid'] == 0]
+    join = [e for e in caller if e['name'] == 'join']
+    wall_start = min(e['ts'] for e in caller)
+    wall_end = max(e['ts'] + e['dur'] for e in join) if join else max(e['ts'] + e['dur'] for e in events)
+    wall = wall_end - wall_start
+    
+    rows = []
+    serial = sum(e['dur'] for e in caller if e['name'] in ('setup', 'spawn', 'pack'))
+    rows.append({'线程': 'caller', '行范围': '-', '开始(ms)': 0.0, '结束(ms)': wall / 1000,
+                 '计算(ms)': 0.0, '等待(ms)': sum(e['dur'] for e in join) / 1000,
+                 '串行准备(ms)': serial / 1000, '利用率': 0.0, '分块数': 0})
+    for tid in sorted({e['tid'] for e in events} - {0}):
+        thread = [e for e in events if e['tid'] == tid]
+        span = [e for e in thread if e['name'] == 'rows']
+        if not span:
+            continue
+        span = span[0]
+        tiles = [e for e in thread if e['name'] != 'rows']
+        end = span['ts'] + span['dur']
+        rows.append({'线程': f"worker {tid}", '行范围': f"{span['args']['start_row']}-{span['args']['end_row']}",
+                     '开始(ms)': (span['ts'] - wall_start) / 1000, '结束(ms)': (end - wall_start) / 1000,
+                     '计算(ms)': span['dur'] / 1000, '等待(ms)': (wall_end - end) / 1000,
+                     '串行准备(ms)': 0.0, '利用率': span['dur'] / wall, '分块数': len(tiles)})
+    return pd.DataFrame(rows), wall / 1000
+
+
+def run_trace_timeline(test_size):
+    """
+    记录综合优化版本（普通和预打包B）每个线程的执行时间线，写出Chrome trace JSON
+    （用 chrome://tracing 或 ui.perfetto.dev 打开），并汇总负载不均和空闲时间
+    """
+    tester = MatrixMultiplyTester(test_size)
+    tester.compile_c_libraries()
+    if 'optimized' not in tester.dlls:
+        print("跳过时间线追踪：optimized库未加载")
+        return None
+    dll = tester.dlls['optimized']
+    N = test_size
+    
+    os.makedirs('results', exist_ok=True)
+    matrixA, matrixB, matrixC = tester.create_test_matrices_c(dll)
+    packedB = dll.matrix_pack_B(N, matrixB, 1)
+    
+    traces = {
+        'ultimate': lambda: dll.matrixmultiply_ultimate(N, matrixA, matrixB, matrixC),
+        'ultimate_packed': lambda: dll.matrixmultiply_ultimate_packed(N, matrixA, packedB, matrixC, 0)
+    }
+    
+    report_path = os.path.join('results', 'trace_report.md')
+    with open(report_path, 'w', encoding='utf-8') as f:
+        f.write("# 执行时间线追踪\n\n")
+        f.write(f"矩阵大小: {N}x{N}。每个版本的完整时间线保存在 results/trace_<版本>.json，"
+                "可用 chrome://tracing 或 https://ui.perfetto.dev 打开。\n"
+                "等待时间是线程完成到join返回的时间，串行准备是调用线程在工作线程开始前的准备和创建线程时间。\n")
+        for name, run in traces.items():
+            run()  # 预热
+            trace_path = os.path.join('results', f'trace_{name}.json')
+            dll.matrix_trace_start()
+            run()
+            count = dll.matrix_trace_stop(trace_path.encode())
+            df, wall = summarize_trace(trace_path)
+            workers = df[df['线程'] != 'caller']
+            imbalance = workers['计算(ms)'].max() / workers['计算(ms)'].mean() if len(workers) else 1.0
+            
+            print("\n" + "=" * 60)
+            print(f"{name}: {count} 个事件写入 {trace_path}，总时间 {wall:.2f} ms，负载不均(最大/平均) {imbalance:.3f}")
+            print("=" * 60)
+            print(df.round(3).to_string(index=False))
+            
+            f.write(f"\n## {name}\n\n总时间 {wall:.2f} ms，负载不均(最大计算时间/平均) {imbalance:.3f}\n\n")
+            f.write("| 线程 | 行范围 | 开始(ms) | 结束(ms) | 计算(ms) | 等待(ms) | 串行准备(ms) | 利用率 | 分块数 |\n")
+            f.write("|------|--------|----------|----------|----------|----------|--------------|--------|--------|\n")
+            for _, row in df.iterrows():
+                f.write(f"| {row['线程']} | {row['行范围']} | {row['开始(ms)']:.3f} | {row['结束(ms)']:.3f} | "
+                        f"{row['计算(ms)']:.3f} | {row['等待(ms)']:.3f} | {row['串行准备(ms)']:.3f} | "
+                        f"{row['利用率'] * 100:.1f}% | {row['分块数']} |\n")
+    
+    dll.matrix_packed_free(packedB)
+    for matrix in (matrixA, matrixB, matrixC):
+        dll.free_matrix(matrix, N)
+    print(f"\n结果已保存到 {report_path}")
+
+
+def run_incremental_benchmark(test_size, repeats=3):
+    """
+    增量重新计算：A的少数行、B的少数列（调用者标记）或A的少数列、B的少数行（比较副本后低秩更新）变化时，
+    更新时间与变化量的关系，并与完整的matrixmultiply_ultimate对比。每一步都用float64 BLAS检查结果（输入很小，结果精确）
+    """
+    N = test_size
+    tester = MatrixMultiplyTester(N)
+    tester.compile_c_libraries()
+    if 'optimized' not in tester.dlls:
+        print("跳过增量重新计算测试：optimized库未加载")
+        return None
+    dll = tester.dlls['optimized']
+    
+    matrices = [dll.create_matrix(N) for _ in range(3)]
+    A, B, C = (_c_matrix_view(m, N) for m in matrices)
+    rng = np.random.default_rng(0)
+    A[:] = rng.integers(-8, 8, (N, N))
+    B[:] = rng.integers(-8, 8, (N, N))
+    
+    full_time = best_time(lambda: dll.matrixmultiply_ultimate(N, *matrices), repeats)
+    
+    inc = dll.matrix_incremental_create(N, *matrices)
+    mode_names = {0: '无变化', 1: '重算行/列', 2: '低秩更新', 3: '完整计算'}
+    # 场景：(名称, 是否由调用者标记, 修改函数)
+    scenarios = [
+        ('A的行（标记）', True, lambda s, d: A.__setitem__((slice(s, s + d), slice(None)), rng.integers(-8, 8, (d, N))),
+         lambda s, d: dll.matrix_incremental_mark(inc, 0, s, s + d)),
+        ('B的列（标记）', True, lambda s, d: B.__setitem__((slice(None), slice(s, s + d)), rng.integers(-8, 8, (N, d))),
+         lambda s, d: dll.matrix_incremental_mark(inc, 1, s, s + d)),
+        ('A的列（比较）', False, lambda s, d: A.__setitem__((slice(None), slice(s, s + d)), rng.integers(-8, 8, (N, d))),
+         None),
+        ('B的行（比较）', False, lambda s, d: B.__setitem__((slice(s, s + d), slice(None)), rng.integers(-8, 8, (d, N))),
+         None)
+    ]
+    changes = [d for d in (1, 4, 16, 64, 256) if 2 * d < N]
+    
+    rows = []
+    for name, marked, modify, mark in scenarios:
+        for d in changes:
+            start = int(rng.integers(0, N - d + 1))
+            modify(start, d)
+            if mark is not None:
+                mark(start, d)
+            start_time = time.perf_counter()
+            mode = dll.matrix_incremental_update(inc)
+            elapsed_time = time.perf_counter() - start_time
+            reference = A.astype(np.float64) @ B.astype(np.float64)
+            rows.append({'场景': name, '变化量': d, '变化比例': d / N, '方式': mode_names[mode],
+                         '更新时间(秒)': elapsed_time, '相对完整计算': elapsed_time / full_time,
+                         '结果正确': bool(np.array_equal(C, reference))})
+            print(f"{name} {d:4d}: {mode_names[mode]} {elapsed_time:.4f}秒 "
+                  f"({elapsed_time / full_time * 100:.2f}% 完整计算)，结果{'正确' if rows[-1]['结果正确'] else '错误'}")
+    
+    dll.matrix_incremental_free(inc)
+    for m in matrices:
+        dll.free_matrix(m, N)
+    
+    df = pd.DataFrame(rows)
+    os.makedirs('results', exist_ok=True)
+    csv_path = os.path.join('results', 'incremental.csv')
+    df.to_csv(csv_path, index=False, encoding='utf-8-sig')
+    
+    report_path = os.path.join('results', 'incremental_report.md')
+    with open(report_path, 'w', encoding='utf-8') as f:
+        f.write("# 增量重新计算\n\n")
+        f.write(f"矩阵大小: {N}x{N}，完整计算(matrixmultiply_ultimate)耗时 {full_time:.4f} 秒。"
+                "\"标记\"场景由调用者给出变化的行/列范围，\"比较\"场景由句柄与保存的副本比较得到变化位置"
+                "（A的列或B的行变化时采用低秩更新）。更新时间应与变化量成正比。\n\n")
+        f.write("| 场景 | 变化量 | 变化比例 | 方式 | 更新时间(秒) | 相对完整计算 | 结果正确 |\n")
+        f.write("|------|--------|----------|------|--------------|--------------|----------|\n")
+        for _, row in df.iterrows():
+            f.write(f"| {row['场景']} | {row['变化量']} | {row['变化比例']:.4f} | {row['方式']} | "
+                    f"{row['更新时间(秒)']:.4f} | {row['相对完整计算'] * 100:.2f}% | {'是' if row['结果正确'] else '否'} |\n")
+    print(f"\n结果已保存到 {csv_path} 和 {report_path}")
+    return df
+
+
+def run_verify_benchmark(test_size, repeats=3):
+    """
+    Freivalds结果校验：对每个C版本的结果做O(N²)校验，报告不同重复次数下校验时间占该版本乘法时间的比例；
+    再向结果注入单个元素的错误，统计检出率（任意误差几乎总能检出，误差为2^31时单次检出率约为1/2）
+    """
+    N = test_size
+    tester = MatrixMultiplyTester(N)
+    tester.compile_c_libraries()
+    if 'optimized' not in tester.dlls:
+        print("跳过结果校验测试：optimized库未加载")
+        return None
+    verifier = tester.dlls['optimized']
+    
+    rng = np.random.default_rng(0)
+    rows = []
+    print(f"\nFreivalds结果校验，矩阵大小: {N}x{N}")
+    for name, func_name in C_KERNELS.items():
+        if name not in tester.dlls:
+            continue
+        dll = tester.dlls[name]
+        # 各版本都用mm_alloc_matrix分配矩阵，布局相同，可以直接交给校验函数
+        matrices = [dll.create_matrix(N) for _ in range(3)]
+        A, B, C = (_c_matrix_view(m, N) for m in matrices)
+        A[:] = rng.integers(-100, 100, (N, N))
+        B[:] = rng.integers(-100, 100, (N, N))
+        kernel = getattr(dll, func_name)
+        kernel_time = best_time(lambda: kernel(N, *matrices), repeats)
+        
+        row = {'版本': name, '乘法时间(秒)': kernel_time}
+        for reps in VERIFY_REPS:
+            passed = verifier.matrix_verify_freivalds(N, *matrices, reps)
+            verify_time = best_time(lambda: verifier.matrix_verify_freivalds(N, *matrices, reps), repeats)
+            row[f'校验{reps}次(秒)'] = verify_time
+            row[f'校验{reps}次开销'] = verify_time / kernel_time
+            row['通过'] = bool(passed) if reps == VERIFY_REPS[0] else row['通过'] and bool(passed)
+        rows.append(row)
+        print(f"{name:12s} 乘法 {kernel_time:.4f}秒，" +
+              "，".join(f"校验{reps}次 {row[f'校验{reps}次开销'] * 100:.2f}%" for reps in VERIFY_REPS) +
+              f"，{'通过' if row['通过'] else '未通过'}")
+        for m in matrices:
+            dll.free_matrix(m, N)
+    
+    # 注入错误：每次随机选一个元素加上误差，统计单次和多次校验的检出率
+    matrices = [verifier.create_matrix(N) for _ in range(3)]
+    A, B, C = (_c_matrix_view(m, N) for m in matrices)
+    A[:] = rng.integers(-100, 100, (N, N))
+    B[:] = rng.integers(-100, 100, (N, N))
+    verifier.matrixmultiply_ultimate(N, *matrices)
+    detection = []
+    for error_name, error in (('任意误差', None), ('误差2^31', -2 ** 31)):
+        for reps in VERIFY_REPS:
+            detected = 0
+            for _ in range(VERIFY_TRIALS):
+                i, j = rng.integers(0, N, 2)
+                original = C[i, j]
+                delta = int(rng.integers(1, 2 ** 31)) if error is None else error
+                C[i, j] = np.int32(((int(original) + delta + 2 ** 31) % 2 ** 32) - 2 ** 31)
+                detected += verifier.matrix_verify_freivalds(N, *matrices, reps) == 0
+                C[i, j] = original
+            detection.append({'误差': error_name, '重复次数': reps, '检出率': detected / VERIFY_TRIALS,
+                              '理论漏检率上限': 0.5 ** reps})
+            print(f"{error_name} 校验{reps}次: 检出 {detected}/{VERIFY_TRIALS}")
+    for m in matrices:
+        verifier.free_matrix(m, N)
+    
+    df = pd.DataFrame(rows)
+    os.makedirs('results', exist_ok=True)
+    csv_path = os.path.join('results', 'verify.csv')
+    df.to_csv(csv_path, index=False, encoding='utf-8-sig')
+    
+    report_path = os.path.join('results', 'verify_report.md')
+    with open(report_path, 'w', encoding='utf-8') as f:
+        f.write("# Freivalds结果校验\n\n")
+        f.write(f"矩阵大小: {N}x{N}。校验比较 A(Br) 与 Cr，代价为O(N²)；重复r次的漏检率不超过2^-r。"
+                "开销为校验时间占该版本一次乘法时间的比例。\n\n")
+        f.write("| 版本 | 乘法时间(秒) | " + " | ".join(f"校验{reps}次开销" for reps in VERIFY_REPS) + " | 通过 |\n")
+        f.write("|------|--------------|" + "|".join("------" for _ in VERIFY_REPS) + "|------|\n")
+        for _, row in df.iterrows():
+            f.write(f"| {row['版本']} | {row['乘法时间(秒)']:.4f} | " +
+                    " | ".join(f"{row[f'校验{reps}次开销'] * 100:.2f}%" for reps in VERIFY_REPS) +
+                    f" | {'是' if row['通过'] else '否'} |\n")
+        f.write(f"\n## 注入错误的检出率（{VERIFY_TRIALS}次试验）\n\n")
+        f.write("| 误差 | 重复次数 | 检出率 | 理论漏检率上限 |\n")
+        f.write("|------|----------|--------|----------------|\n")
+        for row in detection:
+            f.write(f"| {row['误差']} | {row['重复次数']} | {row['检出率'] * 100:.1f}% | {row['理论漏检率上限']:.2e} |\n")
+    print(f"\n结果已保存到 {csv_path} 和 {report_path}")
+    return df
+
+
+def run_pgo_training(lib_dir, sizes):
+    """
+    PGO训练：在多个矩阵大小上运行插桩版本的库。
+    必须在独立进程中运行，进程退出时插桩库才会写出.gcda文件。
+    """
+    print(f"PGO训练: 库目录 {lib_dir}，矩阵大小 {sizes}")
+    for size in sizes:
+        tester = MatrixMultiplyTester(size)
+        tester.load_libraries(lib_dir)
+        for name, func_name in C_KERNELS.items():
+            if name in tester.dlls:
+                tester.test_c_version(name, func_name)
+
+
+def compare_build_variants(build_dir, test_size, repeats=3):
+    """对比普通构建、LTO和PGO+LTO构建下每个版本的性能"""
+    variants = ['plain', 'lto', 'pgo']
+    times = {}
+    
+    for variant in variants:
+        lib_dir = os.path.join(build_dir, variant)
+        print(f"\n测试构建变体: {variant} ({lib_dir})")
+        tester = MatrixMultiplyTester(test_size)
+        tester.load_libraries(lib_dir)
+        for name, func_name in C_KERNELS.items():
+            if name in tester.dlls:
+                times[(variant, name)] = tester.time_c_version(name, func_name, repeats)
+    
+    rows = []
+    for name in C_KERNELS:
+        plain_time = times.get(('plain', name))
+        if plain_time is None:
+            continue
+        row = {'实现版本': name, 'plain(秒)': f"{plain_time:.4f}"}
+        best_gain = 0.0
+        for variant in variants[1:]:
+            variant_time = times.get((variant, name))
+            if variant_time is None:
+                row[f'{variant}(秒)'] = '-'
+                row[f'{variant}提升'] = '-'
+                continue
+            gain = plain_time / variant_time - 1.0
+            best_gain = max(best_gain, gain)
+            row[f'{variant}(秒)'] = f"{variant_time:.4f}"
+            row[f'{variant}提升'] = f"{gain * 100:+.1f}%"
+        row['结论'] = '值得部署' if best_gain >= DEPLOY_GAIN_THRESHOLD else '收益不明显'
+        rows.append(row)
+    
+    df = pd.DataFrame(rows)
+    print("\n" + "=" * 60)
+    print(f"构建变体对比（矩阵大小 {test_size}x{test_size}，取{repeats}次最短时间）")
+    print("=" * 60)
+    print(df.to_string(index=False))
+    
+    os.makedirs('results', exist_ok=True)
+    csv_path = os.path.join('results', 'build_variants.csv')
+    df.to_csv(csv_path, index=False, encoding='utf-8-sig')
+    
+    report_path = os.path.join('results', 'build_variants_report.md')
+    with open(report_path, 'w', encoding='utf-8') as f:
+        f.write("# 构建变体性能对比报告\n\n")
+        f.write(f"测试时间: {time.strftime('%Y-%m-%d %H:%M:%S')}\n\n")
+        f.write(f"测试矩阵大小: {test_size}x{test_size}\n\n")
+        f.write("- plain: 与默认构建相同的编译选项\n")
+        f.write("- lto: 链接时优化(-flto)\n")
+        f.write("- pgo: 基于性能测试训练的PGO + LTO\n\n")
+        f.write(f"提升超过{DEPLOY_GAIN_THRESHOLD * 100:.0f}%时认为值得部署。\n\n")
+        f.write("| " + " | ".join(df.columns) + " |\n")
+        f.write("|" + "---|" * len(df.columns) + "\n")
+        for _, row in df.iterrows():
+            f.write("| " + " | ".join(str(v) for v in row) + " |\n")
+    
+    print(f"\n结果已保存到 {csv_path} 和 {report_path}")
+    return df
+
+
 def main():
     """主函数"""
+    import argparse
+    
+    parser = argparse.ArgumentParser(description="矩阵乘法性能测试程序")
+    parser.add_argument('--size', type=int, help="测试矩阵大小（不指定时交互输入）")
+    parser.add_argument('--train', metavar='LIB_DIR', help="PGO训练模式：运行指定目录下的插桩库")
+    parser.add_argument('--sizes', default='128,256,512', help="PGO训练使用的矩阵大小列表，逗号分隔")
+    parser.add_argument('--compare-builds', metavar='BUILD_DIR', help="对比普通/LTO/PGO构建变体")
+    parser.add_argument('--roofline', action='store_true', help="Roofline分析：测量本机峰值并定位各个版本")
+    parser.add_argument('--bitpacked', action='store_true', help="位压缩布尔/GF(2)矩阵乘法与int版本对比")
+    parser.add_argument('--semiring', action='store_true', help="半环(min-plus / max-plus)矩阵乘法与全源最短路径测试")
+    parser.add_argument('--half', action='store_true', help="fp16 / bf16存储的精度与吞吐量，与float32和int版本对比")
+    parser.add_argument('--incremental', action='store_true',
+                        help="增量重新计算：更新时间与A、B变化量的关系，与完整计算对比")
+    parser.add_argument('--trace', action='store_true',
+                        help="记录综合优化版本每个线程的执行时间线（Chrome trace / Perfetto JSON）")
+    parser.add_argument('--auto', action='store_true', help="自动选择入口：代价模型的选择与各固定计划对比")
+    parser.add_argument('--verify', action='store_true',
+                        help="Freivalds结果校验：各版本的校验开销与注入错误的检出率")
+    parser.add_argument('--padding-sweep', action='store_true',
+                        help="行间距填充扫描：比较2的幂附近(N-1, N, N+1)关闭/开启填充的性能")
+    parser.add_argument('--sweep-sizes', default=PADDING_SWEEP_SIZES, help="填充扫描使用的2的幂大小，逗号分隔")
+    parser.add_argument('--write-modes', action='store_true',
+                        help="检查各版本 *_ex 接口的覆盖、累加和流式存储写入模式")
+    parser.add_argument('--write-mode-sizes', default=WRITE_MODE_SIZES, help="写入模式检查使用的矩阵大小，逗号分隔")
+    args = parser.parse_args()
+    
+    if args.train:
+        run_pgo_training(args.train, [int(x) for x in args.sizes.split(',')])
+        return
+    
+    if args.compare_builds:
+        compare_build_variants(args.compare_builds, args.size or 1024)
+        return
+    
+    if args.padding_sweep:
+        run_padding_sweep([int(x) for x in args.sweep_sizes.split(',')])
+        return
+    
+    if args.write_modes:
+        df = run_write_mode_check([int(x) for x in args.write_mode_sizes.split(',')])
+        sys.exit(0 if (df['结果'] == '正确').all() else 1)
+    
+    if args.bitpacked:
+        run_bitpacked_benchmark(args.size or 1024)
+        return
+    
+    if args.semiring:
+        run_semiring_benchmark(args.size or 1024)
+        return
+    
+    if args.half:
+        run_half_precision_benchmark(args.size or 1024)
+        return
+    
+    if args.incremental:
+        run_incremental_benchmark(args.size or 1024)
+        return
+    
+    if args.trace:
+        run_trace_timeline(args.size or 1024)
+        return
+    
+    if args.auto:
+        run_auto_selection_benchmark(args.size or 1024)
+        return
+    
+    if args.verify:
+        run_verify_benchmark(args.size or 1024)
+        return
+    
+    if args.roofline:
+        tester = MatrixMultiplyTester(args.size or 1024)
+        tester.compile_c_libraries()
+        tester.run_roofline()
+        return
+    
     print("矩阵乘法性能测试程序")
     print("Author: ChavapaWLF")
     
-    # 根据系统性能调整测试大小
-    test_sizes = [512, 1024, 2048]
-    print(f"\n可选测试大小: {test_sizes}")
-    
-    try:
-        size_input = input("请输入测试矩阵大小 (默认1024): ").strip()
-        test_size = int(size_input) if size_input else 1024
-    except ValueError:
-        test_size = 1024
+    if args.size:
+        test_size = args.size
+    else:
+        # 根据系统性能调整测试大小
+        test_sizes = [512, 1024, 2048]
+        print(f"\n可选测试大小: {test_sizes}")
+        
+        try:
+            size_input = input("请输入测试矩阵大小 (默认1024): ").strip()
+            test_size = int(size_input) if size_input else 1024
+        except ValueError:
+            test_size = 1024
     
     print(f"使用测试大小: {test_size}")
     